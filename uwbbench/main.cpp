@@ -0,0 +1,841 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QPoint>
+#include <QtMath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include "rangeparser.h"
+#include "positionpipeline.h"
+#include "capturefile.h"
+#include "shmpublisher.h"
+#include "streammerger.h"
+
+// ==========================================
+// uwbbench: uwbserial 核心算法的离线基准测试
+// ==========================================
+
+namespace {
+
+// 单精度解算 (UWB_SOLVER_FLOAT) 时允许与双精度参考实现有更大偏差 (cm)
+const double kSolverTolerance = sizeof(SolverReal) < sizeof(double) ? 0.5 : 1e-3;
+
+// 固定种子的线性同余发生器, 保证每次运行数据一致
+struct Lcg {
+    quint32 state;
+    explicit Lcg(quint32 seed) : state(seed) {}
+    quint32 next() { state = state * 1664525u + 1013904223u; return state >> 8; }
+    int range(int lo, int hi) { return lo + int(next() % quint32(hi - lo + 1)); }
+};
+
+// 生成 AT+RANGE 报文: 每行随机 3~8 个有效槽位, 槽位号即基站 ID
+QVector<QByteArray> makeRangeLines(int tagCount, int lineCount, quint32 seed)
+{
+    Lcg rng(seed);
+    QVector<QByteArray> lines;
+    lines.reserve(lineCount);
+
+    for (int n = 0; n < lineCount; ++n) {
+        int used = rng.range(3, 8);
+        quint32 mask = 0;
+        for (int picked = 0; picked < used; ) {
+            quint32 bit = 1u << rng.range(0, 7);
+            if (mask & bit) continue;
+            mask |= bit;
+            ++picked;
+        }
+
+        QByteArray range, ancid;
+        for (int i = 0; i < 8; ++i) {
+            bool on = mask & (1u << i);
+            if (i) { range += ','; ancid += ','; }
+            range += QByteArray::number(on ? rng.range(50, 3000) : 0);
+            ancid += QByteArray::number(on ? i : -1);
+        }
+
+        lines.append("AT+RANGE=tid:" + QByteArray::number(n % tagCount)
+                     + ",mask:" + QByteArray::number(mask, 16)
+                     + ",seq:" + QByteArray::number(n & 0xff)
+                     + ",range:(" + range + "),ancid:(" + ancid + ")");
+    }
+    return lines;
+}
+
+// 单趟解析器引入前 MainWindow::processData 中的 QRegExp 解析流程
+bool legacyParse(const QByteArray &data, int &tagId, QVector<int> &rawRanges, QVector<int> &aidArr)
+{
+    QString strData = QString::fromLatin1(data).trimmed();
+    if (!strData.startsWith("AT+RANGE=")) return false;
+
+    QRegExp rxId("tid:(\\d+)");
+    if (rxId.indexIn(strData) != -1) {
+        tagId = rxId.cap(1).toInt();
+    } else {
+        return false;
+    }
+
+    rawRanges.clear();
+    aidArr.clear();
+
+    QRegExp rxRange("range:\\(([^)]+)\\)");
+    if (rxRange.indexIn(strData) != -1) {
+        QString rangeContent = rxRange.cap(1);
+        QStringList parts = rangeContent.split(',');
+        for (const QString &val : parts)
+            if (val.toInt()) rawRanges.append(val.toInt());
+    }
+
+    QRegExp rxAncid("ancid:\\(([^)]+)\\)");
+    if (rxAncid.indexIn(strData) != -1) {
+        QString ancidContent = rxAncid.cap(1);
+        QStringList parts = ancidContent.split(',');
+        for (const QString &val : parts)
+            if (val.toInt() + 1) aidArr.append(val.toInt());
+    }
+
+    return true;
+}
+
+void printResult(const char *name, qint64 nsecs, qint64 ops, const char *unit)
+{
+    double perOp = double(nsecs) / double(ops);
+    double rate = ops * 1e9 / double(nsecs);
+    printf("%-28s %10.1f ns/%s %14.0f %s/s\n", name, perOp, unit, rate, unit);
+}
+
+// ------------------------------------------
+// 解析器: QRegExp 旧实现 vs 单趟扫描
+// ------------------------------------------
+// 超长数字串 (损坏的行) 不能溢出, 所在槽位按无效值丢弃
+bool checkParserLimits()
+{
+    struct Case {
+        const char *line;
+        bool accepted;
+        int count;
+    };
+    const Case cases[] = {
+        { "AT+RANGE=tid:1,seq:5,range:(99999999999999999999,120,130),ancid:(0,1,2)", true, 2 },
+        { "AT+RANGE=tid:1,seq:5,range:(110,120,130),ancid:(0,4294967297,2)", true, 2 },
+        { "AT+RANGE=tid:1,seq:5,range:(999999999,120,130),ancid:(0,1,2)", true, 3 },
+        { "AT+RANGE=tid:12345678901,seq:5,range:(110,120,130),ancid:(0,1,2)", false, 0 }
+    };
+
+    for (const Case &c : cases) {
+        RangePacket packet;
+        bool ok = parseRangeLine(QByteArray(c.line), packet);
+        if (ok != c.accepted || (ok && packet.count != c.count)) {
+            printf("parser limit check failed: %s\n", c.line);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool benchParser(const QVector<QByteArray> &lines, int rounds)
+{
+    if (!checkParserLimits()) return false;
+
+    // 先校验两种实现结果一致
+    QVector<int> rawRanges, aidArr;
+    for (const QByteArray &line : lines) {
+        int tid = -1;
+        RangePacket packet;
+        if (!legacyParse(line, tid, rawRanges, aidArr) || !parseRangeLine(line, packet)) {
+            printf("parser mismatch (rejected): %s\n", line.constData());
+            return false;
+        }
+        bool same = tid == packet.tid && rawRanges.size() == packet.count && aidArr.size() == packet.count;
+        for (int i = 0; same && i < packet.count; ++i)
+            same = rawRanges[i] == packet.range[i] && aidArr[i] == packet.ancid[i];
+        if (!same) {
+            printf("parser mismatch: %s\n", line.constData());
+            return false;
+        }
+    }
+
+    qint64 sink = 0;
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (const QByteArray &line : lines) {
+            int tid = -1;
+            legacyParse(line, tid, rawRanges, aidArr);
+            sink += tid + aidArr.size();
+        }
+    }
+    qint64 legacyNs = timer.nsecsElapsed();
+
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (const QByteArray &line : lines) {
+            RangePacket packet;
+            parseRangeLine(line, packet);
+            sink += packet.tid + packet.count;
+        }
+    }
+    qint64 scanNs = timer.nsecsElapsed();
+
+    qint64 ops = qint64(lines.size()) * rounds;
+    printf("[parser] %d lines x %d rounds (checksum %lld)\n", lines.size(), rounds, sink);
+    printResult("  QRegExp (legacy)", legacyNs, ops, "line");
+    printResult("  parseRangeLine", scanNs, ops, "line");
+    printf("  speedup: %.1fx\n", double(legacyNs) / double(scanNs));
+    return true;
+}
+
+// ------------------------------------------
+// 数据集: 合成轨迹或录制文件
+// ------------------------------------------
+struct Sample {
+    QByteArray line;
+    qint64 timeNs;
+};
+
+// 默认基站布局: 20m x 15m 场地四周 8 个基站 (cm)
+QMap<int, QPoint> defaultAnchors()
+{
+    QMap<int, QPoint> anchors;
+    anchors[0] = QPoint(0, 0);
+    anchors[1] = QPoint(1000, 0);
+    anchors[2] = QPoint(2000, 0);
+    anchors[3] = QPoint(2000, 750);
+    anchors[4] = QPoint(2000, 1500);
+    anchors[5] = QPoint(1000, 1500);
+    anchors[6] = QPoint(0, 1500);
+    anchors[7] = QPoint(0, 750);
+    return anchors;
+}
+
+// "id:x:y,id:x:y,..." 形式的基站布局
+bool parseAnchors(const QString &spec, QMap<int, QPoint> &anchors)
+{
+    anchors.clear();
+    for (const QString &item : spec.split(',', QString::SkipEmptyParts)) {
+        QStringList f = item.split(':');
+        if (f.size() != 3) return false;
+        anchors[f[0].toInt()] = QPoint(f[1].toInt(), f[2].toInt());
+    }
+    return anchors.size() >= 3;
+}
+
+// 标签在场地内匀速运动并在边界反弹, 每个标签 10Hz 上报,
+// 每包随机 3~8 个基站, 测距带 ±15cm 噪声
+QVector<Sample> makeTrajectoryDataset(const QMap<int, QPoint> &anchors, int tagCount, int lineCount, quint32 seed)
+{
+    Lcg rng(seed);
+    QList<int> ids = anchors.keys();
+    while (ids.size() > RangePacket::MaxSlots) ids.removeLast();
+
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    for (int id : ids) {
+        minX = qMin(minX, anchors[id].x()); maxX = qMax(maxX, anchors[id].x());
+        minY = qMin(minY, anchors[id].y()); maxY = qMax(maxY, anchors[id].y());
+    }
+
+    struct Walker { double x, y, vx, vy; };
+    QVector<Walker> tags(tagCount);
+    for (Walker &t : tags) {
+        t.x = rng.range(minX, maxX);
+        t.y = rng.range(minY, maxY);
+        t.vx = rng.range(-150, 150);    // cm/s
+        t.vy = rng.range(-150, 150);
+    }
+
+    const qint64 stepNs = 100000000LL / tagCount;  // 所有标签合计 10Hz x N
+    QVector<Sample> samples;
+    samples.reserve(lineCount);
+
+    for (int n = 0; n < lineCount; ++n) {
+        int tid = n % tagCount;
+        Walker &t = tags[tid];
+        double dt = 0.1;
+        t.x += t.vx * dt; t.y += t.vy * dt;
+        if (t.x < minX || t.x > maxX) { t.vx = -t.vx; t.x = qBound(double(minX), t.x, double(maxX)); }
+        if (t.y < minY || t.y > maxY) { t.vy = -t.vy; t.y = qBound(double(minY), t.y, double(maxY)); }
+
+        int used = qMin(ids.size(), rng.range(3, 8));
+        quint32 mask = 0;
+        for (int picked = 0; picked < used; ) {
+            quint32 bit = 1u << rng.range(0, ids.size() - 1);
+            if (mask & bit) continue;
+            mask |= bit;
+            ++picked;
+        }
+
+        QByteArray range, ancid;
+        for (int i = 0; i < RangePacket::MaxSlots; ++i) {
+            bool on = i < ids.size() && (mask & (1u << i));
+            int r = 0;
+            if (on) {
+                QPoint a = anchors[ids[i]];
+                double noise = (rng.range(0, 30) + rng.range(0, 30)) / 2.0 - 15.0;
+                r = qMax(1, qRound(qSqrt((t.x - a.x()) * (t.x - a.x()) + (t.y - a.y()) * (t.y - a.y())) + noise));
+            }
+            if (i) { range += ','; ancid += ','; }
+            range += QByteArray::number(r);
+            ancid += QByteArray::number(on ? ids[i] : -1);
+        }
+
+        Sample sample;
+        sample.line = "AT+RANGE=tid:" + QByteArray::number(tid)
+                + ",mask:" + QByteArray::number(mask, 16)
+                + ",seq:" + QByteArray::number((n / tagCount) & 0xff)
+                + ",range:(" + range + "),ancid:(" + ancid + ")";
+        sample.timeNs = n * stepNs;
+        samples.append(sample);
+    }
+    return samples;
+}
+
+bool loadCapture(const QString &path, QVector<Sample> &samples)
+{
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        printf("cannot open capture %s: %s\n", qPrintable(path), qPrintable(reader.errorString()));
+        return false;
+    }
+
+    samples.clear();
+    samples.reserve(int(reader.recordCount()));
+    qint64 offset = reader.beginOffset();
+    CaptureReader::Record record;
+    while (reader.next(offset, record)) {
+        Sample sample;
+        sample.line = QByteArray(record.data, record.length);
+        sample.timeNs = record.timeNs;
+        samples.append(sample);
+    }
+    return true;
+}
+
+// ------------------------------------------
+// 延迟分布
+// ------------------------------------------
+qint64 percentile(QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    int idx = qMin(sorted.size() - 1, int(p * sorted.size()));
+    return sorted[idx];
+}
+
+void printLatency(const char *stage, QVector<qint64> &ns)
+{
+    std::sort(ns.begin(), ns.end());
+    printf("  %-10s p50 %7lld ns  p99 %7lld ns  p999 %7lld ns  max %8lld ns  (n=%d)\n",
+           stage, percentile(ns, 0.5), percentile(ns, 0.99), percentile(ns, 0.999),
+           ns.isEmpty() ? 0LL : ns.last(), ns.size());
+}
+
+// ------------------------------------------
+// 多串口合并: 其他串口的副本融合或按迟到丢弃, 同一串口的重发计入序号统计的重复包
+// ------------------------------------------
+bool checkMergerDuplicates()
+{
+    const qint64 ms = 1000000LL;
+    StreamMerger merger(20 * ms);
+    PositionPipeline pipeline;
+    QVector<TimedPacket> released;
+    int repeated = 0;
+
+    // 与引擎的合并定时器一样, 先放行到期的包再收下一包
+    auto push = [&](int seq, qint64 timeNs, int source) {
+        merger.release(timeNs, released);
+        RangePacket packet;
+        QByteArray line = "AT+RANGE=tid:7,mask:7,seq:" + QByteArray::number(seq)
+                + ",range:(100,200,300),ancid:(0,1,2)";
+        parseRangeLine(line, packet);
+        if (merger.push(packet, timeNs, source) == StreamMerger::Repeated) {
+            pipeline.countDuplicate(packet);
+            ++repeated;
+        }
+    };
+
+    // 10 Hz, 串口 0 与 1 都收到每一包; seq 4 与 seq 9 由串口 0 重发, seq 9 另由串口 2 迟到收到
+    for (int seq = 0; seq < 10; ++seq) {
+        push(seq, seq * 100 * ms, 0);
+        push(seq, seq * 100 * ms + 2 * ms, 1);
+        if (seq == 4) push(seq, seq * 100 * ms + 5 * ms, 0);
+    }
+    push(9, 950 * ms, 2);
+    push(9, 960 * ms, 0);
+    merger.releaseAll(released);
+
+    QVector<TagFix> fixes(released.size());
+    pipeline.processPackets(released.constData(), released.size(), fixes.data());
+    QVector<SeqStats> stats = pipeline.sequenceStats();
+
+    bool ok = released.size() == 10 && merger.fusedCount() == 10 && merger.lateCount() == 1 && repeated == 2
+            && stats.size() == 1 && stats[0].received == 10 && stats[0].duplicates == 2 && stats[0].outOfOrder == 0;
+    printf("[merge] released %d, fused %lld, late %lld, repeated %d, tracker duplicates %llu\n",
+           released.size(), merger.fusedCount(), merger.lateCount(), repeated,
+           stats.isEmpty() ? quint64(0) : stats[0].duplicates);
+    if (!ok) printf("[merge] FAILED: duplicate accounting mismatch\n");
+    return ok;
+}
+
+// ------------------------------------------
+// 定位流程: 解析 -> 解算 -> 滤波
+// ------------------------------------------
+void benchPipeline(const QVector<Sample> &samples, const QMap<int, QPoint> &anchors, int rounds,
+                   SolverMode mode, const char *modeName)
+{
+    PipelineSettings settings;
+    settings.solverMode = mode;
+    PositionPipeline pipeline;
+    pipeline.setConfig(PipelineConfigPtr(new PipelineConfig(anchors, settings)));
+
+    // 吞吐量: 不插桩, 与 PositionEngine 调用方式一致
+    qint64 lines = 0, fixes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        pipeline.reset();
+        for (const Sample &s : samples) {
+            TagFix fix;
+            ++lines;
+            if (pipeline.process(s.line.constData(), s.line.size(), s.timeNs, fix) && fix.status == TagFix::Ok)
+                ++fixes;
+        }
+    }
+    qint64 totalNs = timer.nsecsElapsed();
+
+    // 批量吞吐量: 每次交给 processBatch 一块, 模拟一次串口读取到多行
+    const int BlockLines = 256;
+    QVector<PipelineInput> inputs;
+    inputs.reserve(samples.size());
+    for (const Sample &s : samples) {
+        PipelineInput input = { s.line.constData(), s.line.size(), s.timeNs };
+        inputs.append(input);
+    }
+    QVector<TagFix> fixBlock(BlockLines);
+    qint64 batchFixes = 0;
+    timer.restart();
+    for (int r = 0; r < rounds; ++r) {
+        pipeline.reset();
+        for (int i = 0; i < inputs.size(); i += BlockLines) {
+            int n = pipeline.processBatch(inputs.constData() + i, qMin(BlockLines, inputs.size() - i), fixBlock.data());
+            for (int k = 0; k < n; ++k)
+                batchFixes += fixBlock[k].status == TagFix::Ok;
+        }
+    }
+    qint64 batchNs = timer.nsecsElapsed();
+
+    // 分阶段延迟: 单独一轮插桩
+    QVector<qint64> parseNs, solveNs, filterNs, totalStageNs;
+    parseNs.reserve(samples.size());
+    solveNs.reserve(samples.size());
+    filterNs.reserve(samples.size());
+    totalStageNs.reserve(samples.size());
+
+    pipeline.reset();
+    QElapsedTimer clock;
+    clock.start();
+    for (const Sample &s : samples) {
+        RangePacket packet;
+        TagFix fix;
+        double x, y;
+
+        qint64 t0 = clock.nsecsElapsed();
+        bool parsed = pipeline.parse(s.line.constData(), s.line.size(), packet);
+        qint64 t1 = clock.nsecsElapsed();
+        parseNs.append(t1 - t0);
+        if (!parsed) continue;
+
+        bool solved = pipeline.solve(packet, s.timeNs, fix, x, y);
+        qint64 t2 = clock.nsecsElapsed();
+        solveNs.append(t2 - t1);
+        if (!solved) continue;
+
+        pipeline.filter(x, y, fix);
+        qint64 t3 = clock.nsecsElapsed();
+        filterNs.append(t3 - t2);
+        totalStageNs.append(t3 - t0);
+    }
+
+    printf("[pipeline/%s] %d lines x %d rounds, %d anchors\n", modeName, samples.size(), rounds, anchors.size());
+    printResult("  lines", totalNs, lines, "line");
+    printResult("  fixes", totalNs, qMax<qint64>(1, fixes), "fix");
+    printResult("  lines (batched)", batchNs, lines, "line");
+    printResult("  fixes (batched)", batchNs, qMax<qint64>(1, batchFixes), "fix");
+    printLatency("parse", parseNs);
+    printLatency("solve", solveNs);
+    printLatency("filter", filterNs);
+    printLatency("total", totalStageNs);
+    if (mode == SolverRobust)
+        printf("  robust solves over budget: %lld\n", pipeline.robustTruncated());
+}
+
+// ------------------------------------------
+// 闭式解: 每包重建正规方程 vs 预计算伪逆缓存
+// ------------------------------------------
+// 解析数据集并查出基站坐标, 只保留可解算的报文
+QVector<RangeSet> makeRangeSets(const QVector<Sample> &samples, const QMap<int, QPoint> &anchors)
+{
+    QVector<RangeSet> sets;
+    sets.reserve(samples.size());
+    for (const Sample &s : samples) {
+        RangePacket packet;
+        if (!parseRangeLine(s.line, packet)) continue;
+        RangeSet set;
+        set.count = 0;
+        for (int i = 0; i < packet.count; ++i) {
+            auto it = anchors.constFind(packet.ancid[i]);
+            if (it == anchors.constEnd()) continue;
+            set.anchorId[set.count] = it.key();
+            set.x[set.count] = it.value().x();
+            set.y[set.count] = it.value().y();
+            set.r[set.count] = packet.range[i];
+            ++set.count;
+        }
+        if (set.count >= 3) sets.append(set);
+    }
+
+    return sets;
+}
+
+// 旧的闭式解实现 (运行期 n, 交换参考基站), 作为对比基准
+bool legacyCalculatePosition(const RangeSet &set, double &x, double &y)
+{
+    int n = set.count;
+    if (n < 3) return false;
+
+    double X[RangeSet::MaxAnchors], Y[RangeSet::MaxAnchors], R[RangeSet::MaxAnchors];
+    int bestIdx = 0;
+    double minRange = 999999;
+
+    for(int i = 0; i < n; ++i) {
+        X[i] = set.x[i];
+        Y[i] = set.y[i];
+        R[i] = set.r[i];
+        if (R[i] < minRange && R[i] > 0) {
+            minRange = R[i];
+            bestIdx = i;
+        }
+    }
+
+    if (bestIdx != n - 1) {
+        std::swap(X[bestIdx], X[n-1]);
+        std::swap(Y[bestIdx], Y[n-1]);
+        std::swap(R[bestIdx], R[n-1]);
+    }
+
+    double xn = X[n-1], yn = Y[n-1], rn = R[n-1];
+    double a11 = 0, a12 = 0, a22 = 0, b1 = 0, b2 = 0;
+
+    for (int i = 0; i < n - 1; ++i) {
+        double Ai_0 = 2.0 * (X[i] - xn);
+        double Ai_1 = 2.0 * (Y[i] - yn);
+        double bi_val = rn*rn - R[i]*R[i] + X[i]*X[i] - xn*xn + Y[i]*Y[i] - yn*yn;
+
+        a11 += Ai_0 * Ai_0;
+        a12 += Ai_0 * Ai_1;
+        a22 += Ai_1 * Ai_1;
+        b1 += Ai_0 * bi_val;
+        b2 += Ai_1 * bi_val;
+    }
+
+    double det = a11 * a22 - a12 * a12;
+    if (qAbs(det) < 1e-4) return false;
+
+    x = (a22 * b1 - a12 * b2) / det;
+    y = (a11 * b2 - a12 * b1) / det;
+    return true;
+}
+
+typedef bool (*SolveFn)(const RangeSet &, double &, double &);
+
+// 与旧实现对比结果, 返回最大偏差; 有无解判断不一致时返回 -1
+double compareSolver(const QVector<RangeSet> &sets, SolveFn fn)
+{
+    double maxDiff = 0;
+    for (const RangeSet &set : sets) {
+        double x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+        bool ok1 = legacyCalculatePosition(set, x1, y1);
+        bool ok2 = fn(set, x2, y2);
+        if (ok1 != ok2) return -1;
+        if (ok1) maxDiff = qMax(maxDiff, qMax(qAbs(x1 - x2), qAbs(y1 - y2)));
+    }
+    return maxDiff;
+}
+
+qint64 timeSolver(const QVector<RangeSet> &sets, int rounds, SolveFn fn, double &sink)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (const RangeSet &set : sets) {
+            double x, y;
+            if (fn(set, x, y)) sink += x + y;
+        }
+    }
+    return timer.nsecsElapsed();
+}
+
+// ------------------------------------------
+// 闭式解: 旧实现 vs 定长展开
+// ------------------------------------------
+bool benchSolver(const QVector<RangeSet> &sets, int rounds)
+{
+    struct Variant {
+        const char *name;
+        SolveFn fn;
+    };
+    const Variant variants[] = {
+        { "legacy (dynamic n)", &legacyCalculatePosition },
+        { "calculatePosition", &calculatePosition }
+    };
+
+    printf("[solver] %d range sets x %d rounds, %s precision\n", sets.size(), rounds,
+           sizeof(SolverReal) < sizeof(double) ? "single" : "double");
+
+    double sink = 0;
+    qint64 legacyNs = 0;
+    for (const Variant &v : variants) {
+        double maxDiff = compareSolver(sets, v.fn);
+        if (maxDiff < 0 || maxDiff > kSolverTolerance) {
+            printf("[solver] MISMATCH: %s differs from the legacy solver (max diff %.6f cm)\n", v.name, maxDiff);
+            return false;
+        }
+
+        qint64 ns = timeSolver(sets, rounds, v.fn, sink);
+        if (v.fn == &legacyCalculatePosition) legacyNs = ns;
+        printResult(QByteArray("  ").append(v.name).constData(), ns, qint64(sets.size()) * rounds, "fix");
+        printf("    %.1fx vs legacy, max diff %.2e cm\n", double(legacyNs) / double(ns), maxDiff);
+    }
+    printf("  (checksum %.0f)\n", sink);
+    return true;
+}
+
+// ------------------------------------------
+// 批量闭式解: SoA 布局, 各向量化实现对比
+// ------------------------------------------
+bool benchBatch(const QVector<RangeSet> &sets, int rounds)
+{
+    QVector<RangeBatch> batches;
+    for (const RangeSet &set : sets) {
+        if (batches.isEmpty() || batches.last().isFull()) batches.append(RangeBatch());
+        batches.last().append(set);
+    }
+
+    QVector<double> xs(sets.size()), ys(sets.size());
+    QVector<quint8> oks(sets.size());
+    printf("[batch] %d range sets in %d batches x %d rounds, best kernel %s\n",
+           sets.size(), batches.size(), rounds, batchKernelName(bestBatchKernel()));
+
+    qint64 scalarNs = 0;
+    for (int k = BatchKernelScalar; k <= BatchKernelAvx2; ++k) {
+        BatchKernel kernel = BatchKernel(k);
+        if (!isBatchKernelSupported(kernel)) {
+            printf("  %-24s not supported on this CPU\n", batchKernelName(kernel));
+            continue;
+        }
+
+        // 结果一致性: 与逐个 calculatePosition 对比
+        double maxDiff = 0;
+        for (int b = 0, base = 0; b < batches.size(); base += batches[b].size, ++b)
+            solveBatch(kernel, batches[b], xs.data() + base, ys.data() + base, oks.data() + base);
+        for (int i = 0; i < sets.size(); ++i) {
+            double x = 0, y = 0;
+            bool ok = calculatePosition(sets[i], x, y);
+            if (ok != bool(oks[i])) {
+                printf("[batch] MISMATCH (%s): set %d calculatePosition %d, batch %d\n", batchKernelName(kernel), i, ok, oks[i]);
+                return false;
+            }
+            if (ok) maxDiff = qMax(maxDiff, qMax(qAbs(x - xs[i]), qAbs(y - ys[i])));
+        }
+        if (maxDiff > kSolverTolerance) {
+            printf("[batch] MISMATCH (%s): max difference %.6f cm\n", batchKernelName(kernel), maxDiff);
+            return false;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; ++r) {
+            for (int b = 0, base = 0; b < batches.size(); base += batches[b].size, ++b)
+                solveBatch(kernel, batches[b], xs.data() + base, ys.data() + base, oks.data() + base);
+        }
+        qint64 ns = timer.nsecsElapsed();
+        if (kernel == BatchKernelScalar) scalarNs = ns;
+
+        qint64 ops = qint64(sets.size()) * rounds;
+        QByteArray name = QByteArray("  solveBatch/") + batchKernelName(kernel);
+        printResult(name.constData(), ns, ops, "fix");
+        printf("    %.0f fixes/ms, %.1fx vs scalar, max diff %.2e cm\n", double(ops) * 1e6 / double(ns),
+               double(scalarNs) / double(ns), maxDiff);
+    }
+
+    // 生产路径 (PositionPipeline::processPackets) 每批都要重新打包, 计入 append 的开销
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        int base = 0;
+        for (RangeBatch &batch : batches) {
+            int size = batch.size;
+            batch.clear();
+            for (int i = 0; i < size; ++i)
+                batch.append(sets[base + i]);
+            solveBatch(batch, xs.data() + base, ys.data() + base, oks.data() + base);
+            base += size;
+        }
+    }
+    printResult("  append + solveBatch", timer.nsecsElapsed(), qint64(sets.size()) * rounds, "fix");
+    return true;
+}
+
+// ------------------------------------------
+// 共享内存定位环: 写端与读端并发, 校验读到的事件没有撕裂
+// ------------------------------------------
+// 第 n 条事件的各字段都由 n 推出, 读端据此判断是否读到了半新半旧的数据
+UwbShm::Position makeShmEvent(quint64 n)
+{
+    UwbShm::Position position;
+    memset(&position, 0, sizeof(position));
+    position.tid = quint32(n % 64);
+    position.seq = quint32(n);
+    position.timeUs = qint64(n) * 3;
+    position.x = double(n);
+    position.y = -double(n);
+    position.vx = float(n & 0xffff);
+    position.vy = -float(n & 0xffff);
+    position.quality = quint8(n);
+    return position;
+}
+
+bool isShmEvent(const UwbShm::Position &position, quint64 n)
+{
+    UwbShm::Position expected = makeShmEvent(n);
+    return memcmp(&position, &expected, sizeof(position)) == 0;
+}
+
+bool checkShmRing(int rounds)
+{
+#ifdef _WIN32
+    Q_UNUSED(rounds);
+    printf("[shm] not supported on this platform\n");
+    return true;
+#else
+    QString name = QString("/uwbbench-%1").arg(QCoreApplication::applicationPid());
+    ShmPublisher publisher;
+    if (!publisher.open(name)) {
+        printf("[shm] %s\n", qPrintable(publisher.errorString()));
+        return false;
+    }
+    UwbShm::Reader reader;
+    if (!reader.open(name.toLocal8Bit().constData())) {
+        printf("[shm] cannot map %s\n", qPrintable(name));
+        return false;
+    }
+
+    // 写端不停地写满多圈, 读端跟不上时会在复制过程中被绕回覆盖
+    const quint64 total = quint64(UwbShm::EventCapacity) * 16 * quint64(rounds);
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (quint64 n = 0; n < total; ++n)
+            publisher.publish(makeShmEvent(n));
+        done.store(true, std::memory_order_release);
+    });
+
+    QVector<UwbShm::Position> buffer(4096);
+    quint64 cursor = 0, received = 0, lost = 0, torn = 0, tornSlots = 0;
+    for (;;) {
+        bool finished = done.load(std::memory_order_acquire);
+        // 读到的是连续的一段, 最后一条即第 cursor - 1 条
+        int n = reader.readEvents(cursor, buffer.data(), buffer.size(), &lost);
+        quint64 first = cursor - quint64(n);
+        for (int i = 0; i < n; ++i) {
+            if (!isShmEvent(buffer[i], first + quint64(i))) ++torn;
+        }
+        received += quint64(n);
+
+        UwbShm::Position position;
+        if (reader.latest(quint32(received % 64), position) && !isShmEvent(position, position.seq))
+            ++tornSlots;
+
+        if (finished && cursor == reader.eventHead()) break;
+    }
+    writer.join();
+
+    printf("[shm] %llu events, read %llu, lost %llu (overrun), torn %llu, torn slots %llu\n",
+           total, received, lost, torn, tornSlots);
+    if (torn || tornSlots || received + lost != total) {
+        printf("[shm] FAILED: reader saw inconsistent events\n");
+        return false;
+    }
+    return true;
+#endif
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("uwbbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offline benchmarks for the uwbserial positioning core.");
+    parser.addHelpOption();
+    QCommandLineOption optLines("lines", "Number of synthetic AT+RANGE lines.", "n", "20000");
+    QCommandLineOption optTags("tags", "Number of distinct tag IDs.", "n", "64");
+    QCommandLineOption optRounds("rounds", "Passes over the dataset per benchmark.", "n", "10");
+    QCommandLineOption optSuite("suite", "Comma separated suites to run: parser, solver, batch, pipeline, shm.", "names", "parser,solver,batch,pipeline,shm");
+    QCommandLineOption optCapture("capture", "Run the pipeline over a recorded .ucap file instead of synthetic data.", "file");
+    QCommandLineOption optAnchors("anchors", "Anchor layout as id:x:y,... in cm.", "spec");
+    parser.addOption(optLines);
+    parser.addOption(optTags);
+    parser.addOption(optRounds);
+    parser.addOption(optSuite);
+    parser.addOption(optCapture);
+    parser.addOption(optAnchors);
+    parser.process(app);
+
+    int lineCount = qMax(1, parser.value(optLines).toInt());
+    int tagCount = qMax(1, parser.value(optTags).toInt());
+    int rounds = qMax(1, parser.value(optRounds).toInt());
+
+    QStringList suites = parser.value(optSuite).split(',', QString::SkipEmptyParts);
+
+    QMap<int, QPoint> anchors = defaultAnchors();
+    if (parser.isSet(optAnchors) && !parseAnchors(parser.value(optAnchors), anchors)) {
+        printf("invalid --anchors, expected id:x:y,... with at least 3 anchors\n");
+        return 1;
+    }
+
+    if (suites.contains("parser")) {
+        QVector<QByteArray> lines = makeRangeLines(tagCount, lineCount, 12345u);
+        if (!benchParser(lines, rounds)) return 1;
+    }
+
+    if (suites.contains("pipeline") || suites.contains("solver") || suites.contains("batch")) {
+        QVector<Sample> samples;
+        if (parser.isSet(optCapture)) {
+            if (!loadCapture(parser.value(optCapture), samples)) return 1;
+        } else {
+            samples = makeTrajectoryDataset(anchors, tagCount, lineCount, 12345u);
+        }
+        if (suites.contains("solver") || suites.contains("batch")) {
+            QVector<RangeSet> sets = makeRangeSets(samples, anchors);
+            if (suites.contains("solver") && !benchSolver(sets, rounds)) return 1;
+            if (suites.contains("batch") && !benchBatch(sets, rounds)) return 1;
+        }
+        if (suites.contains("pipeline")) {
+            if (!checkMergerDuplicates()) return 1;
+            benchPipeline(samples, anchors, rounds, SolverClosedForm, "closed-form");
+            benchPipeline(samples, anchors, rounds, SolverGaussNewton, "gauss-newton");
+            benchPipeline(samples, anchors, rounds, SolverRobust, "robust");
+        }
+    }
+
+    if (suites.contains("shm") && !checkShmRing(rounds)) return 1;
+    return 0;
+}
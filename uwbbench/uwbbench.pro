@@ -0,0 +1,12 @@
+QT -= gui
+QT += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp
+
+include(../uwbserial/positioning.pri)
@@ -0,0 +1,513 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QPoint>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "rangeparser.h"
+#include "positionpipeline.h"
+
+// ==========================================
+// uwbeval: 各解算 x 滤波组合在带真值数据集上的精度与开销
+//
+// 数据集为 uwbsim --truth 输出的 CSV (见 uwbsim/main.cpp), 每行一包及发包时刻的真实位置。
+// 每个组合先完整跑一遍统计误差 (RMSE、CEP50/95、最大值、可用率), 再重复 --rounds 轮
+// 只计时与统计堆分配 (每轮从空的滤波状态开始, 与 uwbbench 的 pipeline 计时方式相同)。
+// 带滤波的组合与 PositionEngine 走同一入口: 每次交给 processBatch 一块行, 闭式解按 RangeBatch
+// 向量化解算, 迭代解算逐包解算。filter "none" 为未滤波的解算结果, 流水线没有不滤波的批量入口,
+// 按分阶段接口逐包调用 solve() (此时迭代解算没有上一次的输出可作初值, 每包都从闭式解开始)。
+// --json 输出的报告字段顺序固定、数值按固定精度取整, 便于不同版本之间直接 diff
+// ==========================================
+
+namespace {
+
+std::atomic<quint64> g_allocations(0);
+// 计时循环的结果写到这里, 防止被优化掉
+volatile double g_sink = 0;
+
+} // namespace
+
+// 堆分配计数: glibc 上替换 malloc 系列, Qt 容器与 operator new 都会计入;
+// 其他平台只能替换 operator new, Qt 容器直接调用 malloc 的分配统计不到
+#if defined(__GLIBC__) && !defined(UWBEVAL_NO_MALLOC_HOOK)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+static const char *const kAllocCounter = "malloc";
+#else
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+static const char *const kAllocCounter = "operator new";
+#endif
+
+namespace {
+
+struct Row {
+    qint64 timeNs;
+    int tid;
+    double x;           // 真实位置 (cm)
+    double y;
+    bool nlos;          // 该包至少一个测距带非视距偏差
+    QByteArray line;
+};
+
+struct Dataset {
+    QString name;
+    QMap<int, QPoint> anchors;
+    QVector<Row> rows;
+    int tags;
+    int nlosRows;
+};
+
+struct Result {
+    QString solver;
+    QString filter;
+    QString path;           // "batch": processBatch, "stage": 分阶段接口
+    qint64 fixes;
+    double availability;    // 解出位置的包 / 全部包
+    double rmse;
+    double mean;
+    double cep50;
+    double cep95;
+    double max;
+    double nsPerFix;
+    double allocsPerFix;
+    qint64 robustTruncated;
+};
+
+struct SolverName {
+    const char *name;
+    SolverMode mode;
+};
+
+const SolverName kSolvers[] = {
+    { "closed_form", SolverClosedForm },
+    { "gauss_newton", SolverGaussNewton },
+    { "robust", SolverRobust }
+};
+
+// mode < 0 表示不滤波
+struct FilterName {
+    const char *name;
+    int mode;
+};
+
+const FilterName kFilters[] = {
+    { "none", -1 },
+    { "ema", FilterEma },
+    { "kalman", FilterKalman }
+};
+
+// "id:x:y,id:x:y,..." 形式的基站布局
+bool parseAnchors(const QString &spec, QMap<int, QPoint> &anchors)
+{
+    anchors.clear();
+    for (const QString &item : spec.split(',', QString::SkipEmptyParts)) {
+        QStringList f = item.split(':');
+        if (f.size() != 3) return false;
+        anchors[f[0].toInt()] = QPoint(qRound(f[1].toDouble()), qRound(f[2].toDouble()));
+    }
+    return anchors.size() >= 3;
+}
+
+// time_ns,tid,seq,x,y,nlos,line; line 含逗号, 取第 6 个逗号之后的全部
+bool loadDataset(const QString &path, const QMap<int, QPoint> &fallbackAnchors, Dataset &dataset)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        printf("cannot open %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+
+    dataset.name = QFileInfo(path).fileName();
+    dataset.anchors.clear();
+    dataset.rows.clear();
+    dataset.nlosRows = 0;
+    QSet<int> tags;
+
+    int lineNo = 0;
+    while (!file.atEnd()) {
+        QByteArray text = file.readLine();
+        ++lineNo;
+        while (text.endsWith('\n') || text.endsWith('\r')) text.chop(1);
+        if (text.isEmpty()) continue;
+
+        if (text.startsWith("# anchors ")) {
+            if (!parseAnchors(QString::fromLatin1(text.mid(10)), dataset.anchors)) {
+                printf("%s:%d: invalid anchor list\n", qPrintable(path), lineNo);
+                return false;
+            }
+            continue;
+        }
+        if (text.startsWith('#') || text.startsWith("time_ns,")) continue;
+
+        int fields[6];
+        int pos = -1;
+        for (int i = 0; i < 6; ++i) {
+            pos = text.indexOf(',', pos + 1);
+            if (pos < 0) {
+                printf("%s:%d: expected time_ns,tid,seq,x,y,nlos,line\n", qPrintable(path), lineNo);
+                return false;
+            }
+            fields[i] = pos;
+        }
+
+        Row row;
+        row.timeNs = text.left(fields[0]).toLongLong();
+        row.tid = text.mid(fields[0] + 1, fields[1] - fields[0] - 1).toInt();
+        row.x = text.mid(fields[2] + 1, fields[3] - fields[2] - 1).toDouble();
+        row.y = text.mid(fields[3] + 1, fields[4] - fields[3] - 1).toDouble();
+        row.nlos = text.mid(fields[4] + 1, fields[5] - fields[4] - 1).toUInt(nullptr, 16) != 0;
+        row.line = text.mid(fields[5] + 1);
+        dataset.rows.append(row);
+        dataset.nlosRows += row.nlos;
+        tags.insert(row.tid);
+    }
+
+    if (dataset.anchors.isEmpty()) dataset.anchors = fallbackAnchors;
+    if (dataset.anchors.size() < 3) {
+        printf("%s: no anchor layout, pass --anchors\n", qPrintable(path));
+        return false;
+    }
+    dataset.tags = tags.size();
+    return true;
+}
+
+// 第 p 分位 (最近秩), sorted 为升序
+double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    int idx = qBound(0, int(qCeil(p * sorted.size())) - 1, sorted.size() - 1);
+    return sorted[idx];
+}
+
+// 每次交给 processBatch 的行数, 与 uwbbench 的批量计时相同
+const int kBlockLines = 256;
+
+// 不滤波: 解析 -> 解算; 返回 false 表示没有位置
+inline bool runOne(PositionPipeline &pipeline, const Row &row, double &x, double &y)
+{
+    RangePacket packet;
+    TagFix fix;
+    if (!pipeline.parse(row.line.constData(), row.line.size(), packet)) return false;
+    return pipeline.solve(packet, row.timeNs, fix, x, y);
+}
+
+// 滤波: rows[first, first + count) 交给 processBatch, 对每个解出位置的结果调用 onFix(row, fix)。
+// inputs 与 fixes 至少 kBlockLines 项, 由调用方预先分配
+template<typename OnFix>
+void runBlock(PositionPipeline &pipeline, const QVector<Row> &rows, int first, int count,
+              PipelineInput *inputs, TagFix *fixes, OnFix onFix)
+{
+    for (int i = 0; i < count; ++i) {
+        const Row &row = rows[first + i];
+        PipelineInput input = { row.line.constData(), row.line.size(), row.timeNs };
+        inputs[i] = input;
+    }
+    int produced = pipeline.processBatch(inputs, count, fixes);
+
+    // 结果与输入同序, 无效行不产生结果; 按 (tid, 时间) 找回对应的行
+    int row = first, end = first + count;
+    for (int k = 0; k < produced; ++k) {
+        const TagFix &fix = fixes[k];
+        while (row < end && (rows[row].tid != fix.tid || rows[row].timeNs != fix.timestampNs)) ++row;
+        if (row == end) break;
+        if (fix.status == TagFix::Ok) onFix(rows[row], fix);
+        ++row;
+    }
+}
+
+Result evaluate(const Dataset &dataset, const SolverName &solver, const FilterName &filter,
+                const PipelineSettings &base, int rounds)
+{
+    PipelineSettings settings = base;
+    settings.solverMode = solver.mode;
+    bool filtered = filter.mode >= 0;
+    if (filtered) settings.filterMode = FilterMode(filter.mode);
+
+    PositionPipeline pipeline;
+    pipeline.setConfig(PipelineConfigPtr(new PipelineConfig(dataset.anchors, settings)));
+
+    Result result;
+    result.solver = solver.name;
+    result.filter = filter.name;
+    result.path = filtered ? "batch" : "stage";
+
+    const QVector<Row> &rows = dataset.rows;
+    QVector<PipelineInput> inputs(kBlockLines);
+    QVector<TagFix> fixes(kBlockLines);
+
+    // 1. 精度
+    QVector<double> errors;
+    errors.reserve(rows.size());
+    double sumSq = 0, sum = 0;
+    auto addError = [&](const Row &row, double x, double y) {
+        double dx = x - row.x;
+        double dy = y - row.y;
+        double err = qSqrt(dx * dx + dy * dy);
+        errors.append(err);
+        sumSq += err * err;
+        sum += err;
+    };
+    if (filtered) {
+        for (int first = 0; first < rows.size(); first += kBlockLines) {
+            runBlock(pipeline, rows, first, qMin(kBlockLines, rows.size() - first), inputs.data(), fixes.data(),
+                     [&](const Row &row, const TagFix &fix){ addError(row, fix.x, fix.y); });
+        }
+    } else {
+        for (const Row &row : rows) {
+            double x, y;
+            if (runOne(pipeline, row, x, y)) addError(row, x, y);
+        }
+    }
+    std::sort(errors.begin(), errors.end());
+
+    result.fixes = errors.size();
+    result.availability = rows.isEmpty() ? 0.0 : double(errors.size()) / rows.size();
+    result.rmse = errors.isEmpty() ? 0.0 : qSqrt(sumSq / errors.size());
+    result.mean = errors.isEmpty() ? 0.0 : sum / errors.size();
+    result.cep50 = percentile(errors, 0.50);
+    result.cep95 = percentile(errors, 0.95);
+    result.max = errors.isEmpty() ? 0.0 : errors.last();
+    result.robustTruncated = pipeline.robustTruncated();
+
+    // 2. 开销: 不算误差, 每轮从空状态开始; 新标签首次出现时的分配摊入每次解算
+    qint64 timedFixes = 0;
+    double sink = 0;
+    quint64 allocBefore = g_allocations.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r) {
+        pipeline.reset();
+        if (filtered) {
+            for (int first = 0; first < rows.size(); first += kBlockLines) {
+                runBlock(pipeline, rows, first, qMin(kBlockLines, rows.size() - first), inputs.data(), fixes.data(),
+                         [&](const Row &, const TagFix &fix){ sink += fix.x + fix.y; ++timedFixes; });
+            }
+        } else {
+            for (const Row &row : rows) {
+                double x, y;
+                if (runOne(pipeline, row, x, y)) {
+                    sink += x + y;
+                    ++timedFixes;
+                }
+            }
+        }
+    }
+    qint64 ns = timer.nsecsElapsed();
+    quint64 allocs = g_allocations.load(std::memory_order_relaxed) - allocBefore;
+
+    g_sink = sink;
+
+    result.nsPerFix = timedFixes ? double(ns) / timedFixes : 0.0;
+    result.allocsPerFix = timedFixes ? double(allocs) / timedFixes : 0.0;
+    return result;
+}
+
+// 报告中的数值按固定小数位取整, 避免无意义的末位差异
+double rounded(double v, int decimals)
+{
+    double scale = qPow(10.0, decimals);
+    return qRound64(v * scale) / scale;
+}
+
+QJsonObject settingsJson(const PipelineSettings &settings)
+{
+    QJsonObject o;
+    o["max_iterations"] = settings.maxIterations;
+    o["robust_threshold_cm"] = settings.robustThreshold;
+    o["robust_budget_us"] = settings.robustBudgetUs;
+    o["ema_threshold_cm"] = settings.threshold;
+    o["kalman_process_noise"] = settings.processNoise;
+    o["kalman_measurement_noise"] = settings.measurementNoise;
+    return o;
+}
+
+QJsonObject resultJson(const Result &r)
+{
+    QJsonObject o;
+    o["solver"] = r.solver;
+    o["filter"] = r.filter;
+    o["path"] = r.path;
+    o["fixes"] = double(r.fixes);
+    o["availability"] = rounded(r.availability, 4);
+    o["rmse_cm"] = rounded(r.rmse, 2);
+    o["mean_cm"] = rounded(r.mean, 2);
+    o["cep50_cm"] = rounded(r.cep50, 2);
+    o["cep95_cm"] = rounded(r.cep95, 2);
+    o["max_cm"] = rounded(r.max, 2);
+    o["ns_per_fix"] = rounded(r.nsPerFix, 0);
+    o["allocs_per_fix"] = rounded(r.allocsPerFix, 3);
+    if (r.solver == "robust") o["robust_over_budget"] = double(r.robustTruncated);
+    return o;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("uwbeval");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Accuracy and cost of each solver/filter combination on ground-truth datasets.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("datasets", "uwbsim --truth CSV files.", "<dataset.csv>...");
+    QCommandLineOption optSolvers("solvers", "Comma separated solvers: closed_form, gauss_newton, robust.", "names",
+                                  "closed_form,gauss_newton,robust");
+    QCommandLineOption optFilters("filters", "Comma separated filters: none, ema, kalman.", "names", "none,ema,kalman");
+    QCommandLineOption optRounds("rounds", "Timed passes over each dataset.", "n", "5");
+    QCommandLineOption optAnchors("anchors", "Anchor layout (id:x:y,... in cm) for datasets without an anchors line.", "spec");
+    QCommandLineOption optJson("json", "Write the report as JSON to this file (- for stdout).", "file");
+    parser.addOption(optSolvers);
+    parser.addOption(optFilters);
+    parser.addOption(optRounds);
+    parser.addOption(optAnchors);
+    parser.addOption(optJson);
+    parser.process(app);
+
+    const QStringList paths = parser.positionalArguments();
+    if (paths.isEmpty()) {
+        printf("no dataset given; generate one with: uwbsim --offline --duration 60 --truth data.csv\n");
+        return 1;
+    }
+
+    QVector<SolverName> solvers;
+    for (const QString &name : parser.value(optSolvers).split(',', QString::SkipEmptyParts)) {
+        auto it = std::find_if(std::begin(kSolvers), std::end(kSolvers), [&](const SolverName &s){ return name == s.name; });
+        if (it == std::end(kSolvers)) {
+            printf("unknown solver %s\n", qPrintable(name));
+            return 1;
+        }
+        solvers.append(*it);
+    }
+    QVector<FilterName> filters;
+    for (const QString &name : parser.value(optFilters).split(',', QString::SkipEmptyParts)) {
+        auto it = std::find_if(std::begin(kFilters), std::end(kFilters), [&](const FilterName &f){ return name == f.name; });
+        if (it == std::end(kFilters)) {
+            printf("unknown filter %s\n", qPrintable(name));
+            return 1;
+        }
+        filters.append(*it);
+    }
+
+    QMap<int, QPoint> fallbackAnchors;
+    if (parser.isSet(optAnchors) && !parseAnchors(parser.value(optAnchors), fallbackAnchors)) {
+        printf("invalid --anchors, expected id:x:y,... with at least 3 anchors\n");
+        return 1;
+    }
+
+    int rounds = qMax(1, parser.value(optRounds).toInt());
+    QString jsonPath = parser.value(optJson);
+    // JSON 写到标准输出时表格改写到标准错误
+    FILE *table = jsonPath == "-" ? stderr : stdout;
+    PipelineSettings base;
+
+    QJsonArray datasetsJson;
+    for (const QString &path : paths) {
+        Dataset dataset;
+        if (!loadDataset(path, fallbackAnchors, dataset)) return 1;
+
+        fprintf(table, "[%s] %d lines, %d tags, %d anchors, %d lines with NLOS ranges\n", qPrintable(dataset.name),
+                dataset.rows.size(), dataset.tags, dataset.anchors.size(), dataset.nlosRows);
+        fprintf(table, "  %-13s %-7s %6s %8s %8s %8s %8s %8s %9s %10s\n", "solver", "filter", "avail",
+                "rmse", "mean", "cep50", "cep95", "max", "ns/fix", "allocs/fix");
+
+        QJsonArray resultsJson;
+        for (const SolverName &solver : solvers) {
+            for (const FilterName &filter : filters) {
+                Result r = evaluate(dataset, solver, filter, base, rounds);
+                fprintf(table, "  %-13s %-7s %5.1f%% %8.1f %8.1f %8.1f %8.1f %8.1f %9.0f %10.3f\n",
+                        solver.name, filter.name, r.availability * 100, r.rmse, r.mean, r.cep50, r.cep95, r.max,
+                        r.nsPerFix, r.allocsPerFix);
+                resultsJson.append(resultJson(r));
+            }
+        }
+
+        QJsonObject datasetJson;
+        datasetJson["name"] = dataset.name;
+        datasetJson["lines"] = dataset.rows.size();
+        datasetJson["tags"] = dataset.tags;
+        datasetJson["anchors"] = dataset.anchors.size();
+        datasetJson["nlos_lines"] = dataset.nlosRows;
+        datasetJson["results"] = resultsJson;
+        datasetsJson.append(datasetJson);
+    }
+
+    if (jsonPath.isEmpty()) return 0;
+
+    QJsonObject report;
+    report["tool"] = "uwbeval";
+    report["format"] = 1;
+    report["rounds"] = rounds;
+    report["alloc_counter"] = kAllocCounter;
+    report["solver_float"] = sizeof(SolverReal) < sizeof(double);
+    report["settings"] = settingsJson(base);
+    report["datasets"] = datasetsJson;
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (jsonPath == "-") {
+        fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        return 0;
+    }
+    QFile file(jsonPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        printf("cannot write %s: %s\n", qPrintable(jsonPath), qPrintable(file.errorString()));
+        return 1;
+    }
+    return 0;
+}
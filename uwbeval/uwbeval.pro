@@ -0,0 +1,15 @@
+QT -= gui
+QT += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# glibc 上通过替换 malloc 统计分配次数 (含 Qt 容器); 与内存检查工具冲突时可关闭, 改为只统计 operator new
+# DEFINES += UWBEVAL_NO_MALLOC_HOOK
+
+SOURCES += \
+    main.cpp
+
+include(../uwbserial/positioning.pri)
@@ -0,0 +1,200 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QNetworkDatagram>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <cstdio>
+#include <cstring>
+#include "feedformat.h"
+
+// ==========================================
+// uwbfeed: uwbserial 定位发布的命令行订阅端
+// 打印收到的记录, 或每秒输出一次统计 (速率、丢批、发布端报告的丢弃、时延),
+// 可在本机回环上验证 UDP/TCP 发布
+// ==========================================
+
+namespace {
+
+struct Stats {
+    qint64 records;
+    qint64 batches;
+    qint64 lostBatches;     // UDP 批次序号不连续
+    qint64 dropped;         // 发布端因订阅者过慢丢弃的记录
+    qint64 badPackets;
+    qint64 latencySumUs;
+    qint64 latencyMaxUs;
+    bool haveSeq;
+    quint32 nextSeq;
+
+    Stats() { reset(); haveSeq = false; nextSeq = 0; }
+    void reset()
+    {
+        records = batches = lostBatches = dropped = badPackets = 0;
+        latencySumUs = latencyMaxUs = 0;
+    }
+};
+
+bool splitHostPort(const QString &spec, QString &host, quint16 &port)
+{
+    int colon = spec.lastIndexOf(':');
+    if (colon <= 0) return false;
+    host = spec.left(colon);
+    port = quint16(spec.mid(colon + 1).toUInt());
+    return port != 0;
+}
+
+// 处理一批, 返回批次占用的字节数; 数据不完整返回 0, 格式错误返回 -1
+int handleBatch(const uchar *data, int size, bool printRecords, Stats &stats)
+{
+    if (size < Feed::HeaderSize) return 0;
+
+    FeedHeader header;
+    if (!decodeFeedHeader(data, size, header)) {
+        if (memcmp(data, Feed::Magic, 4) != 0 || header.recordSize < Feed::RecordSize) return -1;
+        return 0;
+    }
+
+    if (stats.haveSeq && header.batchSeq != stats.nextSeq)
+        stats.lostBatches += qint64(quint32(header.batchSeq - stats.nextSeq));
+    stats.haveSeq = true;
+    stats.nextSeq = header.batchSeq + 1;
+    ++stats.batches;
+    stats.dropped += header.dropped;
+
+    qint64 nowUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+    FeedRecord record;
+    for (int i = 0; i < header.count; ++i) {
+        decodeFeedRecord(data, header, i, record);
+        qint64 latency = nowUs - record.timeUs;
+        stats.latencySumUs += latency;
+        stats.latencyMaxUs = qMax(stats.latencyMaxUs, latency);
+
+        if (printRecords) {
+            printf("%lld tid %u seq %u x %.1f y %.1f v %d,%d status %u q %u\n",
+                   (long long)record.timeUs, record.tid, record.seq, record.x, record.y,
+                   record.vx, record.vy, record.status, record.quality);
+        }
+    }
+    stats.records += header.count;
+    return Feed::HeaderSize + header.count * header.recordSize;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("uwbfeed");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Subscribe to the uwbserial position feed.");
+    parser.addHelpOption();
+    QCommandLineOption optUdp("udp", "Receive UDP on group:port (multicast) or address:port (unicast).", "target");
+    QCommandLineOption optTcp("tcp", "Connect to the TCP feed at host:port.", "target");
+    QCommandLineOption optStats("stats", "Print one summary line per second instead of every record.");
+    QCommandLineOption optSlow("slow", "Read the TCP stream only every n ms, to exercise slow-subscriber handling.", "ms", "0");
+    parser.addOption(optUdp);
+    parser.addOption(optTcp);
+    parser.addOption(optStats);
+    parser.addOption(optSlow);
+    parser.process(app);
+
+    bool printRecords = !parser.isSet(optStats);
+    Stats stats;
+    QString host;
+    quint16 port = 0;
+
+    QUdpSocket udp;
+    QTcpSocket tcp;
+    QByteArray tcpBuffer;
+    QTimer slowTimer;
+
+    if (parser.isSet(optUdp)) {
+        if (!splitHostPort(parser.value(optUdp), host, port)) {
+            printf("invalid --udp, expected address:port\n");
+            return 1;
+        }
+        QHostAddress group(host);
+        QHostAddress bindAddress = group.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4;
+        if (!udp.bind(bindAddress, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+            printf("cannot bind UDP port %u: %s\n", port, qPrintable(udp.errorString()));
+            return 1;
+        }
+        if (group.isMulticast() && !udp.joinMulticastGroup(group)) {
+            printf("cannot join %s: %s\n", qPrintable(host), qPrintable(udp.errorString()));
+            return 1;
+        }
+        QObject::connect(&udp, &QUdpSocket::readyRead, [&](){
+            while (udp.hasPendingDatagrams()) {
+                QNetworkDatagram datagram = udp.receiveDatagram();
+                QByteArray data = datagram.data();
+                if (handleBatch(reinterpret_cast<const uchar *>(data.constData()), data.size(), printRecords, stats) <= 0)
+                    ++stats.badPackets;
+            }
+        });
+    } else if (parser.isSet(optTcp)) {
+        if (!splitHostPort(parser.value(optTcp), host, port)) {
+            printf("invalid --tcp, expected host:port\n");
+            return 1;
+        }
+        int slowMs = parser.value(optSlow).toInt();
+        if (slowMs > 0) tcp.setReadBufferSize(4096);
+
+        auto readTcp = [&](){
+            tcpBuffer.append(tcp.readAll());
+            int offset = 0;
+            for (;;) {
+                int used = handleBatch(reinterpret_cast<const uchar *>(tcpBuffer.constData()) + offset,
+                                       tcpBuffer.size() - offset, printRecords, stats);
+                if (used < 0) {
+                    printf("stream out of sync, disconnecting\n");
+                    tcp.abort();
+                    QCoreApplication::exit(1);
+                    return;
+                }
+                if (used == 0) break;
+                offset += used;
+            }
+            tcpBuffer.remove(0, offset);
+        };
+
+        if (slowMs > 0) {
+            QObject::connect(&slowTimer, &QTimer::timeout, readTcp);
+            slowTimer.start(slowMs);
+        } else {
+            QObject::connect(&tcp, &QTcpSocket::readyRead, readTcp);
+        }
+        QObject::connect(&tcp, &QTcpSocket::disconnected, [&](){
+            printf("disconnected\n");
+            QCoreApplication::exit(0);
+        });
+        QObject::connect(&tcp, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), [&](QAbstractSocket::SocketError){
+            if (tcp.state() != QAbstractSocket::ConnectedState) {
+                printf("cannot connect to %s:%u: %s\n", qPrintable(host), port, qPrintable(tcp.errorString()));
+                QCoreApplication::exit(1);
+            }
+        });
+        tcp.connectToHost(host, port);
+    } else {
+        printf("specify --udp or --tcp\n");
+        return 1;
+    }
+
+    QTimer statsTimer;
+    if (!printRecords) {
+        QObject::connect(&statsTimer, &QTimer::timeout, [&](){
+            printf("%lld rec/s  %lld batches  lost %lld  dropped %lld  bad %lld  latency avg %.2f ms max %.2f ms\n",
+                   stats.records, stats.batches, stats.lostBatches, stats.dropped, stats.badPackets,
+                   stats.records > 0 ? double(stats.latencySumUs) / stats.records / 1000.0 : 0.0,
+                   double(stats.latencyMaxUs) / 1000.0);
+            fflush(stdout);
+            stats.reset();
+        });
+        statsTimer.start(1000);
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,16 @@
+QT -= gui
+QT += core network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../uwbserial
+
+SOURCES += \
+    main.cpp \
+    ../uwbserial/feedformat.cpp
+
+HEADERS += \
+    ../uwbserial/feedformat.h
@@ -0,0 +1,246 @@
+#include "batchsolver.h"
+#include <QtMath>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UWB_BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define UWB_TARGET_AVX2
+#else
+#define UWB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+const double kMinDet = kClosedFormMinDet;
+
+// 一个标签的线性化正规方程 (ClosedFormNormal), 槽位 0 为参考基站
+inline void solveLane(const RangeBatch &b, int t, double *x, double *y, quint8 *ok)
+{
+    double xn = b.x[0][t], yn = b.y[0][t], rn = b.r[0][t];
+    ClosedFormNormal<double> normal;
+    for (int s = 1; s < RangeBatch::MaxAnchors; ++s)
+        normal.add(b.x[s][t] - xn, b.y[s][t] - yn, rn * rn, b.r[s][t]);
+
+    double det = normal.det();
+    ok[t] = qAbs(det) >= kMinDet;
+    x[t] = ok[t] ? xn + normal.offsetX(det) : 0;
+    y[t] = ok[t] ? yn + normal.offsetY(det) : 0;
+}
+
+void solveScalar(const RangeBatch &b, int begin, double *x, double *y, quint8 *ok)
+{
+    for (int t = begin; t < b.size; ++t)
+        solveLane(b, t, x, y, ok);
+}
+
+#ifdef UWB_BATCH_X86
+
+// 每次处理 2 个标签
+int solveSse2(const RangeBatch &b, double *x, double *y, quint8 *ok)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d minDet = _mm_set1_pd(kMinDet);
+
+    int t = 0;
+    for (; t + 2 <= b.size; t += 2) {
+        __m128d xn = _mm_loadu_pd(&b.x[0][t]);
+        __m128d yn = _mm_loadu_pd(&b.y[0][t]);
+        __m128d rn = _mm_loadu_pd(&b.r[0][t]);
+        __m128d rn2 = _mm_mul_pd(rn, rn);
+        __m128d a11 = _mm_setzero_pd(), a12 = _mm_setzero_pd(), a22 = _mm_setzero_pd();
+        __m128d b1 = _mm_setzero_pd(), b2 = _mm_setzero_pd();
+
+        for (int s = 1; s < RangeBatch::MaxAnchors; ++s) {
+            __m128d xi = _mm_loadu_pd(&b.x[s][t]);
+            __m128d yi = _mm_loadu_pd(&b.y[s][t]);
+            __m128d ri = _mm_loadu_pd(&b.r[s][t]);
+            __m128d dx = _mm_sub_pd(xi, xn);
+            __m128d dy = _mm_sub_pd(yi, yn);
+            __m128d ai0 = _mm_mul_pd(two, dx);
+            __m128d ai1 = _mm_mul_pd(two, dy);
+            __m128d bi = _mm_add_pd(_mm_add_pd(_mm_sub_pd(rn2, _mm_mul_pd(ri, ri)), _mm_mul_pd(dx, dx)), _mm_mul_pd(dy, dy));
+
+            a11 = _mm_add_pd(a11, _mm_mul_pd(ai0, ai0));
+            a12 = _mm_add_pd(a12, _mm_mul_pd(ai0, ai1));
+            a22 = _mm_add_pd(a22, _mm_mul_pd(ai1, ai1));
+            b1 = _mm_add_pd(b1, _mm_mul_pd(ai0, bi));
+            b2 = _mm_add_pd(b2, _mm_mul_pd(ai1, bi));
+        }
+
+        __m128d det = _mm_sub_pd(_mm_mul_pd(a11, a22), _mm_mul_pd(a12, a12));
+        __m128d good = _mm_cmpge_pd(_mm_andnot_pd(signMask, det), minDet);
+        __m128d px = _mm_add_pd(xn, _mm_div_pd(_mm_sub_pd(_mm_mul_pd(a22, b1), _mm_mul_pd(a12, b2)), det));
+        __m128d py = _mm_add_pd(yn, _mm_div_pd(_mm_sub_pd(_mm_mul_pd(a11, b2), _mm_mul_pd(a12, b1)), det));
+        _mm_storeu_pd(x + t, _mm_and_pd(px, good));
+        _mm_storeu_pd(y + t, _mm_and_pd(py, good));
+
+        int mask = _mm_movemask_pd(good);
+        ok[t] = mask & 1;
+        ok[t + 1] = (mask >> 1) & 1;
+    }
+    return t;
+}
+
+// 每次处理 4 个标签
+UWB_TARGET_AVX2 int solveAvx2(const RangeBatch &b, double *x, double *y, quint8 *ok)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    const __m256d minDet = _mm256_set1_pd(kMinDet);
+
+    int t = 0;
+    for (; t + 4 <= b.size; t += 4) {
+        __m256d xn = _mm256_loadu_pd(&b.x[0][t]);
+        __m256d yn = _mm256_loadu_pd(&b.y[0][t]);
+        __m256d rn = _mm256_loadu_pd(&b.r[0][t]);
+        __m256d rn2 = _mm256_mul_pd(rn, rn);
+        __m256d a11 = _mm256_setzero_pd(), a12 = _mm256_setzero_pd(), a22 = _mm256_setzero_pd();
+        __m256d b1 = _mm256_setzero_pd(), b2 = _mm256_setzero_pd();
+
+        for (int s = 1; s < RangeBatch::MaxAnchors; ++s) {
+            __m256d xi = _mm256_loadu_pd(&b.x[s][t]);
+            __m256d yi = _mm256_loadu_pd(&b.y[s][t]);
+            __m256d ri = _mm256_loadu_pd(&b.r[s][t]);
+            __m256d dx = _mm256_sub_pd(xi, xn);
+            __m256d dy = _mm256_sub_pd(yi, yn);
+            __m256d ai0 = _mm256_mul_pd(two, dx);
+            __m256d ai1 = _mm256_mul_pd(two, dy);
+            __m256d bi = _mm256_add_pd(_mm256_add_pd(_mm256_sub_pd(rn2, _mm256_mul_pd(ri, ri)), _mm256_mul_pd(dx, dx)), _mm256_mul_pd(dy, dy));
+
+            a11 = _mm256_add_pd(a11, _mm256_mul_pd(ai0, ai0));
+            a12 = _mm256_add_pd(a12, _mm256_mul_pd(ai0, ai1));
+            a22 = _mm256_add_pd(a22, _mm256_mul_pd(ai1, ai1));
+            b1 = _mm256_add_pd(b1, _mm256_mul_pd(ai0, bi));
+            b2 = _mm256_add_pd(b2, _mm256_mul_pd(ai1, bi));
+        }
+
+        __m256d det = _mm256_sub_pd(_mm256_mul_pd(a11, a22), _mm256_mul_pd(a12, a12));
+        __m256d good = _mm256_cmp_pd(_mm256_andnot_pd(signMask, det), minDet, _CMP_GE_OQ);
+        __m256d px = _mm256_add_pd(xn, _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(a22, b1), _mm256_mul_pd(a12, b2)), det));
+        __m256d py = _mm256_add_pd(yn, _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(a11, b2), _mm256_mul_pd(a12, b1)), det));
+        _mm256_storeu_pd(x + t, _mm256_and_pd(px, good));
+        _mm256_storeu_pd(y + t, _mm256_and_pd(py, good));
+
+        int mask = _mm256_movemask_pd(good);
+        for (int i = 0; i < 4; ++i)
+            ok[t + i] = (mask >> i) & 1;
+    }
+    return t;
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // OSXSAVE + AVX, 且操作系统保存了 YMM 寄存器
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // UWB_BATCH_X86
+
+} // namespace
+
+int RangeBatch::append(const RangeSet &set)
+{
+    int t = size++;
+    int n = qMin<int>(set.count, MaxAnchors);
+
+    int pivot = 0;
+    double minRange = 999999;
+    for (int i = 0; i < n; ++i) {
+        if (set.r[i] < minRange && set.r[i] > 0) {
+            minRange = set.r[i];
+            pivot = i;
+        }
+    }
+
+    x[0][t] = set.x[pivot];
+    y[0][t] = set.y[pivot];
+    r[0][t] = set.r[pivot];
+    int s = 1;
+    for (int i = 0; i < n; ++i) {
+        if (i == pivot) continue;
+        x[s][t] = set.x[i];
+        y[s][t] = set.y[i];
+        r[s][t] = set.r[i];
+        ++s;
+    }
+    for (; s < MaxAnchors; ++s) {
+        x[s][t] = x[0][t];
+        y[s][t] = y[0][t];
+        r[s][t] = r[0][t];
+    }
+    return t;
+}
+
+bool isBatchKernelSupported(BatchKernel kernel)
+{
+    switch (kernel) {
+    case BatchKernelScalar:
+        return true;
+#ifdef UWB_BATCH_X86
+    case BatchKernelSse2:
+        return true;
+    case BatchKernelAvx2: {
+        static const bool avx2 = cpuHasAvx2();
+        return avx2;
+    }
+#else
+    default:
+        break;
+#endif
+    }
+    return false;
+}
+
+BatchKernel bestBatchKernel()
+{
+    if (isBatchKernelSupported(BatchKernelAvx2)) return BatchKernelAvx2;
+    if (isBatchKernelSupported(BatchKernelSse2)) return BatchKernelSse2;
+    return BatchKernelScalar;
+}
+
+const char *batchKernelName(BatchKernel kernel)
+{
+    switch (kernel) {
+    case BatchKernelScalar: return "scalar";
+    case BatchKernelSse2: return "sse2";
+    case BatchKernelAvx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void solveBatch(const RangeBatch &batch, double *x, double *y, quint8 *ok)
+{
+    static const BatchKernel kernel = bestBatchKernel();
+    solveBatch(kernel, batch, x, y, ok);
+}
+
+void solveBatch(BatchKernel kernel, const RangeBatch &batch, double *x, double *y, quint8 *ok)
+{
+    int done = 0;
+#ifdef UWB_BATCH_X86
+    if (kernel == BatchKernelAvx2)
+        done = solveAvx2(batch, x, y, ok);
+    else if (kernel == BatchKernelSse2)
+        done = solveSse2(batch, x, y, ok);
+#else
+    Q_UNUSED(kernel);
+#endif
+    // 不足一个向量宽度的尾部
+    solveScalar(batch, done, x, y, ok);
+}
@@ -0,0 +1,56 @@
+#ifndef BATCHSOLVER_H
+#define BATCHSOLVER_H
+
+#include <QtGlobal>
+#include "trilateration.h"
+
+// ==========================================
+// RangeBatch: 多个标签的测距, 结构数组 (SoA) 布局, 供向量化闭式解使用
+//
+// 按槽位主序存放 x[slot][tag], 同一槽位相邻标签在内存中连续。
+// 槽位 0 固定为参考基站 (最短测距); 基站不足 MaxAnchors 的标签,
+// 空余槽位填参考基站自身, 其线性化行恰好为 0, 不影响结果,
+// 因此所有标签都按固定 MaxAnchors 个槽位计算, 不需要掩码或分支。
+//
+// 不按基站组合缓存伪逆: 向量化后正规方程每个标签只需几 ns, 批量路径的耗时
+// 主要在 append() 的打包; 缓存只能省掉前者, 却要增加散列、比较基站 ID
+// 和按标签聚集系数。曾实现的标量缓存版本比 calculatePosition 还慢。
+// uwbbench 的 batch 套件分别给出解算与含打包的每次耗时
+// ==========================================
+struct RangeBatch {
+    enum {
+        Capacity = 128,
+        MaxAnchors = RangeSet::MaxAnchors
+    };
+
+    int size;
+    double x[MaxAnchors][Capacity];
+    double y[MaxAnchors][Capacity];
+    double r[MaxAnchors][Capacity];
+
+    RangeBatch() : size(0) {}
+    void clear() { size = 0; }
+    bool isFull() const { return size == Capacity; }
+
+    // 追加一个标签 (set.count >= 3), 返回其下标; 参考基站的选取与 calculatePosition 相同
+    int append(const RangeSet &set);
+};
+
+enum BatchKernel {
+    BatchKernelScalar,
+    BatchKernelSse2,
+    BatchKernelAvx2
+};
+
+// 当前 CPU 支持的最快实现, 首次调用时检测
+BatchKernel bestBatchKernel();
+bool isBatchKernelSupported(BatchKernel kernel);
+const char *batchKernelName(BatchKernel kernel);
+
+// 解算 batch 中全部标签, x/y/ok 至少 batch.size 项; ok[i] == 0 表示几何退化。
+// 与 calculatePosition 的正规方程 (ClosedFormNormal) 及求和顺序相同, 双精度时结果一致
+void solveBatch(const RangeBatch &batch, double *x, double *y, quint8 *ok);
+// 指定实现, kernel 必须被当前 CPU 支持; 供基准测试对比
+void solveBatch(BatchKernel kernel, const RangeBatch &batch, double *x, double *y, quint8 *ok);
+
+#endif // BATCHSOLVER_H
@@ -0,0 +1,290 @@
+#include "capturefile.h"
+#include <QDir>
+#include <QDateTime>
+#include <QtEndian>
+#include <cstring>
+#include <algorithm>
+
+CaptureWriter::CaptureWriter(QObject *parent)
+    : QThread(parent), m_active(nullptr),
+      m_maxBytes(0), m_maxSeconds(0), m_wallMs(0), m_monoNs(0),
+      m_fileBytes(0), m_fileOpenedMs(0), m_fileIndex(0), m_bytesWritten(0)
+{
+    for (int i = 0; i < BufferCount; ++i) {
+        m_buffers[i] = new QByteArray;
+        m_buffers[i]->reserve(BufferSize);
+    }
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+    for (int i = 0; i < BufferCount; ++i)
+        delete m_buffers[i];
+}
+
+bool CaptureWriter::open(const QString &directory, qint64 maxBytes, int maxSeconds, qint64 wallMs, qint64 monoNs)
+{
+    if (isRunning()) return false;
+
+    QDir dir(directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        emit writeError("Cannot create capture directory: " + directory);
+        return false;
+    }
+
+    m_directory = dir.absolutePath();
+    m_maxBytes = maxBytes;
+    m_maxSeconds = maxSeconds;
+    m_wallMs = wallMs;
+    m_monoNs = monoNs;
+    m_fileIndex = 0;
+    m_bytesWritten.storeRelease(0);
+    m_dropped.storeRelease(0);
+    m_stop.storeRelease(0);
+
+    // 线程未运行, 可以安全地重置两个队列
+    QByteArray *buffer;
+    while (m_filled.pop(buffer)) {}
+    while (m_free.pop(buffer)) {}
+    while (m_filledCount.tryAcquire()) {}
+    for (int i = 1; i < BufferCount; ++i) {
+        m_buffers[i]->truncate(0);
+        m_free.push(m_buffers[i]);
+    }
+    m_active = m_buffers[0];
+    m_active->truncate(0);
+
+    if (!openNextFile()) return false;
+
+    start(QThread::LowPriority);
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if (!isRunning()) return;
+
+    flush();
+    m_stop.storeRelease(1);
+    m_filledCount.release();
+    wait();
+
+    m_file.close();
+    m_active = nullptr;
+}
+
+void CaptureWriter::append(qint64 timeNs, int source, const char *data, int len)
+{
+    if (len > Capture::MaxLineLength) len = Capture::MaxLineLength;
+    int recordSize = Capture::RecordHeaderSize + len;
+
+    if (m_active && m_active->size() + recordSize > BufferSize)
+        flush();
+    if (!m_active && !m_free.pop(m_active)) {
+        m_active = nullptr;
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    uchar header[Capture::RecordHeaderSize];
+    qToLittleEndian<qint64>(timeNs, header);
+    qToLittleEndian<quint16>(quint16(len), header + 8);
+    header[10] = uchar(source);
+    header[11] = 0;
+
+    m_active->append(reinterpret_cast<const char *>(header), Capture::RecordHeaderSize);
+    m_active->append(data, len);
+}
+
+void CaptureWriter::flush()
+{
+    if (!m_active || m_active->isEmpty()) return;
+
+    // 队列容量等于缓冲区总数, push 不会失败
+    m_filled.push(m_active);
+    m_filledCount.release();
+
+    if (!m_free.pop(m_active))
+        m_active = nullptr;
+}
+
+void CaptureWriter::run()
+{
+    for (;;) {
+        m_filledCount.acquire();
+
+        QByteArray *buffer;
+        if (m_filled.pop(buffer)) {
+            writeBuffer(buffer);
+            buffer->truncate(0);
+            m_free.push(buffer);
+        } else if (m_stop.loadAcquire()) {
+            break;
+        }
+    }
+    m_file.flush();
+}
+
+bool CaptureWriter::openNextFile()
+{
+    if (m_file.isOpen()) m_file.close();
+
+    QString name = QString("uwbcap-%1-%2.ucap")
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"))
+            .arg(m_fileIndex++, 3, 10, QChar('0'));
+    m_file.setFileName(m_directory + "/" + name);
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit writeError("Cannot open capture file: " + m_file.errorString());
+        return false;
+    }
+
+    uchar header[Capture::HeaderSize];
+    memcpy(header, Capture::Magic, 8);
+    qToLittleEndian<quint32>(Capture::Version, header + 8);
+    qToLittleEndian<quint32>(quint32(Capture::HeaderSize), header + 12);
+    qToLittleEndian<qint64>(m_wallMs, header + 16);
+    qToLittleEndian<qint64>(m_monoNs, header + 24);
+    m_file.write(reinterpret_cast<const char *>(header), Capture::HeaderSize);
+
+    m_fileBytes = Capture::HeaderSize;
+    m_fileOpenedMs = QDateTime::currentMSecsSinceEpoch();
+    emit fileOpened(m_file.fileName());
+    return true;
+}
+
+void CaptureWriter::writeBuffer(QByteArray *buffer)
+{
+    // 只在缓冲区边界滚动, 保证记录不会跨文件
+    bool sizeExceeded = m_maxBytes > 0 && m_fileBytes > Capture::HeaderSize
+            && m_fileBytes + buffer->size() > m_maxBytes;
+    bool timeExceeded = m_maxSeconds > 0
+            && QDateTime::currentMSecsSinceEpoch() - m_fileOpenedMs >= qint64(m_maxSeconds) * 1000;
+    if ((sizeExceeded || timeExceeded || !m_file.isOpen()) && !openNextFile())
+        return;
+
+    qint64 written = m_file.write(*buffer);
+    if (written != buffer->size()) {
+        emit writeError("Capture write failed: " + m_file.errorString());
+        return;
+    }
+    m_fileBytes += written;
+    m_bytesWritten.fetchAndAddRelaxed(written);
+}
+
+// ==========================================
+// CaptureReader 实现
+// ==========================================
+
+CaptureReader::CaptureReader()
+    : m_data(nullptr), m_size(0), m_wallMs(0), m_monoNs(0),
+      m_firstTimeNs(0), m_lastTimeNs(0), m_recordCount(0)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < Capture::HeaderSize) {
+        m_error = "File too small";
+        m_file.close();
+        return false;
+    }
+
+    uchar *data = m_file.map(0, m_size);
+    if (!data) {
+        m_error = "Cannot map file: " + m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    if (memcmp(data, Capture::Magic, 8) != 0
+            || qFromLittleEndian<quint32>(data + 8) != Capture::Version) {
+        m_error = "Not a capture file";
+        m_file.unmap(data);
+        m_file.close();
+        return false;
+    }
+
+    m_data = data;
+    m_wallMs = qFromLittleEndian<qint64>(m_data + 16);
+    m_monoNs = qFromLittleEndian<qint64>(m_data + 24);
+
+    // 建立稀疏索引
+    qint64 offset = beginOffset();
+    Record record;
+    while (true) {
+        qint64 recordOffset = offset;
+        if (!next(offset, record)) break;
+
+        if (m_recordCount % IndexStride == 0)
+            m_index.append({ record.timeNs, recordOffset });
+        if (m_recordCount == 0) m_firstTimeNs = record.timeNs;
+        m_lastTimeNs = record.timeNs;
+        ++m_recordCount;
+    }
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) m_file.close();
+
+    m_size = 0;
+    m_firstTimeNs = m_lastTimeNs = 0;
+    m_recordCount = 0;
+    m_index.clear();
+}
+
+qint64 CaptureReader::seek(qint64 timeNs) const
+{
+    if (m_index.isEmpty()) return beginOffset();
+
+    // 最后一个 timeNs < 目标时间的索引项, 从它开始顺序查找
+    auto it = std::lower_bound(m_index.constBegin(), m_index.constEnd(), timeNs,
+                               [](const IndexEntry &e, qint64 t) { return e.timeNs < t; });
+    if (it != m_index.constBegin()) --it;
+
+    qint64 offset = it->offset;
+    Record record;
+    while (true) {
+        qint64 recordOffset = offset;
+        if (!next(offset, record)) return offset;
+        if (record.timeNs >= timeNs) return recordOffset;
+    }
+}
+
+bool CaptureReader::next(qint64 &offset, Record &record) const
+{
+    if (!m_data || offset + Capture::RecordHeaderSize > m_size) return false;
+
+    const uchar *p = m_data + offset;
+    int length = qFromLittleEndian<quint16>(p + 8);
+    if (offset + Capture::RecordHeaderSize + length > m_size) return false;
+
+    record.timeNs = qFromLittleEndian<qint64>(p);
+    record.source = p[10];
+    record.data = reinterpret_cast<const char *>(p + Capture::RecordHeaderSize);
+    record.length = length;
+
+    offset += Capture::RecordHeaderSize + length;
+    return true;
+}
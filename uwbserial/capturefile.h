@@ -0,0 +1,161 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QFile>
+#include <QVector>
+#include "spscqueue.h"
+
+// ==========================================
+// 会话录制文件格式 (*.ucap, 小端序, 只追加)
+//
+// 文件头 32 字节:
+//   char[8]  magic "UWBCAP01"
+//   u32      version
+//   u32      headerSize
+//   i64      wallMs    与 monoNs 对应的墙上时间 (ms since epoch)
+//   i64      monoNs    录制开始时的单调时钟 (ns)
+//
+// 记录 (紧随文件头, 无对齐):
+//   i64      timeNs    单调时钟 (ns), 与 monoNs 同一时基
+//   u16      length    数据长度
+//   u8       source    数据来源 (串口编号)
+//   u8       reserved
+//   u8[length]         原始一行数据, 不含换行符
+// ==========================================
+namespace Capture {
+    const char Magic[8] = { 'U', 'W', 'B', 'C', 'A', 'P', '0', '1' };
+    const quint32 Version = 1;
+    const int HeaderSize = 32;
+    const int RecordHeaderSize = 12;
+    const int MaxLineLength = 0xffff;
+}
+
+// ==========================================
+// CaptureWriter: 录制写入器
+// append() 在采集线程调用, 只做内存拷贝; 写盘在独立线程完成。
+// 缓冲区通过两个无锁队列在两个线程间循环使用,
+// 写盘跟不上时丢弃记录并计数, 不会阻塞采集。
+// ==========================================
+class CaptureWriter : public QThread
+{
+    Q_OBJECT
+public:
+    enum {
+        BufferSize = 64 * 1024,
+        BufferCount = 64
+    };
+
+    explicit CaptureWriter(QObject *parent = nullptr);
+    ~CaptureWriter();
+
+    // directory 下按大小或时长滚动生成文件; maxBytes/maxSeconds <= 0 表示不限制
+    bool open(const QString &directory, qint64 maxBytes, int maxSeconds, qint64 wallMs, qint64 monoNs);
+    void close();
+
+    // 采集线程调用
+    void append(qint64 timeNs, int source, const char *data, int len);
+    // 将未满的缓冲区交给写盘线程 (采集线程调用)
+    void flush();
+
+    qint64 bytesWritten() const { return m_bytesWritten.loadAcquire(); }
+    int droppedRecords() const { return m_dropped.loadAcquire(); }
+
+signals:
+    void fileOpened(const QString &path);
+    void writeError(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    bool openNextFile();
+    void writeBuffer(QByteArray *buffer);
+
+    // 采集线程
+    QByteArray *m_active;
+
+    // 缓冲区循环: 采集线程 -> m_filled -> 写盘线程 -> m_free -> 采集线程
+    SpscQueue<QByteArray *, BufferCount> m_filled;
+    SpscQueue<QByteArray *, BufferCount> m_free;
+    QSemaphore m_filledCount;
+    QByteArray *m_buffers[BufferCount];
+    QAtomicInt m_stop;
+
+    // 写盘线程
+    QString m_directory;
+    qint64 m_maxBytes;
+    int m_maxSeconds;
+    qint64 m_wallMs;
+    qint64 m_monoNs;
+    QFile m_file;
+    qint64 m_fileBytes;
+    qint64 m_fileOpenedMs;
+    int m_fileIndex;
+
+    QAtomicInteger<qint64> m_bytesWritten;
+    QAtomicInt m_dropped;
+};
+
+// ==========================================
+// CaptureReader: 以内存映射方式读取录制文件
+// 打开时扫描一遍建立稀疏时间索引, 之后按时间定位只需二分查找 + 少量顺序扫描;
+// 数据按需由操作系统换页, 不会把整个文件读入内存
+// ==========================================
+class CaptureReader
+{
+public:
+    struct Record {
+        qint64 timeNs;
+        int source;
+        const char *data;   // 指向映射内存, 文件关闭前有效
+        int length;
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    QString errorString() const { return m_error; }
+
+    qint64 wallMs() const { return m_wallMs; }
+    qint64 monoNs() const { return m_monoNs; }
+    qint64 firstTimeNs() const { return m_firstTimeNs; }
+    qint64 lastTimeNs() const { return m_lastTimeNs; }
+    qint64 recordCount() const { return m_recordCount; }
+
+    // 第一条记录的偏移
+    qint64 beginOffset() const { return Capture::HeaderSize; }
+    // 时间 >= timeNs 的第一条记录的偏移
+    qint64 seek(qint64 timeNs) const;
+    // 读取 offset 处的记录并把 offset 移到下一条; 到达末尾或记录不完整时返回 false
+    bool next(qint64 &offset, Record &record) const;
+
+private:
+    enum { IndexStride = 1024 };
+
+    struct IndexEntry {
+        qint64 timeNs;
+        qint64 offset;
+    };
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    QString m_error;
+
+    qint64 m_wallMs;
+    qint64 m_monoNs;
+    qint64 m_firstTimeNs;
+    qint64 m_lastTimeNs;
+    qint64 m_recordCount;
+    QVector<IndexEntry> m_index;    // 每 IndexStride 条记录一项
+};
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,66 @@
+#include "feedformat.h"
+#include <QtEndian>
+#include <cstring>
+
+void encodeFeedHeader(int count, quint32 batchSeq, quint32 dropped, uchar *out)
+{
+    memcpy(out, Feed::Magic, 4);
+    out[4] = Feed::Version;
+    out[5] = quint8(Feed::RecordSize);
+    qToLittleEndian<quint16>(quint16(count), out + 6);
+    qToLittleEndian<quint32>(batchSeq, out + 8);
+    qToLittleEndian<quint32>(dropped, out + 12);
+}
+
+void encodeFeedRecord(const FeedRecord &record, uchar *out)
+{
+    quint32 xBits, yBits;
+    memcpy(&xBits, &record.x, 4);
+    memcpy(&yBits, &record.y, 4);
+
+    qToLittleEndian<quint32>(record.tid, out);
+    qToLittleEndian<quint32>(record.seq, out + 4);
+    qToLittleEndian<qint64>(record.timeUs, out + 8);
+    qToLittleEndian<quint32>(xBits, out + 16);
+    qToLittleEndian<quint32>(yBits, out + 20);
+    qToLittleEndian<qint16>(record.vx, out + 24);
+    qToLittleEndian<qint16>(record.vy, out + 26);
+    out[28] = record.status;
+    out[29] = record.quality;
+    out[30] = 0;
+    out[31] = 0;
+}
+
+bool decodeFeedHeader(const uchar *data, int size, FeedHeader &header)
+{
+    if (size < Feed::HeaderSize || memcmp(data, Feed::Magic, 4) != 0)
+        return false;
+
+    header.version = data[4];
+    header.recordSize = data[5];
+    header.count = qFromLittleEndian<quint16>(data + 6);
+    header.batchSeq = qFromLittleEndian<quint32>(data + 8);
+    header.dropped = qFromLittleEndian<quint32>(data + 12);
+
+    // 新版本只会在记录末尾追加字段
+    if (header.recordSize < Feed::RecordSize)
+        return false;
+    return size >= Feed::HeaderSize + header.count * header.recordSize;
+}
+
+void decodeFeedRecord(const uchar *data, const FeedHeader &header, int index, FeedRecord &record)
+{
+    const uchar *p = data + Feed::HeaderSize + index * header.recordSize;
+    quint32 xBits = qFromLittleEndian<quint32>(p + 16);
+    quint32 yBits = qFromLittleEndian<quint32>(p + 20);
+
+    record.tid = qFromLittleEndian<quint32>(p);
+    record.seq = qFromLittleEndian<quint32>(p + 4);
+    record.timeUs = qFromLittleEndian<qint64>(p + 8);
+    memcpy(&record.x, &xBits, 4);
+    memcpy(&record.y, &yBits, 4);
+    record.vx = qFromLittleEndian<qint16>(p + 24);
+    record.vy = qFromLittleEndian<qint16>(p + 26);
+    record.status = p[28];
+    record.quality = p[29];
+}
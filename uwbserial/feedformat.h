@@ -0,0 +1,69 @@
+#ifndef FEEDFORMAT_H
+#define FEEDFORMAT_H
+
+#include <QtGlobal>
+
+// ==========================================
+// 定位数据发布格式 (小端序, 定长)
+//
+// 每次发送 (一个 UDP 数据报 / TCP 流中的一段) 为一个批次:
+//   批次头 16 字节:
+//     char[4]  magic "UWBF"
+//     u8       version
+//     u8       recordSize  (32, 接收端据此跳过未来版本追加的字段)
+//     u16      count       本批记录数
+//     u32      batchSeq    本订阅流的批次序号, 不连续表示 UDP 丢包
+//     u32      dropped     自上一批以来因订阅端过慢而丢弃的记录数
+//   记录 32 字节 x count:
+//     u32      tid
+//     u32      seq
+//     i64      timeUs      收到数据的时刻 (Unix 纪元, us)
+//     f32      x           滤波后坐标 (cm)
+//     f32      y
+//     i16      vx          速度 (cm/s), 超出范围时饱和
+//     i16      vy
+//     u8       status      TagFix::Status
+//     u8       quality     参与解算的基站数, 0 表示无坐标
+//     u16      reserved
+// ==========================================
+namespace Feed {
+    const char Magic[4] = { 'U', 'W', 'B', 'F' };
+    const quint8 Version = 1;
+    const int HeaderSize = 16;
+    const int RecordSize = 32;
+    // UDP 数据报不超过常见 MTU, 避免 IP 分片
+    const int MaxDatagramSize = 1400;
+    const int MaxRecordsPerDatagram = (MaxDatagramSize - HeaderSize) / RecordSize;
+}
+
+struct FeedRecord {
+    quint32 tid;
+    quint32 seq;
+    qint64 timeUs;
+    float x;
+    float y;
+    qint16 vx;
+    qint16 vy;
+    quint8 status;
+    quint8 quality;
+};
+
+struct FeedHeader {
+    quint8 version;
+    int recordSize;
+    int count;
+    quint32 batchSeq;
+    quint32 dropped;
+};
+
+// 写入批次头, out 至少 Feed::HeaderSize 字节
+void encodeFeedHeader(int count, quint32 batchSeq, quint32 dropped, uchar *out);
+// 写入一条记录, out 至少 Feed::RecordSize 字节
+void encodeFeedRecord(const FeedRecord &record, uchar *out);
+
+// 校验并读取批次头; size 不足以容纳 count 条记录时返回 false
+bool decodeFeedHeader(const uchar *data, int size, FeedHeader &header);
+// 读取批次中第 index 条记录 (header 须已校验)
+void decodeFeedRecord(const uchar *data, const FeedHeader &header, int index, FeedRecord &record);
+
+#endif // FEEDFORMAT_H
@@ -0,0 +1,247 @@
+#include "feedpublisher.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+FeedPublisher::FeedPublisher(QObject *parent)
+    : QObject(parent), m_udp(nullptr), m_udpPort(0), m_udpBatchSeq(0), m_server(nullptr)
+{
+    m_packet.reserve(Feed::MaxDatagramSize);
+}
+
+FeedPublisher::~FeedPublisher()
+{
+    stopTcp();
+    stopUdp();
+}
+
+void FeedPublisher::offer(const FeedRecord &record)
+{
+    if (!isActive()) return;
+
+    if (!m_queue.push(record)) {
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    // 只在发布线程取空队列后才再次通知
+    if (m_notifyPending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "onRecordsReady", Qt::QueuedConnection);
+}
+
+int FeedPublisher::takeDroppedCount()
+{
+    return m_dropped.fetchAndStoreRelaxed(0);
+}
+
+void FeedPublisher::startUdp(const QString &address, quint16 port, int ttl)
+{
+    stopUdp();
+
+    QHostAddress target(address);
+    if (target.isNull() || port == 0) {
+        emit udpError(QString("invalid UDP target %1:%2").arg(address).arg(port));
+        return;
+    }
+
+    m_udp = new QUdpSocket(this);
+    // 先绑定临时端口, 才能设置组播选项
+    if (!m_udp->bind(target.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4, 0)) {
+        emit udpError(m_udp->errorString());
+        delete m_udp;
+        m_udp = nullptr;
+        return;
+    }
+    if (target.isMulticast()) {
+        m_udp->setSocketOption(QAbstractSocket::MulticastTtlOption, ttl);
+        m_udp->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    }
+
+    m_udpAddress = target;
+    m_udpPort = port;
+    m_udpBatchSeq = 0;
+    updateActive();
+    emit udpStarted(QString("%1:%2").arg(target.toString()).arg(port));
+}
+
+void FeedPublisher::stopUdp()
+{
+    if (!m_udp) return;
+
+    delete m_udp;
+    m_udp = nullptr;
+    updateActive();
+}
+
+void FeedPublisher::startTcp(quint16 port)
+{
+    stopTcp();
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &FeedPublisher::onNewConnection);
+    if (!m_server->listen(QHostAddress::Any, port)) {
+        emit tcpError(m_server->errorString());
+        delete m_server;
+        m_server = nullptr;
+        return;
+    }
+
+    updateActive();
+    emit tcpListening(m_server->serverPort());
+}
+
+void FeedPublisher::stopTcp()
+{
+    if (!m_server) return;
+
+    for (Client *client : m_clients) {
+        client->socket->disconnect(this);
+        client->socket->abort();
+        delete client->socket;
+        emit clientDisconnected(client->peer);
+        delete client;
+    }
+    m_clients.clear();
+
+    delete m_server;
+    m_server = nullptr;
+    updateActive();
+}
+
+void FeedPublisher::updateActive()
+{
+    m_active.storeRelease(m_udp || !m_clients.isEmpty() ? 1 : 0);
+}
+
+void FeedPublisher::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        socket->setParent(this);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::bytesWritten, this, &FeedPublisher::onClientBytesWritten);
+        connect(socket, &QTcpSocket::disconnected, this, &FeedPublisher::onClientDisconnected);
+
+        Client *client = new Client;
+        client->socket = socket;
+        client->peer = QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+        client->batchSeq = 0;
+        client->dropped = 0;
+        m_clients.append(client);
+        updateActive();
+        emit clientConnected(client->peer);
+    }
+}
+
+void FeedPublisher::onClientDisconnected()
+{
+    Client *client = findClient(sender());
+    if (!client) return;
+
+    m_clients.removeOne(client);
+    client->socket->deleteLater();
+    updateActive();
+    emit clientDisconnected(client->peer);
+    delete client;
+}
+
+void FeedPublisher::onClientBytesWritten()
+{
+    Client *client = findClient(sender());
+    if (!client || client->pending.isEmpty()) return;
+
+    // 发送缓冲降到一半以下再补发积压的最新位置
+    if (client->socket->bytesToWrite() >= MaxClientBacklog / 2) return;
+
+    flushPending(client);
+}
+
+FeedPublisher::Client *FeedPublisher::findClient(QObject *socket) const
+{
+    for (Client *client : m_clients) {
+        if (client->socket == socket)
+            return client;
+    }
+    return nullptr;
+}
+
+void FeedPublisher::onRecordsReady()
+{
+    m_notifyPending.storeRelease(0);
+
+    m_records.clear();
+    FeedRecord record;
+    while (m_queue.pop(record))
+        m_records.append(record);
+    if (m_records.isEmpty()) return;
+
+    if (m_udp)
+        sendUdp(m_records.constData(), m_records.size());
+    for (Client *client : m_clients)
+        sendTcp(client, m_records.constData(), m_records.size());
+}
+
+void FeedPublisher::encodeBatch(const FeedRecord *records, int count, quint32 batchSeq, quint32 dropped)
+{
+    m_packet.resize(Feed::HeaderSize + count * Feed::RecordSize);
+    uchar *out = reinterpret_cast<uchar *>(m_packet.data());
+    encodeFeedHeader(count, batchSeq, dropped, out);
+    for (int i = 0; i < count; ++i)
+        encodeFeedRecord(records[i], out + Feed::HeaderSize + i * Feed::RecordSize);
+}
+
+void FeedPublisher::sendUdp(const FeedRecord *records, int count)
+{
+    for (int i = 0; i < count; i += Feed::MaxRecordsPerDatagram) {
+        int n = qMin<int>(count - i, Feed::MaxRecordsPerDatagram);
+        encodeBatch(records + i, n, m_udpBatchSeq++, 0);
+        // 发送失败 (如缓冲区满) 与网络丢包一样由接收端按 batchSeq 发现
+        m_udp->writeDatagram(m_packet, m_udpAddress, m_udpPort);
+    }
+}
+
+void FeedPublisher::sendTcp(Client *client, const FeedRecord *records, int count)
+{
+    if (client->socket->bytesToWrite() >= MaxClientBacklog) {
+        conflate(client, records, count);
+    } else if (!client->pending.isEmpty()) {
+        // 积压刚缓解: 新记录并入积压, 每个标签只发最新一条
+        conflate(client, records, count);
+        flushPending(client);
+    } else {
+        writeClient(client, records, count);
+    }
+}
+
+void FeedPublisher::flushPending(Client *client)
+{
+    writeClient(client, client->pending.constData(), client->pending.size());
+    client->pending.clear();
+    client->pendingIndex.clear();
+}
+
+void FeedPublisher::writeClient(Client *client, const FeedRecord *records, int count)
+{
+    for (int i = 0; i < count; i += Feed::MaxRecordsPerDatagram) {
+        int n = qMin<int>(count - i, Feed::MaxRecordsPerDatagram);
+        encodeBatch(records + i, n, client->batchSeq++, client->dropped);
+        client->dropped = 0;
+        client->socket->write(m_packet);
+    }
+}
+
+void FeedPublisher::conflate(Client *client, const FeedRecord *records, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const FeedRecord &record = records[i];
+        QHash<quint32, int>::const_iterator it = client->pendingIndex.constFind(record.tid);
+        if (it != client->pendingIndex.constEnd()) {
+            client->pending[it.value()] = record;
+            ++client->dropped;
+        } else if (client->pending.size() < MaxPendingTags) {
+            client->pendingIndex.insert(record.tid, client->pending.size());
+            client->pending.append(record);
+        } else {
+            ++client->dropped;
+        }
+    }
+}
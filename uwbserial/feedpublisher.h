@@ -0,0 +1,103 @@
+#ifndef FEEDPUBLISHER_H
+#define FEEDPUBLISHER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QVector>
+#include "feedformat.h"
+#include "spscqueue.h"
+
+class QTcpServer;
+class QTcpSocket;
+class QUdpSocket;
+
+// ==========================================
+// FeedPublisher: 把滤波后的定位结果发布到局域网 (格式见 feedformat.h)
+// 运行在独立线程; 引擎线程只把记录压入无锁队列, 网络发送不会阻塞解算。
+// 每次取空队列后按批次发送: UDP (组播或单播) 每个数据报一批,
+// TCP 每个订阅者各自一条流。订阅者读得太慢 (发送缓冲超过 MaxClientBacklog) 时
+// 不再追加数据, 只为每个标签保留最新一条, 旧记录丢弃并在下一批的 dropped 中报告
+// ==========================================
+class FeedPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    enum {
+        QueueCapacity = 8192,
+        MaxClientBacklog = 64 * 1024,   // 订阅者未发出的字节数上限
+        MaxPendingTags = 4096           // 慢订阅者最多积压的标签数
+    };
+
+    explicit FeedPublisher(QObject *parent = nullptr);
+    ~FeedPublisher();
+
+    // 引擎线程调用 (单生产者); 没有任何输出时直接返回
+    void offer(const FeedRecord &record);
+    bool isActive() const { return m_active.loadAcquire() != 0; }
+    // 发布线程处理不及、队列满而丢弃的记录数 (读取后清零)
+    int takeDroppedCount();
+
+public slots:
+    // address 为组播组时按 ttl 发送并开启本机回环, 否则为单播目标 (如 127.0.0.1)
+    void startUdp(const QString &address, quint16 port, int ttl);
+    void stopUdp();
+    void startTcp(quint16 port);
+    void stopTcp();
+
+signals:
+    void udpStarted(const QString &target);
+    void udpError(const QString &error);
+    void tcpListening(quint16 port);
+    void tcpError(const QString &error);
+    void clientConnected(const QString &peer);
+    void clientDisconnected(const QString &peer);
+
+private slots:
+    void onRecordsReady();
+    void onNewConnection();
+    void onClientBytesWritten();
+    void onClientDisconnected();
+
+private:
+    struct Client {
+        QTcpSocket *socket;
+        QString peer;
+        quint32 batchSeq;
+        quint32 dropped;                // 尚未报告给订阅者的丢弃数
+        QVector<FeedRecord> pending;    // 积压时每个标签只保留最新一条
+        QHash<quint32, int> pendingIndex;
+    };
+
+    void updateActive();
+    Client *findClient(QObject *socket) const;
+    // 编码一批 (最多 Feed::MaxRecordsPerDatagram 条) 到 m_packet
+    void encodeBatch(const FeedRecord *records, int count, quint32 batchSeq, quint32 dropped);
+    void sendUdp(const FeedRecord *records, int count);
+    void sendTcp(Client *client, const FeedRecord *records, int count);
+    void writeClient(Client *client, const FeedRecord *records, int count);
+    void conflate(Client *client, const FeedRecord *records, int count);
+    void flushPending(Client *client);
+
+    SpscQueue<FeedRecord, QueueCapacity> m_queue;
+    QAtomicInt m_notifyPending;
+    QAtomicInt m_dropped;
+    QAtomicInt m_active;
+
+    // 以下只在发布线程访问
+    QVector<FeedRecord> m_records;
+    QByteArray m_packet;
+
+    QUdpSocket *m_udp;
+    QHostAddress m_udpAddress;
+    quint16 m_udpPort;
+    quint32 m_udpBatchSeq;
+
+    QTcpServer *m_server;
+    QList<Client *> m_clients;
+};
+
+#endif // FEEDPUBLISHER_H
@@ -0,0 +1,107 @@
+#include "latencystats.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+
+int bucketOf(qint64 ns)
+{
+    if (ns < 2) return 0;
+    int bucket = 63 - qCountLeadingZeroBits(quint64(ns));
+    return qMin(bucket, int(LatencySnapshot::BucketCount) - 1);
+}
+
+double bucketLow(int bucket)
+{
+    return bucket == 0 ? 0.0 : double(quint64(1) << bucket);
+}
+
+double bucketHigh(int bucket)
+{
+    return double(quint64(1) << (bucket + 1));
+}
+
+} // namespace
+
+LatencySnapshot::LatencySnapshot()
+    : count(0), sumNs(0)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+LatencySnapshot LatencySnapshot::since(const LatencySnapshot &earlier) const
+{
+    LatencySnapshot delta;
+    for (int i = 0; i < BucketCount; ++i)
+        delta.buckets[i] = buckets[i] - earlier.buckets[i];
+    delta.count = count - earlier.count;
+    delta.sumNs = sumNs - earlier.sumNs;
+    return delta;
+}
+
+double LatencySnapshot::meanNs() const
+{
+    return count ? double(sumNs) / double(count) : 0.0;
+}
+
+double LatencySnapshot::percentileNs(double p) const
+{
+    // 计数与各桶分别读取, 以桶的总和为准
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) total += buckets[i];
+    if (total == 0) return 0.0;
+
+    double rank = qBound(0.0, p, 1.0) * double(total);
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        if (buckets[i] == 0) continue;
+        if (double(seen + buckets[i]) >= rank) {
+            double frac = (rank - double(seen)) / double(buckets[i]);
+            return bucketLow(i) + frac * (bucketHigh(i) - bucketLow(i));
+        }
+        seen += buckets[i];
+    }
+    return maxBoundNs();
+}
+
+double LatencySnapshot::maxBoundNs() const
+{
+    for (int i = BucketCount - 1; i >= 0; --i) {
+        if (buckets[i]) return bucketHigh(i);
+    }
+    return 0.0;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (int i = 0; i < LatencySnapshot::BucketCount; ++i)
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNs.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if (ns < 0) ns = 0;
+    m_buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(quint64(ns), std::memory_order_relaxed);
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const
+{
+    LatencySnapshot snap;
+    for (int i = 0; i < LatencySnapshot::BucketCount; ++i)
+        snap.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    snap.count = m_count.load(std::memory_order_relaxed);
+    snap.sumNs = m_sumNs.load(std::memory_order_relaxed);
+    return snap;
+}
+
+const char *LatencyStats::stageName(int stage)
+{
+    static const char *const names[StageCount] = {
+        "framing", "parse", "merge", "solve", "filter", "queue", "paint", "total"
+    };
+    return uint(stage) < uint(StageCount) ? names[stage] : "?";
+}
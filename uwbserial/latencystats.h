@@ -0,0 +1,94 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// ==========================================
+// LatencyHistogram: 无锁延迟直方图, 按 2 的幂分桶 (ns)
+// 桶 i 统计 [2^i, 2^(i+1)) ns, 桶 0 另含 0 与 1 ns。
+// 任意线程可并发 record() (relaxed 原子加), 读端随时 snapshot(), 不阻塞写端;
+// 多个线程写同一直方图时会争用缓存行, 不需要统计时应不调用 (见 LatencyStats::setEnabled)
+// ==========================================
+struct LatencySnapshot {
+    enum { BucketCount = 40 };      // 最大约 2^40 ns (18 分钟), 更长的计入最后一桶
+
+    quint64 buckets[BucketCount];
+    quint64 count;
+    quint64 sumNs;
+
+    LatencySnapshot();
+
+    // 两次快照之间的增量
+    LatencySnapshot since(const LatencySnapshot &earlier) const;
+    double meanNs() const;
+    // 在所在桶内线性插值, p 为 0~1; 没有样本时为 0
+    double percentileNs(double p) const;
+    // 最高非空桶的上界
+    double maxBoundNs() const;
+};
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 ns);
+    LatencySnapshot snapshot() const;
+
+private:
+    Q_DISABLE_COPY(LatencyHistogram)
+
+    std::atomic<quint64> m_buckets[LatencySnapshot::BucketCount];
+    std::atomic<quint64> m_count;
+    std::atomic<quint64> m_sumNs;
+};
+
+// ==========================================
+// LatencyStats: 从串口 readyRead 到地图绘制的分阶段延迟
+// 各阶段的时间戳均取自 PositionEngine 的单调时钟:
+//   Framing  readyRead -> 切出一行
+//   Parse    切出一行 -> 解析完成
+//   Merge    readyRead -> 合并器放行 (含多串口的重排窗口)
+//   Solve    放行 -> 解算完成 (批量解算时为整批完成)
+//   Filter   解算完成 -> 滤波完成
+//   Queue    滤波完成 -> GUI 线程取出
+//   Paint    GUI 取出 -> 该标签所在区域绘制完成
+//   Total    readyRead -> 绘制完成
+// 回放数据的到达时间来自录制文件, 只统计 Solve 与 Filter。
+// 默认关闭: 关闭时各线程既不取时间戳也不记录, 由界面在打开浮层或 CSV 导出时开启
+// ==========================================
+class LatencyStats
+{
+public:
+    enum Stage {
+        StageFraming,
+        StageParse,
+        StageMerge,
+        StageSolve,
+        StageFilter,
+        StageQueue,
+        StagePaint,
+        StageTotal,
+        StageCount
+    };
+
+    LatencyStats() : m_enabled(false) {}
+
+    static const char *stageName(int stage);
+
+    // 任意线程调用; 开关切换前后的一小段统计可能不完整
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void record(Stage stage, qint64 ns) { m_stages[stage].record(ns); }
+    LatencySnapshot snapshot(Stage stage) const { return m_stages[stage].snapshot(); }
+
+private:
+    Q_DISABLE_COPY(LatencyStats)
+
+    LatencyHistogram m_stages[StageCount];
+    std::atomic<bool> m_enabled;
+};
+
+#endif // LATENCYSTATS_H
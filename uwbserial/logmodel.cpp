@@ -0,0 +1,169 @@
+#include "logmodel.h"
+#include <QDateTime>
+#include <QColor>
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent),
+      m_capacity(qMax(1, capacity)),
+      m_ring(m_capacity),
+      m_nextSeq(0),
+      m_view(m_capacity),
+      m_viewStart(0),
+      m_viewCount(0),
+      m_tagFilter(-1),
+      m_minSeverity(LogRecord::Info)
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_viewCount;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_viewCount) return QVariant();
+
+    const LogRecord &record = recordAtRow(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return format(record);
+    case Qt::ForegroundRole:
+        if (record.severity == LogRecord::Error) return QColor(Qt::red);
+        if (record.severity == LogRecord::Warning) return QColor(200, 120, 0);
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+void LogModel::append(const LogRecord &record)
+{
+    append(&record, 1);
+}
+
+void LogModel::append(const LogRecord *records, int count)
+{
+    if (count <= 0) return;
+
+    // 一批超过容量时只保留最后 capacity 条
+    if (count > m_capacity) {
+        m_nextSeq += quint64(count - m_capacity);
+        records += count - m_capacity;
+        count = m_capacity;
+    }
+
+    // 1. 淘汰将被覆盖的记录对应的可见行 (都在视图头部)
+    quint64 newEnd = m_nextSeq + quint64(count);
+    quint64 oldest = newEnd > quint64(m_capacity) ? newEnd - quint64(m_capacity) : 0;
+    int evicted = 0;
+    while (evicted < m_viewCount && m_view[(m_viewStart + evicted) % m_capacity] < oldest)
+        ++evicted;
+
+    if (evicted > 0) {
+        beginRemoveRows(QModelIndex(), 0, evicted - 1);
+        m_viewStart = (m_viewStart + evicted) % m_capacity;
+        m_viewCount -= evicted;
+        endRemoveRows();
+    }
+
+    // 2. 写入环形缓冲区
+    int accepted = 0;
+    for (int i = 0; i < count; ++i) {
+        m_ring[int((m_nextSeq + quint64(i)) % quint64(m_capacity))] = records[i];
+        if (accepts(records[i])) ++accepted;
+    }
+
+    // 3. 追加可见行
+    if (accepted > 0) {
+        beginInsertRows(QModelIndex(), m_viewCount, m_viewCount + accepted - 1);
+        for (int i = 0; i < count; ++i) {
+            if (!accepts(records[i])) continue;
+            m_view[(m_viewStart + m_viewCount) % m_capacity] = m_nextSeq + quint64(i);
+            ++m_viewCount;
+        }
+        endInsertRows();
+    }
+
+    m_nextSeq = newEnd;
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    m_nextSeq = 0;
+    m_viewStart = 0;
+    m_viewCount = 0;
+    endResetModel();
+}
+
+void LogModel::setTagFilter(int tagId)
+{
+    if (m_tagFilter == tagId) return;
+    m_tagFilter = tagId;
+    rebuildView();
+}
+
+void LogModel::setMinimumSeverity(LogRecord::Severity severity)
+{
+    if (m_minSeverity == severity) return;
+    m_minSeverity = severity;
+    rebuildView();
+}
+
+bool LogModel::accepts(const LogRecord &record) const
+{
+    if (record.severity < m_minSeverity) return false;
+    // 系统消息不受标签过滤影响
+    if (m_tagFilter >= 0 && record.tagId >= 0 && record.tagId != m_tagFilter) return false;
+    return true;
+}
+
+const LogRecord &LogModel::recordAtRow(int row) const
+{
+    quint64 seq = m_view[(m_viewStart + row) % m_capacity];
+    return m_ring[int(seq % quint64(m_capacity))];
+}
+
+void LogModel::rebuildView()
+{
+    beginResetModel();
+    m_viewStart = 0;
+    m_viewCount = 0;
+    quint64 oldest = m_nextSeq > quint64(m_capacity) ? m_nextSeq - quint64(m_capacity) : 0;
+    for (quint64 seq = oldest; seq < m_nextSeq; ++seq) {
+        if (accepts(m_ring[int(seq % quint64(m_capacity))]))
+            m_view[m_viewCount++] = seq;
+    }
+    endResetModel();
+}
+
+QString LogModel::format(const LogRecord &record) const
+{
+    QString timeStr = QDateTime::fromMSecsSinceEpoch(record.timeMs).toString("[HH:mm:ss.zzz] ");
+    if (!record.hasFix) return timeStr + record.text;
+
+    const TagFix &fix = record.fix;
+    switch (fix.status) {
+    case TagFix::NotEnoughAnchors:
+        return timeStr + QString("Tag %1: Not enough known anchors (%2 found)").arg(fix.tid).arg(fix.anchorCount);
+    case TagFix::CalcFailed:
+        return timeStr + QString("Tag %1: Calc Failed").arg(fix.tid);
+    case TagFix::Ok:
+        break;
+    }
+
+    QString usedAnchorsStr, rejectedAnchorsStr;
+    for (int i = 0; i < fix.anchorCount; ++i) {
+        QString item = QString("A%1:%2 ").arg(fix.anchorId[i]).arg(fix.range[i]);
+        if (fix.rejectedMask & (1u << i))
+            rejectedAnchorsStr += item;
+        else
+            usedAnchorsStr += item;
+    }
+    QString text = timeStr + QString("Tag %1 -> (%2, %3) | Used: %4")
+            .arg(fix.tid).arg(fix.x, 0, 'f', 1).arg(fix.y, 0, 'f', 1).arg(usedAnchorsStr);
+    if (fix.rejectedMask)
+        text += "| Rejected: " + rejectedAnchorsStr;
+    return text;
+}
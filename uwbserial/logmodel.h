@@ -0,0 +1,70 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QString>
+#include "positionengine.h"
+
+// ==========================================
+// LogRecord: 结构化日志记录, 显示文本在滚动到可见时才格式化
+// ==========================================
+struct LogRecord {
+    enum Severity {
+        Info,
+        Warning,
+        Error
+    };
+
+    qint64 timeMs;          // 墙上时间 (ms since epoch)
+    Severity severity;
+    int tagId;              // -1 表示系统消息
+    bool hasFix;            // true: 内容来自 fix; false: 内容为 text
+    TagFix fix;
+    QString text;
+};
+
+// ==========================================
+// LogModel: 定长环形缓冲区日志, 供 QListView 虚拟化显示
+// 超出容量时最旧的记录逐条淘汰, 内存占用恒定
+// ==========================================
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum { DefaultCapacity = 10000 };
+
+    explicit LogModel(int capacity = DefaultCapacity, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // 批量追加, 每批只发出一次行插入/删除通知
+    void append(const LogRecord *records, int count);
+    void append(const LogRecord &record);
+    void clear();
+
+    // 过滤: tagId < 0 表示全部标签
+    void setTagFilter(int tagId);
+    void setMinimumSeverity(LogRecord::Severity severity);
+
+private:
+    bool accepts(const LogRecord &record) const;
+    const LogRecord &recordAtRow(int row) const;
+    QString format(const LogRecord &record) const;
+    void rebuildView();
+
+    int m_capacity;
+    QVector<LogRecord> m_ring;  // 按序号 seq % capacity 存放
+    quint64 m_nextSeq;          // 下一条记录的序号
+
+    // 当前过滤条件下可见记录的序号, 同样是定长环
+    QVector<quint64> m_view;
+    int m_viewStart;
+    int m_viewCount;
+
+    int m_tagFilter;
+    LogRecord::Severity m_minSeverity;
+};
+
+#endif // LOGMODEL_H
@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "positionengine.h"
+#include "feedpublisher.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -13,33 +15,83 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QDoubleSpinBox>
-#include <QTextEdit>
+#include <QListView>
+#include <QListWidget>
 #include <QProcess>
+#include <QFile>
 #include <QFileDialog>
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
-#include <QRegExp>
 #include <QSet>
 #include <algorithm>
 #include <QScrollBar>
+#include <QThread>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QResizeEvent>
+#include <QApplication>
+#include <QToolTip>
+#include <QSpinBox>
+#include <QSlider>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QFontDatabase>
+#include <QTextStream>
+#include <QHostAddress>
 
 //#define DEBUG_ANCHORS
 
+// 两包之间按速度外推的最长时间 (ms), 超过后停在外推终点等待下一包
+static const int kPredictionHorizonMs = 300;
+
+// 鼠标拾取标签的半径 (像素)
+static const double kPickRadiusPx = 10.0;
+
+// 滚轮每格的缩放倍数, 以及缩放范围 (像素/cm)
+static const double kZoomStep = 1.25;
+static const double kMinScale = 0.001;
+static const double kMaxScale = 50.0;
+
+// 组播只在本网段内转发
+static const int kFeedMulticastTtl = 1;
+
+// 延迟浮层的刷新间隔 (ms)
+static const int kLatencyHudIntervalMs = 1000;
+// 标签统计表的刷新间隔 (ms)
+static const int kTagStatsIntervalMs = 1000;
+
+// 延迟显示: 小于 1 ms 用 us, 否则用 ms
+static QString formatLatency(double ns)
+{
+    if (ns < 1e6) return QString::number(ns / 1e3, 'f', 1) + "us";
+    return QString::number(ns / 1e6, 'f', 2) + "ms";
+}
+
 // ==========================================
 // MapWidget 实现
 // ==========================================
 
-MapWidget::MapWidget(QWidget *parent) : QWidget(parent), m_scale(1.0), m_offsetX(0), m_offsetY(0), m_margin(50.0)
+MapWidget::MapWidget(QWidget *parent)
+    : QWidget(parent), m_hoverTag(-1), m_selectedTag(-1), m_frameTimer(new QTimer(this)), m_transformDirty(true),
+      m_autoFit(true), m_fitPending(true), m_dragging(false), m_staticDirty(true),
+      m_scale(1.0), m_offsetX(0), m_offsetY(0), m_margin(50.0), m_hasClusters(false), m_latency(nullptr),
+      m_trailSeconds(0), m_trailLayoutMs(0)
 {
     setMinimumSize(400, 400);
-    QPalette pal = palette();
-    pal.setColor(QPalette::Window, Qt::white);
-    setAutoFillBackground(true);
-    setPalette(pal);
+    setMouseTracking(true);
+    // 静态层覆盖整个控件, 不需要 Qt 先填充背景
+    setAttribute(Qt::WA_OpaquePaintEvent);
 
     // load anchor png
     m_anchorImage.load(":/anchor.png");
+    m_hudFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+
+    m_clock.start();
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, this, &MapWidget::onFrameTick);
+    setFrameRate(30);
 }
 
 void MapWidget::updateAnchors(const QVector<Point> &anchors)
@@ -50,7 +102,9 @@ void MapWidget::updateAnchors(const QVector<Point> &anchors)
 void MapWidget::updateAnchorsMap(const QMap<int, Point> &anchorsMap)
 {
     m_anchors = anchorsMap;
-    update();
+    m_staticDirty = true;
+    m_transformDirty = true;
+    if (m_autoFit) m_fitPending = true;
 }
 
 QMap<int, MapWidget::Point> MapWidget::getAnchorsMap() const
@@ -58,18 +112,271 @@ QMap<int, MapWidget::Point> MapWidget::getAnchorsMap() const
     return m_anchors;
 }
 
-void MapWidget::updateTag(int id, int x, int y)
+void MapWidget::setLatencyStats(LatencyStats *stats, const QElapsedTimer &clock)
 {
-    Tag tag;
-    tag.pos.x = x;
-    tag.pos.y = y;
-    tag.color = Qt::red;
-    m_tags[id] = tag;
-    update();
+    m_latency = stats;
+    m_latencyClock = clock;
+}
+
+void MapWidget::setHudText(const QStringList &lines)
+{
+    QRect oldRect = m_hudRect;
+    m_hudLines = lines;
+
+    if (lines.isEmpty()) {
+        m_hudRect = QRect();
+    } else {
+        QFontMetrics fm(m_hudFont);
+        int w = 0;
+        for (const QString &line : lines) w = qMax(w, fm.boundingRect(line).width());
+        m_hudRect = QRect(8, 8, w + 16, lines.size() * fm.lineSpacing() + 12);
+    }
+    update(oldRect.united(m_hudRect));
+}
+
+void MapWidget::updateTag(int id, double x, double y, double vx, double vy, qint64 readNs)
+{
+    auto it = m_tags.find(id);
+    if (it == m_tags.end()) {
+        Tag tag;
+        tag.color = Qt::red;
+        tag.dirty = false;
+        tag.labelShown = false;
+        tag.trailDirty = false;
+        tag.traceReadNs = 0;
+        tag.traceUpdateNs = 0;
+        it = m_tags.insert(id, tag);
+        m_grid.update(id, tag.pos);
+        m_transformDirty = true;
+        if (m_autoFit && m_anchors.isEmpty()) m_fitPending = true;
+    }
+
+    it->fixPos = QPointF(x, y);
+    it->velocity = QPointF(vx, vy);
+    it->fixMs = m_clock.elapsed();
+    if (m_trailSeconds > 0) {
+        m_trails.append(id, it->fixMs, it->fixPos);
+        if (!it->trailDirty) {
+            it->trailDirty = true;
+            m_trailDirtyTags.append(id);
+        }
+    }
+    if (it->pos == it->fixPos) return;
+
+    it->pos = it->fixPos;
+    m_grid.update(id, it->pos);
+
+    // 同一帧内的多次更新只统计最后一次
+    if (m_latency && readNs > 0) {
+        if (it->traceReadNs == 0) m_tracedTags.append(id);
+        it->traceReadNs = readNs;
+        it->traceUpdateNs = m_latencyClock.nsecsElapsed();
+    }
+    if (!it->dirty) {
+        it->dirty = true;
+        m_dirtyTags.append(id);
+    }
+}
+
+void MapWidget::setFrameRate(int fps)
+{
+    fps = qBound(1, fps, 240);
+    m_frameTimer->start(qMax(1, 1000 / fps));
+}
+
+int MapWidget::frameRate() const
+{
+    return 1000 / qMax(1, m_frameTimer->interval());
+}
+
+void MapWidget::onFrameTick()
+{
+    // 两包之间按速度外推显示位置
+    qint64 now = m_clock.elapsed();
+    for (auto it = m_tags.begin(); it != m_tags.end(); ++it) {
+        Tag &tag = it.value();
+        if (tag.velocity.isNull()) continue;
+
+        qint64 age = qMin<qint64>(now - tag.fixMs, kPredictionHorizonMs);
+        QPointF predicted = tag.fixPos + tag.velocity * (age / 1000.0);
+        if ((predicted - tag.pos).manhattanLength() < 0.5) continue;
+
+        tag.pos = predicted;
+        m_grid.update(it.key(), predicted);
+        if (!tag.dirty) {
+            tag.dirty = true;
+            m_dirtyTags.append(it.key());
+        }
+    }
+
+    bool trailsExpired = !m_trailPaths.isEmpty() && now - m_trailLayoutMs >= TrailRefreshMs;
+    if (m_dirtyTags.isEmpty() && !m_transformDirty && m_trailDirtyTags.isEmpty() && !trailsExpired) return;
+
+    if (m_fitPending) {
+        m_fitPending = false;
+        calculateTransform();
+    }
+
+    // 视图变化时整屏重绘, 否则只重绘移动标签与变化轨迹的新旧区域
+    bool hadClusters = m_hasClusters;
+    QRegion trailRegion = layoutTrails(m_transformDirty);
+    bool fullRepaint = m_transformDirty || m_dirtyTags.size() > MaxPartialRepaintTags;
+
+    QRegion region;
+    if (!fullRepaint) {
+        for (int id : m_dirtyTags) {
+            auto it = m_tags.constFind(id);
+            if (it != m_tags.constEnd()) region += it->drawnRect.toAlignedRect();
+        }
+    }
+
+    layoutTags();
+
+    // 聚合的成员随任一标签移动而变化, 有聚合时整屏重绘
+    if (fullRepaint || hadClusters || m_hasClusters) {
+        update();
+    } else {
+        for (int id : m_dirtyTags) {
+            auto it = m_tags.constFind(id);
+            if (it != m_tags.constEnd()) region += it->drawnRect.toAlignedRect();
+        }
+        update(region + m_staleRegion + trailRegion);
+    }
+
+    for (int id : m_dirtyTags) {
+        auto it = m_tags.find(id);
+        if (it != m_tags.end()) it->dirty = false;
+    }
+    m_dirtyTags.clear();
+    m_transformDirty = false;
+}
+
+void MapWidget::setTrailLength(int seconds)
+{
+    m_trailSeconds = qMax(0, seconds);
+    if (m_trailSeconds == 0) m_trails.clear();
+    m_transformDirty = true;
+}
+
+int MapWidget::trailLength() const
+{
+    return m_trailSeconds;
+}
+
+void MapWidget::setTrailMemoryBudget(qint64 bytes)
+{
+    m_trails.setMemoryBudget(bytes);
+    m_transformDirty = true;
+}
+
+QRegion MapWidget::layoutTrails(bool all)
+{
+    for (int id : m_trailDirtyTags) {
+        auto it = m_tags.find(id);
+        if (it != m_tags.end()) it->trailDirty = false;
+    }
+
+    QRegion region;
+    if (m_trailSeconds == 0) {
+        m_trailPaths.clear();
+        m_trailDirtyTags.clear();
+        return region;
+    }
+
+    // 每条轨迹的绘制点数有上限, 与记录的历史长度无关
+    qint64 now = m_clock.elapsed();
+    qint64 since = now - qint64(m_trailSeconds) * 1000;
+    const QRectF viewport(rect());
+    const QRectF visibleWorld = QRectF(screenToWorld(viewport.topLeft()), screenToWorld(viewport.bottomRight())).normalized();
+    auto toScreen = [this](const QPointF &pos) { return worldToScreen(pos.x(), pos.y()); };
+
+    auto layoutOne = [&](int id) {
+        auto it = m_trailPaths.find(id);
+        if (it != m_trailPaths.end() && !it->stale) region += it->bounds.toAlignedRect();
+
+        const TrailStore::Trail *trail = m_trails.trail(id);
+        auto tag = m_tags.constFind(id);
+        if (!trail || tag == m_tags.constEnd()) {
+            if (it != m_trailPaths.end()) m_trailPaths.erase(it);
+            return;
+        }
+        if (it == m_trailPaths.end()) it = m_trailPaths.insert(id, TrailPath());
+
+        TrailPath &path = it.value();
+        TrailStore::decimate(*trail, since, toScreen, 2.0, MaxTrailPoints, path.points);
+        if (path.points.size() < 2) {
+            m_trailPaths.erase(it);
+            return;
+        }
+        path.bounds = path.points.boundingRect().adjusted(-2, -2, 2, 2);
+        path.worldBounds = QRectF(screenToWorld(path.bounds.topLeft()), screenToWorld(path.bounds.bottomRight())).normalized();
+        path.firstMs = trail->at(trail->lowerBound(since)).ms;
+        path.color = tag->color;
+        path.color.setAlpha(110);
+        path.stale = false;
+        region += path.bounds.toAlignedRect();
+    };
+
+    // 已布局过的轨迹 (连同最新的点) 整个在视口外时只扩展世界坐标范围, 不抽稀
+    auto cull = [&](int id) {
+        auto it = m_trailPaths.find(id);
+        auto tag = m_tags.constFind(id);
+        if (it == m_trailPaths.end() || tag == m_tags.constEnd()) return false;
+
+        QRectF world = it->worldBounds;
+        world.setLeft(qMin(world.left(), tag->fixPos.x()));
+        world.setRight(qMax(world.right(), tag->fixPos.x()));
+        world.setTop(qMin(world.top(), tag->fixPos.y()));
+        world.setBottom(qMax(world.bottom(), tag->fixPos.y()));
+        if (world.intersects(visibleWorld)) return false;
+
+        if (!it->stale) region += it->bounds.toAlignedRect();
+        it->worldBounds = world;
+        it->stale = true;
+        return true;
+    };
+
+    if (all) {
+        for (auto it = m_trailPaths.begin(); it != m_trailPaths.end(); ) {
+            if (m_trails.trail(it.key()))
+                ++it;
+            else
+                it = m_trailPaths.erase(it);
+        }
+        for (int id : m_trails.tagIds()) {
+            if (!cull(id)) layoutOne(id);
+        }
+        m_trailLayoutMs = now;
+    } else {
+        for (int id : m_trailDirtyTags) {
+            if (!cull(id)) layoutOne(id);
+        }
+        // 静止标签: 只重新抽稀尾部已过期的可见轨迹
+        if (now - m_trailLayoutMs >= TrailRefreshMs) {
+            m_trailExpired.clear();
+            for (auto it = m_trailPaths.constBegin(); it != m_trailPaths.constEnd(); ++it) {
+                if (!it->stale && it->firstMs < since) m_trailExpired.append(it.key());
+            }
+            for (int id : m_trailExpired) {
+                if (!cull(id)) layoutOne(id);
+            }
+            m_trailLayoutMs = now;
+        }
+    }
+    m_trailDirtyTags.clear();
+    return region;
+}
+
+void MapWidget::fitToView()
+{
+    m_autoFit = true;
+    m_fitPending = true;
+    m_transformDirty = true;
 }
 
 void MapWidget::calculateTransform()
 {
+    // 有基站时只按基站范围适配, 个别离群的定位结果不会让整个视图跳动
     double minX = 0, maxX = 100, minY = 0, maxY = 100;
     bool first = true;
 
@@ -87,7 +394,11 @@ void MapWidget::calculateTransform()
     };
 
     for (auto a : m_anchors) checkPoint(a.x, a.y);
-    for (auto t : m_tags) checkPoint(t.pos.x, t.pos.y);
+    if (m_anchors.isEmpty() && m_grid.size() > 0) {
+        QRectF tagBounds = m_grid.bounds();
+        checkPoint(tagBounds.left(), tagBounds.top());
+        checkPoint(tagBounds.right(), tagBounds.bottom());
+    }
 
     double dataW = maxX - minX;
     double dataH = maxY - minY;
@@ -100,13 +411,21 @@ void MapWidget::calculateTransform()
 
     double scaleX = screenW / dataW;
     double scaleY = screenH / dataH;
-    m_scale = qMin(scaleX, scaleY);
+    double scale = qBound(kMinScale, qMin(scaleX, scaleY), kMaxScale);
 
     double centerX = (minX + maxX) / 2.0;
     double centerY = (minY + maxY) / 2.0;
 
-    m_offsetX = width() / 2.0 - centerX * m_scale;
-    m_offsetY = height() / 2.0 + centerY * m_scale;
+    setView(scale, width() / 2.0 - centerX * scale, height() / 2.0 + centerY * scale);
+}
+
+void MapWidget::setView(double scale, double offsetX, double offsetY)
+{
+    m_scale = scale;
+    m_offsetX = offsetX;
+    m_offsetY = offsetY;
+    m_staticDirty = true;
+    m_transformDirty = true;
 }
 
 QPointF MapWidget::worldToScreen(double wx, double wy)
@@ -116,12 +435,325 @@ QPointF MapWidget::worldToScreen(double wx, double wy)
     return QPointF(sx, sy);
 }
 
-void MapWidget::paintEvent(QPaintEvent *)
+QPointF MapWidget::screenToWorld(const QPointF &sPos) const
 {
-    QPainter painter(this);
+    return QPointF((sPos.x() - m_offsetX) / m_scale, (m_offsetY - sPos.y()) / m_scale);
+}
+
+int MapWidget::tagAt(const QPoint &sPos) const
+{
+    // 拾取半径按屏幕像素给出
+    return m_grid.nearest(screenToWorld(sPos), kPickRadiusPx / m_scale);
+}
+
+int MapWidget::selectedTag() const
+{
+    return m_selectedTag;
+}
+
+void MapWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    // 左键拖动超过阈值后平移视图, 由下一帧统一重绘
+    if (event->buttons() & Qt::LeftButton) {
+        if (!m_dragging && (event->pos() - m_pressPos).manhattanLength() >= QApplication::startDragDistance()) {
+            m_dragging = true;
+            setCursor(Qt::ClosedHandCursor);
+            QToolTip::hideText();
+        }
+        if (m_dragging) {
+            QPoint delta = event->pos() - m_lastDragPos;
+            m_lastDragPos = event->pos();
+            m_autoFit = false;
+            m_fitPending = false;
+            setView(m_scale, m_offsetX + delta.x(), m_offsetY + delta.y());
+            return;
+        }
+    }
+
+    int id = tagAt(event->pos());
+    if (id != m_hoverTag) {
+        m_hoverTag = id;
+        auto it = m_tags.constFind(id);
+        if (it != m_tags.constEnd())
+            QToolTip::showText(event->globalPos(), tagLabel(id, *it), this);
+        else
+            QToolTip::hideText();
+    }
+    QWidget::mouseMoveEvent(event);
+}
+
+void MapWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_pressPos = event->pos();
+        m_lastDragPos = event->pos();
+        m_dragging = false;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void MapWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        if (m_dragging) {
+            m_dragging = false;
+            unsetCursor();
+        } else {
+            // 没有拖动时才算点选
+            int id = tagAt(event->pos());
+            if (id != m_selectedTag) {
+                m_selectedTag = id;
+                m_transformDirty = true;    // 下一帧整屏重绘选中外圈
+                emit tagSelected(id);
+            }
+        }
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void MapWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        fitToView();
+    QWidget::mouseDoubleClickEvent(event);
+}
+
+void MapWidget::wheelEvent(QWheelEvent *event)
+{
+    double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0) {
+        event->ignore();
+        return;
+    }
+
+    // 以光标处为中心缩放: 缩放前后光标下的世界坐标不变
+    double scale = qBound(kMinScale, m_scale * qPow(kZoomStep, steps), kMaxScale);
+    QPointF cursor = event->pos();
+    QPointF world = screenToWorld(cursor);
+    m_autoFit = false;
+    m_fitPending = false;
+    setView(scale, cursor.x() - world.x() * scale, cursor.y() + world.y() * scale);
+    event->accept();
+}
+
+void MapWidget::leaveEvent(QEvent *event)
+{
+    m_hoverTag = -1;
+    QWidget::leaveEvent(event);
+}
+
+QString MapWidget::tagLabel(int id, const Tag &tag) const
+{
+    return QString("T%1 (%2, %3)").arg(id).arg(qRound(tag.pos.x())).arg(qRound(tag.pos.y()));
+}
+
+void MapWidget::layoutTags()
+{
+    const double cell = ClusterCellPx;
+    const QRectF visible = QRectF(rect()).adjusted(-cell, -cell, cell, cell);
+    const QRectF visibleWorld = QRectF(screenToWorld(visible.topLeft()), screenToWorld(visible.bottomRight())).normalized();
+    const int cols = width() / ClusterCellPx + 1;
+    const int rows = height() / ClusterCellPx + 1;
+
+    auto cellKey = [](int cx, int cy) {
+        return (quint64(quint32(cx)) << 32) | quint32(cy);
+    };
+
+    // 1. 按屏幕网格聚合; 只从空间索引取视口内的标签
+    m_markers.clear();
+    m_cellMarker.clear();
+    m_staleRegion = QRegion();
+    m_hasClusters = false;
+    m_grid.forEachIn(visibleWorld, [&](int id, const QPointF &pos) {
+        QPointF sPos = worldToScreen(pos.x(), pos.y());
+        quint64 key = cellKey(qFloor(sPos.x() / cell), qFloor(sPos.y() / cell));
+        auto c = m_cellMarker.constFind(key);
+        if (c == m_cellMarker.constEnd()) {
+            Marker marker;
+            marker.pos = sPos;
+            marker.tagId = id;
+            marker.count = 1;
+            marker.showLabel = false;
+            m_cellMarker.insert(key, m_markers.size());
+            m_markers.append(marker);
+        } else {
+            Marker &marker = m_markers[c.value()];
+            if (marker.tagId >= 0) {
+                // 原来的单个标签并入聚合
+                Tag &first = m_tags[marker.tagId];
+                first.drawnRect = QRectF();
+                first.labelShown = false;
+                marker.tagId = -1;
+            }
+            ++marker.count;
+            marker.pos += (sPos - marker.pos) / marker.count;
+            Tag &tag = m_tags[id];
+            tag.drawnRect = QRectF();
+            tag.labelShown = false;
+            m_hasClusters = true;
+        }
+    });
+
+    // 2. 标记占用所在网格, 文字只画在没有被占用的网格上
+    m_labelCells.fill(0, cols * rows);
+    auto occupy = [&](const QRectF &r, bool test) {
+        int x0 = qBound(0, qFloor(r.left() / cell), cols - 1), x1 = qBound(0, qFloor(r.right() / cell), cols - 1);
+        int y0 = qBound(0, qFloor(r.top() / cell), rows - 1), y1 = qBound(0, qFloor(r.bottom() / cell), rows - 1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                quint8 &used = m_labelCells[y * cols + x];
+                if (test && used) return false;
+                if (!test) used = 1;
+            }
+        }
+        return true;
+    };
+
+    for (Marker &marker : m_markers) {
+        if (marker.tagId < 0) {
+            const QPixmap &sprite = clusterSprite(marker.count);
+            QSizeF size = sprite.size() / sprite.devicePixelRatio();
+            marker.rect = QRectF(marker.pos - QPointF(size.width() / 2, size.height() / 2), size);
+        } else {
+            marker.rect = QRectF(marker.pos.x() - 8, marker.pos.y() - 8, 16, 16);
+        }
+        occupy(marker.rect, false);
+    }
+
+    const double ascent = fontMetrics().ascent();
+    for (Marker &marker : m_markers) {
+        if (marker.tagId < 0) continue;
+
+        // 先按文字尺寸决定是否显示, 被挤掉的文字不生成图片
+        Tag &tag = m_tags[marker.tagId];
+        QRectF textRect(marker.pos + QPointF(12, 5 - ascent), labelSize(marker.tagId, tag));
+        // 文字从标记右侧开始, 不与自己的标记所在网格比较
+        QRectF testRect = textRect.adjusted(cell, 0, 0, 0);
+        marker.showLabel = testRect.width() <= 0 || occupy(testRect, true);
+        if (marker.showLabel) {
+            occupy(testRect, false);
+            labelPixmap(marker.tagId, tag);
+        }
+
+        QRectF drawn = (marker.showLabel ? marker.rect.united(textRect) : marker.rect).adjusted(-2, -2, 2, 2);
+        // 被移动的标签挤掉或让出文字位置的静止标签也要重绘
+        if (marker.showLabel != tag.labelShown && !tag.dirty) {
+            m_staleRegion += tag.drawnRect.toAlignedRect();
+            m_staleRegion += drawn.toAlignedRect();
+        }
+        tag.drawnRect = drawn;
+        tag.labelShown = marker.showLabel;
+    }
+
+    // 选中标记的外圈 (聚合中的标签也画)
+    auto selected = m_tags.find(m_selectedTag);
+    if (selected != m_tags.end()) {
+        QPointF sPos = worldToScreen(selected->pos.x(), selected->pos.y());
+        selected->drawnRect = selected->drawnRect.united(selectionRect(sPos));
+    }
+}
+
+QRectF MapWidget::selectionRect(const QPointF &sPos) const
+{
+    return QRectF(sPos.x() - 12, sPos.y() - 12, 24, 24);
+}
+
+QSizeF MapWidget::labelSize(int id, const Tag &tag) const
+{
+    QPoint value(qRound(tag.pos.x()), qRound(tag.pos.y()));
+    if (!tag.label.isNull() && value == tag.labelValue)
+        return tag.label.size() / tag.label.devicePixelRatio();
+
+    // 与 labelPixmap 生成的图片尺寸一致
+    QFontMetrics fm = fontMetrics();
+    return QSizeF(fm.boundingRect(tagLabel(id, tag)).width() + 2, fm.height());
+}
+
+const QPixmap &MapWidget::labelPixmap(int id, Tag &tag)
+{
+    QPoint value(qRound(tag.pos.x()), qRound(tag.pos.y()));
+    if (!tag.label.isNull() && value == tag.labelValue) return tag.label;
+
+    QString text = tagLabel(id, tag);
+    QFontMetrics fm = fontMetrics();
+    qreal dpr = devicePixelRatioF();
+    QSize size(fm.boundingRect(text).width() + 2, fm.height());
+
+    tag.label = QPixmap(size * dpr);
+    tag.label.setDevicePixelRatio(dpr);
+    tag.label.fill(Qt::transparent);
+    QPainter painter(&tag.label);
+    painter.setFont(font());
+    painter.setPen(tag.color);
+    painter.drawText(QPointF(1, fm.ascent()), text);
+    tag.labelValue = value;
+    return tag.label;
+}
+
+const QPixmap &MapWidget::markerSprite(const QColor &color)
+{
+    auto it = m_markerSprites.constFind(color.rgba());
+    if (it != m_markerSprites.constEnd()) return it.value();
+
+    qreal dpr = devicePixelRatioF();
+    QPixmap sprite(QSize(16, 16) * dpr);
+    sprite.setDevicePixelRatio(dpr);
+    sprite.fill(Qt::transparent);
+    QPainter painter(&sprite);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setBrush(color);
+    painter.setPen(QPen(Qt::black, 1));
+    painter.drawEllipse(QPointF(8, 8), 6, 6);
+    return m_markerSprites.insert(color.rgba(), sprite).value();
+}
+
+const QPixmap &MapWidget::clusterSprite(int count)
+{
+    auto it = m_clusterSprites.constFind(count);
+    if (it != m_clusterSprites.constEnd()) return it.value();
+    if (m_clusterSprites.size() > 1024) m_clusterSprites.clear();
+
+    QString text = QString::number(count);
+    QFontMetrics fm = fontMetrics();
+    int diameter = qMax(22, fm.boundingRect(text).width() + 10);
+    qreal dpr = devicePixelRatioF();
+
+    QPixmap sprite(QSize(diameter, diameter) * dpr);
+    sprite.setDevicePixelRatio(dpr);
+    sprite.fill(Qt::transparent);
+    QPainter painter(&sprite);
     painter.setRenderHint(QPainter::Antialiasing);
+    painter.setBrush(QColor(220, 60, 40, 200));
+    painter.setPen(QPen(Qt::black, 1));
+    painter.drawEllipse(QRectF(0.5, 0.5, diameter - 1, diameter - 1));
+    painter.setPen(Qt::white);
+    painter.drawText(QRectF(0, 0, diameter, diameter), Qt::AlignCenter, text);
+    return m_clusterSprites.insert(count, sprite).value();
+}
+
+void MapWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    // 手动视图下保持中心处的世界坐标不变
+    QSize oldSize = event->oldSize();
+    if (m_autoFit || !oldSize.isValid())
+        calculateTransform();
+    else
+        setView(m_scale, m_offsetX + (width() - oldSize.width()) / 2.0, m_offsetY + (height() - oldSize.height()) / 2.0);
+    layoutTags();
+    layoutTrails(true);
+}
 
-    calculateTransform();
+void MapWidget::renderStaticLayer()
+{
+    qreal dpr = devicePixelRatioF();
+    m_staticLayer = QPixmap(size() * dpr);
+    m_staticLayer.setDevicePixelRatio(dpr);
+    m_staticLayer.fill(Qt::white);
+
+    QPainter painter(&m_staticLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
     drawGrid(painter);
 
     // 绘制基站
@@ -142,18 +774,114 @@ void MapWidget::paintEvent(QPaintEvent *)
         painter.setPen(Qt::black);
         painter.drawText(sPos + QPointF(16, 5), QString("A%1").arg(it.key()));
     }
+    m_staticDirty = false;
+}
 
-    // 绘制标签
-    for (auto it = m_tags.begin(); it != m_tags.end(); ++it) {
-        QPointF sPos = worldToScreen(it.value().pos.x, it.value().pos.y);
+void MapWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // 变换与布局由帧定时器/resize 计算, 局部重绘时必须与上一帧一致
+    const QRegion &dirty = event->region();
+    bool fullFrame = dirty.boundingRect().contains(rect());
+
+    // 静态层整张贴出, 由 Qt 按重绘区域裁剪
+    if (m_staticDirty || m_staticLayer.size() != size() * devicePixelRatioF())
+        renderStaticLayer();
+    painter.drawPixmap(0, 0, m_staticLayer);
+
+    // 轨迹画在标签下面
+    if (!m_trailPaths.isEmpty()) {
+        painter.setBrush(Qt::NoBrush);
+        for (auto it = m_trailPaths.constBegin(); it != m_trailPaths.constEnd(); ++it) {
+            const TrailPath &path = it.value();
+            if (path.stale || (!fullFrame && !dirty.intersects(path.bounds.toAlignedRect()))) continue;
+            painter.setPen(QPen(path.color, 1.5));
+            painter.drawPolyline(path.points);
+        }
+    }
+
+    // 绘制标签: 只贴缓存的图, 同色标记合并为一次 drawPixmapFragments
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    const QPixmap *batchSprite = nullptr;
+    m_fragments.clear();
+    auto flushMarkers = [&]() {
+        if (!m_fragments.isEmpty())
+            painter.drawPixmapFragments(m_fragments.constData(), m_fragments.size(), *batchSprite);
+        m_fragments.clear();
+    };
+
+    for (const Marker &marker : m_markers) {
+        if (!fullFrame && !dirty.intersects(marker.rect.toAlignedRect())) continue;
+
+        if (marker.tagId < 0) {
+            painter.drawPixmap(marker.rect.topLeft(), clusterSprite(marker.count));
+            continue;
+        }
+
+        const QPixmap &sprite = markerSprite(m_tags[marker.tagId].color);
+        if (&sprite != batchSprite) {
+            flushMarkers();
+            batchSprite = &sprite;
+        }
+        qreal inv = 1.0 / sprite.devicePixelRatio();
+        m_fragments.append(QPainter::PixmapFragment::create(marker.pos, QRectF(QPointF(0, 0), sprite.size()), inv, inv));
+    }
+    flushMarkers();
+
+    const double ascent = fontMetrics().ascent();
+    for (const Marker &marker : m_markers) {
+        if (marker.tagId < 0 || !marker.showLabel) continue;
+        const Tag &tag = m_tags[marker.tagId];
+        if (!fullFrame && !dirty.intersects(tag.drawnRect.toAlignedRect())) continue;
+        painter.drawPixmap(marker.pos + QPointF(12, 5 - ascent), tag.label);
+    }
 
-        painter.setBrush(it.value().color);
-        painter.setPen(QPen(Qt::black, 1));
-        painter.drawEllipse(sPos, 6, 6);
+    auto selected = m_tags.constFind(m_selectedTag);
+    if (selected != m_tags.constEnd()) {
+        QPointF sPos = worldToScreen(selected->pos.x(), selected->pos.y());
+        if (fullFrame || dirty.intersects(selectionRect(sPos).toAlignedRect())) {
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setBrush(Qt::NoBrush);
+            painter.setPen(QPen(QColor(30, 110, 220), 2));
+            painter.drawEllipse(sPos, 10, 10);
+        }
+    }
 
-        painter.setPen(it.value().color);
-        QString text = QString("T%1 (%2, %3)").arg(it.key()).arg((int)it.value().pos.x).arg((int)it.value().pos.y);
-        painter.drawText(sPos + QPointF(12, 5), text);
+    if (!m_hudLines.isEmpty() && (fullFrame || dirty.intersects(m_hudRect))) {
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0, 0, 0, 170));
+        painter.drawRoundedRect(m_hudRect, 4, 4);
+        painter.setFont(m_hudFont);
+        painter.setPen(Qt::white);
+        QFontMetrics fm(m_hudFont);
+        int y = m_hudRect.top() + 6 + fm.ascent();
+        for (const QString &line : m_hudLines) {
+            painter.drawText(m_hudRect.left() + 8, y, line);
+            y += fm.lineSpacing();
+        }
+    }
+
+    // 只统计本次确实按新位置重绘到的标签; 尚未经过帧布局的留到下一次, 屏幕外的不计入
+    if (!m_tracedTags.isEmpty()) {
+        qint64 now = m_latencyClock.nsecsElapsed();
+        int pending = 0;
+        for (int id : m_tracedTags) {
+            auto it = m_tags.find(id);
+            if (it == m_tags.end() || it->traceReadNs == 0) continue;
+            if (it->dirty) {
+                m_tracedTags[pending++] = id;
+                continue;
+            }
+            if (fullFrame || dirty.intersects(it->drawnRect.toAlignedRect())) {
+                m_latency->record(LatencyStats::StagePaint, now - it->traceUpdateNs);
+                m_latency->record(LatencyStats::StageTotal, now - it->traceReadNs);
+            }
+            it->traceReadNs = 0;
+        }
+        m_tracedTags.resize(pending);
     }
 }
 
@@ -182,25 +910,83 @@ void MapWidget::drawGrid(QPainter &painter)
 // ==========================================
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), m_serial(new QSerialPort(this))
+    : QMainWindow(parent), m_engine(new PositionEngine), m_engineThread(new QThread(this)),
+      m_feed(new FeedPublisher), m_feedThread(new QThread(this)), m_connected(false),
+      m_pendingPorts(0), m_replayFirstNs(0), m_replayLastNs(0), m_feedTcpPort(0), m_latencyExportMs(0), m_tagStatsMs(0)
 {
     setWindowTitle("UWB Positioning Tools");
     resize(1200, 800);
 
     m_settings = new QSettings("Makerfabs", "UWB_Qt_Cpp", this);
 
+    // 串口接收与解算放在独立线程, GUI 卡顿不影响数据接收
+    m_engine->moveToThread(m_engineThread);
+    connect(m_engineThread, &QThread::finished, m_engine, &QObject::deleteLater);
+    connect(m_engine, &PositionEngine::portOpened, this, &MainWindow::onPortOpened);
+    connect(m_engine, &PositionEngine::portOpenFailed, this, &MainWindow::onPortOpenFailed);
+    connect(m_engine, &PositionEngine::portClosed, this, &MainWindow::onPortClosed);
+    connect(m_engine, &PositionEngine::portLost, this, &MainWindow::onPortLost);
+    connect(m_engine, &PositionEngine::fixesReady, this, &MainWindow::onFixesReady);
+    connect(m_engine, &PositionEngine::captureStarted, this, &MainWindow::onCaptureStarted);
+    connect(m_engine, &PositionEngine::captureStopped, this, &MainWindow::onCaptureStopped);
+    connect(m_engine, &PositionEngine::captureError, this, &MainWindow::onCaptureError);
+    connect(m_engine, &PositionEngine::replayStarted, this, &MainWindow::onReplayStarted);
+    connect(m_engine, &PositionEngine::replayProgress, this, &MainWindow::onReplayProgress);
+    connect(m_engine, &PositionEngine::replayFinished, this, &MainWindow::onReplayFinished);
+    connect(m_engine, &PositionEngine::replayError, this, [=](const QString &error){
+        logMessage("System: Replay failed: " + error, LogRecord::Error);
+    });
+    connect(m_engine, &PositionEngine::sharedMemoryStarted, this, [=](const QString &name){
+        logMessage("System: Publishing positions to shared memory " + name);
+    });
+    connect(m_engine, &PositionEngine::sharedMemoryError, this, [=](const QString &error){
+        logMessage("System: Shared memory feed failed: " + error, LogRecord::Error);
+    });
+
+    // 局域网发布在独立线程, 网络发送不占用解算线程
+    m_feed->moveToThread(m_feedThread);
+    connect(m_feedThread, &QThread::finished, m_feed, &QObject::deleteLater);
+    connect(m_feed, &FeedPublisher::udpStarted, this, [=](const QString &target){
+        logMessage("System: Publishing positions over UDP to " + target);
+    });
+    connect(m_feed, &FeedPublisher::udpError, this, [=](const QString &error){
+        logMessage("System: UDP feed failed: " + error, LogRecord::Error);
+    });
+    connect(m_feed, &FeedPublisher::tcpListening, this, [=](quint16 port){
+        logMessage(QString("System: Position feed listening on TCP port %1").arg(port));
+    });
+    connect(m_feed, &FeedPublisher::tcpError, this, [=](const QString &error){
+        logMessage("System: TCP feed failed: " + error, LogRecord::Error);
+    });
+    connect(m_feed, &FeedPublisher::clientConnected, this, [=](const QString &peer){
+        logMessage("System: Feed subscriber connected: " + peer);
+    });
+    connect(m_feed, &FeedPublisher::clientDisconnected, this, [=](const QString &peer){
+        logMessage("System: Feed subscriber disconnected: " + peer);
+    });
+    m_feedThread->start();
+    m_engine->setFeedPublisher(m_feed);
+
+    m_engineThread->start();
+
     initUI();
     loadSettings();
 
-    connect(m_serial, &QSerialPort::readyRead, this, &MainWindow::onSerialReadyRead);
-    connect(m_serial, &QSerialPort::errorOccurred, this, &MainWindow::onSerialError);
+    // 地图与引擎使用同一时钟, 才能统计从串口到绘制的延迟
+    m_mapWidget->setLatencyStats(m_engine->latencyStats(), m_engine->clock());
+    m_latencyTimer = new QTimer(this);
+    connect(m_latencyTimer, &QTimer::timeout, this, &MainWindow::onLatencyTimer);
+    m_latencyTimer->start(kLatencyHudIntervalMs);
 }
 
 MainWindow::~MainWindow()
 {
     saveSettings();
-    if (m_serial->isOpen())
-        m_serial->close();
+    QMetaObject::invokeMethod(m_engine, "closePorts", Qt::BlockingQueuedConnection);
+    m_engineThread->quit();
+    m_engineThread->wait();
+    m_feedThread->quit();
+    m_feedThread->wait();
 }
 
 void MainWindow::initUI()
@@ -220,7 +1006,9 @@ void MainWindow::initUI()
     QGroupBox *gbSerial = new QGroupBox("Communication Settings", this);
     QVBoxLayout *vboxSerial = new QVBoxLayout(gbSerial);
 
-    m_comboPorts = new QComboBox(this);
+    // 可同时勾选多个监听节点的串口
+    m_listPorts = new QListWidget(this);
+    m_listPorts->setMaximumHeight(90);
     QPushButton *btnRefresh = new QPushButton("Refresh Ports", this);
     connect(btnRefresh, &QPushButton::clicked, this, &MainWindow::refreshPorts);
 
@@ -231,12 +1019,46 @@ void MainWindow::initUI()
     QPushButton *btnConfigTools = new QPushButton("Config Tools", this);
     connect(btnConfigTools, &QPushButton::clicked, this, &MainWindow::onOpenExternalApp);
 
-    vboxSerial->addWidget(new QLabel("Port:", this));
-    vboxSerial->addWidget(m_comboPorts);
+    // 枚举不到的端口 (如 uwbsim 创建的伪终端) 可直接输入路径, 回车加入列表并勾选
+    m_editExtraPort = new QLineEdit(this);
+    m_editExtraPort->setPlaceholderText("Other port, e.g. /dev/pts/3");
+    connect(m_editExtraPort, &QLineEdit::returnPressed, this, [=](){
+        QString path = m_editExtraPort->text().trimmed();
+        if (path.isEmpty()) return;
+        if (!m_extraPorts.contains(path)) m_extraPorts.append(path);
+        refreshPorts();
+        for (QListWidgetItem *item : m_listPorts->findItems(path, Qt::MatchExactly))
+            item->setCheckState(Qt::Checked);
+        m_editExtraPort->clear();
+    });
+
+    vboxSerial->addWidget(new QLabel("Ports:", this));
+    vboxSerial->addWidget(m_listPorts);
+    vboxSerial->addWidget(m_editExtraPort);
     vboxSerial->addWidget(btnRefresh);
     vboxSerial->addWidget(m_btnConnect);
     vboxSerial->addWidget(btnConfigTools);
 
+    // 会话录制: 按大小或时长滚动
+    m_btnCapture = new QPushButton("Record Session...", this);
+    m_btnCapture->setCheckable(true);
+    connect(m_btnCapture, &QPushButton::clicked, this, &MainWindow::toggleCapture);
+
+    QHBoxLayout *hboxCapture = new QHBoxLayout();
+    m_spinCaptureMB = new QSpinBox(this);
+    m_spinCaptureMB->setRange(1, 4096);
+    m_spinCaptureMB->setValue(256);
+    m_spinCaptureMB->setSuffix(" MB");
+    m_spinCaptureMinutes = new QSpinBox(this);
+    m_spinCaptureMinutes->setRange(1, 24 * 60);
+    m_spinCaptureMinutes->setValue(60);
+    m_spinCaptureMinutes->setSuffix(" min");
+    hboxCapture->addWidget(new QLabel("Rotate:"));
+    hboxCapture->addWidget(m_spinCaptureMB);
+    hboxCapture->addWidget(m_spinCaptureMinutes);
+    vboxSerial->addWidget(m_btnCapture);
+    vboxSerial->addLayout(hboxCapture);
+
     // 2. anchor config
     QGroupBox *gbAnchors = new QGroupBox("Anchor Configuration (ID | X | Y)", this);
     QVBoxLayout *vboxAnchors = new QVBoxLayout(gbAnchors);
@@ -287,11 +1109,258 @@ void MainWindow::initUI()
     m_spinThreshold->setRange(0, 100);
     m_spinThreshold->setValue(10.0);
     hboxThreshold->addWidget(m_spinThreshold);
+    connect(m_spinThreshold, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::publishConfig);
+
+    QHBoxLayout *hboxFrameRate = new QHBoxLayout();
+    hboxFrameRate->addWidget(new QLabel("Display Rate (fps):"));
+    m_spinFrameRate = new QSpinBox(this);
+    m_spinFrameRate->setRange(1, 120);
+    m_spinFrameRate->setValue(30);
+    hboxFrameRate->addWidget(m_spinFrameRate);
+    connect(m_spinFrameRate, QOverload<int>::of(&QSpinBox::valueChanged), m_mapWidget, &MapWidget::setFrameRate);
+
+    QHBoxLayout *hboxTrail = new QHBoxLayout();
+    hboxTrail->addWidget(new QLabel("Trail (s):"));
+    m_spinTrailSeconds = new QSpinBox(this);
+    m_spinTrailSeconds->setRange(0, 3600);
+    m_spinTrailSeconds->setSpecialValueText("Off");
+    m_spinTrailSeconds->setValue(0);
+    hboxTrail->addWidget(m_spinTrailSeconds);
+    hboxTrail->addWidget(new QLabel("Memory (MB):"));
+    m_spinTrailMemoryMB = new QSpinBox(this);
+    m_spinTrailMemoryMB->setRange(1, 1024);
+    m_spinTrailMemoryMB->setValue(32);
+    hboxTrail->addWidget(m_spinTrailMemoryMB);
+    connect(m_spinTrailSeconds, QOverload<int>::of(&QSpinBox::valueChanged), m_mapWidget, &MapWidget::setTrailLength);
+    connect(m_spinTrailMemoryMB, QOverload<int>::of(&QSpinBox::valueChanged), this, [=](int mb){
+        m_mapWidget->setTrailMemoryBudget(qint64(mb) * 1024 * 1024);
+    });
 
+    QPushButton *btnFitView = new QPushButton("Fit View", this);
+    btnFitView->setToolTip("Wheel to zoom, drag to pan, double-click the map to fit");
+    hboxFrameRate->addWidget(btnFitView);
+    connect(btnFitView, &QPushButton::clicked, m_mapWidget, &MapWidget::fitToView);
+
+    QHBoxLayout *hboxSolver = new QHBoxLayout();
+    hboxSolver->addWidget(new QLabel("Solver:"));
+    m_comboSolver = new QComboBox(this);
+    m_comboSolver->addItem("Closed-form (linearized)", SolverClosedForm);
+    m_comboSolver->addItem("Gauss-Newton (warm start)", SolverGaussNewton);
+    m_comboSolver->addItem("Robust (reject NLOS ranges)", SolverRobust);
+    hboxSolver->addWidget(m_comboSolver, 1);
+    connect(m_comboSolver, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::applySolverSettings);
+
+    QHBoxLayout *hboxRobust = new QHBoxLayout();
+    hboxRobust->addWidget(new QLabel("Outlier (cm):"));
+    m_spinRobustThreshold = new QDoubleSpinBox(this);
+    m_spinRobustThreshold->setRange(1, 1000);
+    m_spinRobustThreshold->setValue(50.0);
+    hboxRobust->addWidget(m_spinRobustThreshold);
+    hboxRobust->addWidget(new QLabel("Budget (us):"));
+    m_spinRobustBudget = new QSpinBox(this);
+    m_spinRobustBudget->setRange(0, 10000);
+    m_spinRobustBudget->setSpecialValueText("Unlimited");
+    m_spinRobustBudget->setValue(50);
+    hboxRobust->addWidget(m_spinRobustBudget);
+    connect(m_spinRobustThreshold, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::publishConfig);
+    connect(m_spinRobustBudget, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::publishConfig);
+
+    QHBoxLayout *hboxFilter = new QHBoxLayout();
+    hboxFilter->addWidget(new QLabel("Filter:"));
+    m_comboFilter = new QComboBox(this);
+    m_comboFilter->addItem("Kalman (constant velocity)", FilterKalman);
+    m_comboFilter->addItem("EMA + threshold", FilterEma);
+    hboxFilter->addWidget(m_comboFilter, 1);
+
+    QHBoxLayout *hboxNoise = new QHBoxLayout();
+    hboxNoise->addWidget(new QLabel("Process (cm/s^2):"));
+    m_spinProcessNoise = new QDoubleSpinBox(this);
+    m_spinProcessNoise->setRange(0, 10000);
+    m_spinProcessNoise->setValue(100.0);
+    hboxNoise->addWidget(m_spinProcessNoise);
+    hboxNoise->addWidget(new QLabel("Meas. (cm):"));
+    m_spinMeasurementNoise = new QDoubleSpinBox(this);
+    m_spinMeasurementNoise->setRange(0.1, 1000);
+    m_spinMeasurementNoise->setValue(15.0);
+    hboxNoise->addWidget(m_spinMeasurementNoise);
+
+    connect(m_comboFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::applyFilterSettings);
+    connect(m_spinProcessNoise, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::applyFilterSettings);
+    connect(m_spinMeasurementNoise, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::applyFilterSettings);
+
+    vboxAlgo->addLayout(hboxSolver);
+    vboxAlgo->addLayout(hboxRobust);
+    vboxAlgo->addLayout(hboxFilter);
+    vboxAlgo->addLayout(hboxNoise);
     vboxAlgo->addLayout(hboxThreshold);
+    vboxAlgo->addLayout(hboxFrameRate);
+    vboxAlgo->addLayout(hboxTrail);
     gbAlgorithm->setLayout(vboxAlgo);
 
-    // 4. Log Output
+    // 4. Capture replay
+    QGroupBox *gbReplay = new QGroupBox("Capture Replay", this);
+    QVBoxLayout *vboxReplay = new QVBoxLayout(gbReplay);
+
+    QHBoxLayout *hboxReplayCtrl = new QHBoxLayout();
+    m_btnReplayOpen = new QPushButton("Open Capture...", this);
+    m_btnReplayStop = new QPushButton("Stop", this);
+    m_btnReplayStop->setEnabled(false);
+    m_comboReplaySpeed = new QComboBox(this);
+    m_comboReplaySpeed->addItem("1x", 1.0);
+    m_comboReplaySpeed->addItem("10x", 10.0);
+    m_comboReplaySpeed->addItem("Max", 0.0);
+    hboxReplayCtrl->addWidget(m_btnReplayOpen, 1);
+    hboxReplayCtrl->addWidget(m_comboReplaySpeed);
+    hboxReplayCtrl->addWidget(m_btnReplayStop);
+
+    QHBoxLayout *hboxReplaySeek = new QHBoxLayout();
+    m_sliderReplay = new QSlider(Qt::Horizontal, this);
+    m_sliderReplay->setRange(0, 1000);
+    m_sliderReplay->setEnabled(false);
+    m_lblReplayTime = new QLabel("--:--", this);
+    hboxReplaySeek->addWidget(m_sliderReplay, 1);
+    hboxReplaySeek->addWidget(m_lblReplayTime);
+
+    vboxReplay->addLayout(hboxReplayCtrl);
+    vboxReplay->addLayout(hboxReplaySeek);
+
+    connect(m_btnReplayOpen, &QPushButton::clicked, this, &MainWindow::openReplay);
+    connect(m_btnReplayStop, &QPushButton::clicked, this, [=](){
+        QMetaObject::invokeMethod(m_engine, "stopReplay", Qt::QueuedConnection);
+    });
+    connect(m_comboReplaySpeed, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=](int){
+        double speed = m_comboReplaySpeed->currentData().toDouble();
+        QMetaObject::invokeMethod(m_engine, [=](){ m_engine->setReplaySpeed(speed); }, Qt::QueuedConnection);
+    });
+    connect(m_sliderReplay, &QSlider::sliderReleased, this, [=](){
+        qint64 timeNs = m_replayFirstNs + (m_replayLastNs - m_replayFirstNs) * m_sliderReplay->value() / 1000;
+        QMetaObject::invokeMethod(m_engine, [=](){ m_engine->seekReplay(timeNs); }, Qt::QueuedConnection);
+    });
+
+    // 5. Position feed
+    QGroupBox *gbFeed = new QGroupBox("Position Feed", this);
+    QVBoxLayout *vboxFeed = new QVBoxLayout(gbFeed);
+
+    QHBoxLayout *hboxFeedUdp = new QHBoxLayout();
+    m_checkFeedUdp = new QCheckBox("UDP", this);
+    m_editFeedUdp = new QLineEdit("239.255.42.1:7410", this);
+    m_editFeedUdp->setToolTip("Multicast group or unicast address, e.g. 127.0.0.1:7410");
+    hboxFeedUdp->addWidget(m_checkFeedUdp);
+    hboxFeedUdp->addWidget(m_editFeedUdp, 1);
+
+    QHBoxLayout *hboxFeedTcp = new QHBoxLayout();
+    m_checkFeedTcp = new QCheckBox("TCP port", this);
+    m_spinFeedTcpPort = new QSpinBox(this);
+    m_spinFeedTcpPort->setRange(1, 65535);
+    m_spinFeedTcpPort->setValue(7411);
+    hboxFeedTcp->addWidget(m_checkFeedTcp);
+    hboxFeedTcp->addWidget(m_spinFeedTcpPort, 1);
+
+    QHBoxLayout *hboxFeedShm = new QHBoxLayout();
+    m_checkFeedShm = new QCheckBox("Shared memory", this);
+    m_editFeedShm = new QLineEdit(UwbShm::DefaultName, this);
+    m_editFeedShm->setToolTip("POSIX shared memory name read by local consumers (uwbshm/uwbshm.h)");
+    hboxFeedShm->addWidget(m_checkFeedShm);
+    hboxFeedShm->addWidget(m_editFeedShm, 1);
+#ifdef Q_OS_WIN
+    m_checkFeedShm->setEnabled(false);
+    m_editFeedShm->setEnabled(false);
+#endif
+
+    vboxFeed->addLayout(hboxFeedUdp);
+    vboxFeed->addLayout(hboxFeedTcp);
+    vboxFeed->addLayout(hboxFeedShm);
+
+    connect(m_checkFeedUdp, &QCheckBox::toggled, this, &MainWindow::applyFeedSettings);
+    connect(m_editFeedUdp, &QLineEdit::editingFinished, this, &MainWindow::applyFeedSettings);
+    connect(m_checkFeedTcp, &QCheckBox::toggled, this, &MainWindow::applyFeedSettings);
+    connect(m_spinFeedTcpPort, &QSpinBox::editingFinished, this, &MainWindow::applyFeedSettings);
+    connect(m_checkFeedShm, &QCheckBox::toggled, this, &MainWindow::applyFeedSettings);
+    connect(m_editFeedShm, &QLineEdit::editingFinished, this, &MainWindow::applyFeedSettings);
+
+    // 6. Diagnostics: 分阶段延迟与各标签丢包
+    QGroupBox *gbLatency = new QGroupBox("Diagnostics", this);
+    QVBoxLayout *vboxLatency = new QVBoxLayout(gbLatency);
+
+    m_checkLatencyHud = new QCheckBox("Show latency overlay on map", this);
+    vboxLatency->addWidget(m_checkLatencyHud);
+
+    QHBoxLayout *hboxLatencyExport = new QHBoxLayout();
+    m_checkLatencyExport = new QCheckBox("CSV", this);
+    m_editLatencyExport = new QLineEdit(QDir(QDir::homePath()).filePath("uwbserial-latency.csv"), this);
+    m_editLatencyExport->setToolTip("Per-stage latency histograms are appended to this file");
+    m_spinLatencyExportSec = new QSpinBox(this);
+    m_spinLatencyExportSec->setRange(1, 3600);
+    m_spinLatencyExportSec->setValue(10);
+    m_spinLatencyExportSec->setSuffix(" s");
+    hboxLatencyExport->addWidget(m_checkLatencyExport);
+    hboxLatencyExport->addWidget(m_editLatencyExport, 1);
+    hboxLatencyExport->addWidget(m_spinLatencyExportSec);
+    vboxLatency->addLayout(hboxLatencyExport);
+
+    QHBoxLayout *hboxTagStats = new QHBoxLayout();
+    m_checkTagStats = new QCheckBox("Show per-tag link statistics", this);
+    QPushButton *btnTagStatsReset = new QPushButton("Reset", this);
+    hboxTagStats->addWidget(m_checkTagStats, 1);
+    hboxTagStats->addWidget(btnTagStatsReset);
+    vboxLatency->addLayout(hboxTagStats);
+
+    m_lblMergeStats = new QLabel(this);
+    m_lblMergeStats->setToolTip("Copies of the same packet heard by several ports: merged within the reorder window, or dropped when they arrive after it");
+    m_lblMergeStats->setVisible(false);
+    vboxLatency->addWidget(m_lblMergeStats);
+
+    // 地图下方的统计表, 数值列按数值排序
+    m_tableTagStats = new QTableWidget(0, 10, this);
+    m_tableTagStats->setHorizontalHeaderLabels({"Tag", "Rate (Hz)", "Interval (ms)", "Received", "Lost",
+                                                "Loss %", "Duplicate", "Out of Order", "Resync", "Jitter (ms)"});
+    m_tableTagStats->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_tableTagStats->verticalHeader()->setVisible(false);
+    m_tableTagStats->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableTagStats->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_tableTagStats->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_tableTagStats->setSortingEnabled(true);
+    m_tableTagStats->sortByColumn(5, Qt::DescendingOrder);
+    m_tableTagStats->setVisible(false);
+
+    m_tagStatsTimer = new QTimer(this);
+    connect(m_tagStatsTimer, &QTimer::timeout, this, &MainWindow::onTagStatsTimer);
+    connect(m_checkTagStats, &QCheckBox::toggled, this, [=](bool on){
+        m_tableTagStats->setVisible(on);
+        m_lblMergeStats->setVisible(on);
+        if (on) {
+            m_tagStatsMs = 0;
+            m_tagStatsTimer->start(kTagStatsIntervalMs);
+            onTagStatsTimer();
+        } else {
+            m_tagStatsTimer->stop();
+        }
+    });
+    connect(btnTagStatsReset, &QPushButton::clicked, this, [=](){
+        QMetaObject::invokeMethod(m_engine, [=](){ m_engine->resetSequenceStats(); }, Qt::QueuedConnection);
+        m_tagStatsReceived.clear();
+        m_tableTagStats->setRowCount(0);
+        m_lblMergeStats->clear();
+    });
+
+    // 浮层或 CSV 导出开启时才让各线程取时间戳并记录
+    auto updateLatencyEnabled = [=](){
+        m_engine->latencyStats()->setEnabled(m_checkLatencyHud->isChecked() || m_checkLatencyExport->isChecked());
+    };
+    connect(m_checkLatencyHud, &QCheckBox::toggled, this, [=](bool on){
+        updateLatencyEnabled();
+        if (!on) m_mapWidget->setHudText(QStringList());
+    });
+    connect(m_checkLatencyExport, &QCheckBox::toggled, this, [=](bool on){
+        updateLatencyEnabled();
+        // 从开启时起算第一段
+        if (!on) return;
+        for (int i = 0; i < LatencyStats::StageCount; ++i)
+            m_latencyExportBase[i] = m_engine->latencyStats()->snapshot(LatencyStats::Stage(i));
+        m_latencyExportMs = QDateTime::currentMSecsSinceEpoch();
+    });
+
+    // 7. Log Output
     QGroupBox *gbLog = new QGroupBox("System Log", this);
     QVBoxLayout *vboxLog = new QVBoxLayout(gbLog);
 
@@ -300,27 +1369,108 @@ void MainWindow::initUI()
     m_lblConnection->setStyleSheet("background-color: #eee; padding: 5px; border-radius: 4px;");
     vboxLog->addWidget(m_lblConnection);
 
-    m_txtLog = new QTextEdit(this);
-    m_txtLog->setReadOnly(true);
+    QHBoxLayout *hboxLogFilter = new QHBoxLayout();
+    hboxLogFilter->addWidget(new QLabel("Tag:"));
+    m_spinLogTag = new QSpinBox(this);
+    m_spinLogTag->setRange(-1, 65535);
+    m_spinLogTag->setValue(-1);
+    m_spinLogTag->setSpecialValueText("All");
+    hboxLogFilter->addWidget(m_spinLogTag, 1);
+    hboxLogFilter->addWidget(new QLabel("Level:"));
+    m_comboLogSeverity = new QComboBox(this);
+    m_comboLogSeverity->addItem("Info", LogRecord::Info);
+    m_comboLogSeverity->addItem("Warning", LogRecord::Warning);
+    m_comboLogSeverity->addItem("Error", LogRecord::Error);
+    hboxLogFilter->addWidget(m_comboLogSeverity, 1);
+    vboxLog->addLayout(hboxLogFilter);
+
+    m_logModel = new LogModel(LogModel::DefaultCapacity, this);
+    m_logView = new QListView(this);
+    m_logView->setModel(m_logModel);
+    m_logView->setUniformItemSizes(true);
+    m_logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
 
     QFont logFont("Consolas");
     logFont.setStyleHint(QFont::Monospace);
-    m_txtLog->setFont(logFont);
-    vboxLog->addWidget(m_txtLog);
+    m_logView->setFont(logFont);
+    vboxLog->addWidget(m_logView);
+
+    // 在地图上点选标签时只显示该标签的日志, 点空白处恢复全部
+    connect(m_mapWidget, &MapWidget::tagSelected, m_spinLogTag, &QSpinBox::setValue);
+    // 统计表中点选标签同样过滤日志
+    connect(m_tableTagStats, &QTableWidget::cellClicked, this, [=](int row, int){
+        m_spinLogTag->setValue(m_tableTagStats->item(row, 0)->data(Qt::DisplayRole).toInt());
+    });
+    connect(m_spinLogTag, QOverload<int>::of(&QSpinBox::valueChanged), this, [=](int tagId){
+        m_logModel->setTagFilter(tagId);
+        m_logView->scrollToBottom();
+    });
+    connect(m_comboLogSeverity, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=](int){
+        m_logModel->setMinimumSeverity(LogRecord::Severity(m_comboLogSeverity->currentData().toInt()));
+        m_logView->scrollToBottom();
+    });
 
     gbLog->setLayout(vboxLog);
 
     controlLayout->addWidget(gbSerial);
     controlLayout->addWidget(gbAnchors);
     controlLayout->addWidget(gbAlgorithm);
+    controlLayout->addWidget(gbReplay);
+    controlLayout->addWidget(gbFeed);
+    controlLayout->addWidget(gbLatency);
     controlLayout->addWidget(gbLog, 1);
 
-    mainLayout->addWidget(m_mapWidget, 1);
+    QSplitter *mapSplitter = new QSplitter(Qt::Vertical, this);
+    mapSplitter->addWidget(m_mapWidget);
+    mapSplitter->addWidget(m_tableTagStats);
+    mapSplitter->setStretchFactor(0, 3);
+    mapSplitter->setStretchFactor(1, 1);
+    mapSplitter->setChildrenCollapsible(false);
+
+    mainLayout->addWidget(mapSplitter, 1);
     mainLayout->addWidget(controlPanel);
 
     refreshPorts();
 }
 
+void MainWindow::applyFilterSettings()
+{
+    int mode = m_comboFilter->currentData().toInt();
+
+    // 抖动阈值只对 EMA 生效, 噪声参数只对卡尔曼生效
+    m_spinThreshold->setEnabled(mode == FilterEma);
+    m_spinProcessNoise->setEnabled(mode == FilterKalman);
+    m_spinMeasurementNoise->setEnabled(mode == FilterKalman);
+
+    publishConfig();
+}
+
+void MainWindow::applySolverSettings()
+{
+    // 剔除阈值与时间预算只对稳健解算生效
+    bool robust = m_comboSolver->currentData().toInt() == SolverRobust;
+    m_spinRobustThreshold->setEnabled(robust);
+    m_spinRobustBudget->setEnabled(robust);
+
+    publishConfig();
+}
+
+void MainWindow::publishConfig()
+{
+    // 界面控件只在这里读取一次, 解算线程只看到不可变快照
+    PipelineSettings settings;
+    settings.solverMode = SolverMode(m_comboSolver->currentData().toInt());
+    settings.robustThreshold = m_spinRobustThreshold->value();
+    settings.robustBudgetUs = m_spinRobustBudget->value();
+    settings.filterMode = FilterMode(m_comboFilter->currentData().toInt());
+    settings.threshold = m_spinThreshold->value();
+    settings.processNoise = m_spinProcessNoise->value();
+    settings.measurementNoise = m_spinMeasurementNoise->value();
+
+    m_engine->publishConfig(PipelineConfigPtr(new PipelineConfig(m_configAnchors, settings)));
+}
+
 void MainWindow::onOpenExternalApp()
 {
     QString currentDir = QCoreApplication::applicationDirPath();
@@ -344,69 +1494,481 @@ void MainWindow::onOpenExternalApp()
 
 void MainWindow::refreshPorts()
 {
-    m_comboPorts->clear();
+    // 保留刷新前的勾选状态
+    QStringList checked = checkedPorts();
+    if (m_listPorts->count() == 0) {
+        checked = m_settings->value("lastPorts", QStringList(m_settings->value("lastPort").toString())).toStringList();
+        m_extraPorts = m_settings->value("extraPorts").toStringList();
+    }
+
+    m_listPorts->clear();
     const auto infos = QSerialPortInfo::availablePorts();
     for (const QSerialPortInfo &info : infos) {
-        m_comboPorts->addItem(info.portName());
+        QListWidgetItem *item = new QListWidgetItem(info.portName(), m_listPorts);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(checked.contains(info.portName()) ? Qt::Checked : Qt::Unchecked);
+    }
+
+    // 手动加入的端口; 已不存在的设备文件 (伪终端已关闭) 不再列出
+    for (const QString &path : m_extraPorts) {
+        if (path.startsWith('/') && !QFileInfo::exists(path)) continue;
+        if (!m_listPorts->findItems(path, Qt::MatchExactly).isEmpty()) continue;
+        QListWidgetItem *item = new QListWidgetItem(path, m_listPorts);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(checked.contains(path) ? Qt::Checked : Qt::Unchecked);
     }
 }
 
+QStringList MainWindow::checkedPorts() const
+{
+    QStringList ports;
+    for (int i = 0; i < m_listPorts->count(); ++i) {
+        if (m_listPorts->item(i)->checkState() == Qt::Checked)
+            ports.append(m_listPorts->item(i)->text());
+    }
+    return ports;
+}
+
 void MainWindow::toggleConnection()
 {
-    if (m_serial->isOpen()) {
-        m_serial->close();
-        m_btnConnect->setText("Connect");
-        m_comboPorts->setEnabled(true);
+    if (m_connected) {
+        QMetaObject::invokeMethod(m_engine, "closePorts", Qt::QueuedConnection);
+    } else {
+        QStringList ports = checkedPorts();
+        // 未勾选时使用当前选中的一项
+        if (ports.isEmpty() && m_listPorts->currentItem())
+            ports.append(m_listPorts->currentItem()->text());
+        if (ports.isEmpty()) {
+            m_btnConnect->setChecked(false);
+            return;
+        }
+        ports = ports.mid(0, PositionEngine::MaxPorts);
+
+        m_btnConnect->setEnabled(false);
+        m_listPorts->setEnabled(false);
+        m_pendingPorts = ports.size();
+        QMetaObject::invokeMethod(m_engine, [=](){ m_engine->openPorts(ports, 115200); }, Qt::QueuedConnection);
+    }
+}
+
+void MainWindow::onPortOpened(const QString &portName)
+{
+    if (m_openPorts.isEmpty()) {
+        m_logModel->clear();
+    }
+    m_openPorts.append(portName);
+    m_connected = true;
+    m_btnConnect->setChecked(true);
+    m_btnConnect->setText("Disconnect");
+    updateConnectionStatus();
+    logMessage(QString("System: Port %1 opened successfully.").arg(portName));
+    portRequestFinished();
+}
+
+void MainWindow::onPortOpenFailed(const QString &portName, const QString &error)
+{
+    logMessage(QString("System: Cannot open %1: %2").arg(portName, error), LogRecord::Error);
+    QMessageBox::critical(this, "Error", QString("Cannot open serial port %1: %2").arg(portName, error));
+    portRequestFinished();
+}
+
+void MainWindow::portRequestFinished()
+{
+    // 所有串口都有结果后才允许再次操作
+    if (m_pendingPorts > 0 && --m_pendingPorts > 0) return;
+    m_btnConnect->setEnabled(true);
+    if (m_openPorts.isEmpty()) {
+        m_btnConnect->setChecked(false);
+        m_listPorts->setEnabled(true);
+    }
+}
+
+void MainWindow::onPortClosed(const QString &portName)
+{
+    m_openPorts.removeAll(portName);
+    logMessage(QString("System: Port %1 closed.").arg(portName));
+    if (!m_openPorts.isEmpty()) {
+        updateConnectionStatus();
+        return;
+    }
+
+    m_connected = false;
+    m_btnConnect->setChecked(false);
+    m_btnConnect->setText("Connect");
+    m_listPorts->setEnabled(true);
+    updateConnectionStatus();
+}
+
+void MainWindow::onPortLost(const QString &portName)
+{
+    onPortClosed(portName);
+    logMessage(QString("System: Serial device %1 removed.").arg(portName), LogRecord::Error);
+    QMessageBox::critical(this, "Connection Lost", QString("Serial device %1 removed").arg(portName));
+}
+
+void MainWindow::updateConnectionStatus()
+{
+    if (m_openPorts.isEmpty()) {
         m_lblConnection->setText("Disconnected");
         m_lblConnection->setStyleSheet("background-color: #fdd; color: red; padding: 5px; border-radius: 4px;");
-        logMessage("System: Port closed.");
     } else {
-        QString portName = m_comboPorts->currentText();
-        if (portName.isEmpty()) return;
-
-        m_serial->setPortName(portName);
-        m_serial->setBaudRate(115200);
-
-        if (m_serial->open(QIODevice::ReadWrite)) {
-            m_btnConnect->setText("Disconnect");
-            m_comboPorts->setEnabled(false);
-            m_lblConnection->setText("Connected: " + portName);
-            m_lblConnection->setStyleSheet("background-color: #dfd; color: green; padding: 5px; border-radius: 4px;");
-
-            m_serial->write("begin");
-            m_serialBuffer.clear();
-            m_txtLog->clear();
-            logMessage("System: Port opened successfully.");
-        } else {
-            QMessageBox::critical(this, "Error", "Cannot open serial port: " + m_serial->errorString());
-            m_btnConnect->setChecked(false);
+        m_lblConnection->setText("Connected: " + m_openPorts.join(", "));
+        m_lblConnection->setStyleSheet("background-color: #dfd; color: green; padding: 5px; border-radius: 4px;");
+    }
+}
+
+void MainWindow::onFixesReady()
+{
+    m_engine->rearmNotification();
+
+    bool following = m_logView->verticalScrollBar()->value() == m_logView->verticalScrollBar()->maximum();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    LogRecord record;
+    record.timeMs = now;
+    record.hasFix = true;
+
+    LatencyStats *latency = m_engine->latencyStats();
+    qint64 dequeuedNs = m_engine->clock().nsecsElapsed();
+
+    m_pendingLog.clear();
+    while (m_engine->takeFix(record.fix)) {
+        const TagFix &fix = record.fix;
+        record.tagId = fix.tid;
+        record.severity = fix.status == TagFix::Ok ? LogRecord::Info : LogRecord::Warning;
+        if (fix.status == TagFix::Ok) {
+            // filteredNs 为 0 (回放或统计关闭) 时不统计
+            qint64 readNs = 0;
+            if (fix.filteredNs > 0) {
+                latency->record(LatencyStats::StageQueue, dequeuedNs - fix.filteredNs);
+                readNs = fix.timestampNs;
+            }
+            m_mapWidget->updateTag(fix.tid, fix.x, fix.y, fix.vx, fix.vy, readNs);
         }
+        m_pendingLog.append(record);
+    }
+    m_logModel->append(m_pendingLog.constData(), m_pendingLog.size());
+
+    int dropped = m_engine->takeDroppedCount();
+    if (dropped > 0)
+        logMessage(QString("System: %1 results dropped (display queue full)").arg(dropped), LogRecord::Warning);
+    int droppedLines = m_engine->takeDroppedLineCount();
+    if (droppedLines > 0)
+        logMessage(QString("System: %1 serial lines dropped (input queue full)").arg(droppedLines), LogRecord::Warning);
+    int droppedFeed = m_feed->takeDroppedCount();
+    if (droppedFeed > 0)
+        logMessage(QString("System: %1 results not published (feed queue full)").arg(droppedFeed), LogRecord::Warning);
+
+    scrollLogIfFollowing(following);
+}
+
+void MainWindow::onLatencyTimer()
+{
+    LatencyStats *latency = m_engine->latencyStats();
+    if (!latency->isEnabled()) return;
+    LatencySnapshot snapshots[LatencyStats::StageCount];
+    for (int i = 0; i < LatencyStats::StageCount; ++i)
+        snapshots[i] = latency->snapshot(LatencyStats::Stage(i));
+
+    // 浮层: 最近一个刷新间隔内的分布
+    if (m_checkLatencyHud->isChecked()) {
+        QStringList lines;
+        lines << QString("%1 %2 %3 %4 %5").arg("stage", -7).arg("n/s", 6).arg("p50", 9).arg("p99", 9).arg("max<", 9);
+        for (int i = 0; i < LatencyStats::StageCount; ++i) {
+            LatencySnapshot d = snapshots[i].since(m_latencyHudBase[i]);
+            lines << QString("%1 %2 %3 %4 %5")
+                     .arg(LatencyStats::stageName(i), -7)
+                     .arg(qRound64(d.count * 1000.0 / kLatencyHudIntervalMs), 6)
+                     .arg(formatLatency(d.percentileNs(0.5)), 9)
+                     .arg(formatLatency(d.percentileNs(0.99)), 9)
+                     .arg(formatLatency(d.maxBoundNs()), 9);
+        }
+        m_mapWidget->setHudText(lines);
+    }
+    for (int i = 0; i < LatencyStats::StageCount; ++i)
+        m_latencyHudBase[i] = snapshots[i];
+
+    if (!m_checkLatencyExport->isChecked()) return;
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (nowMs - m_latencyExportMs < qint64(m_spinLatencyExportSec->value()) * 1000) return;
+
+    // CSV: 每个导出间隔每个阶段一行, 单位 us
+    QFile file(m_editLatencyExport->text().trimmed());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        logMessage("System: Latency export failed: " + file.errorString(), LogRecord::Error);
+        m_checkLatencyExport->setChecked(false);
+        return;
+    }
+    QTextStream out(&file);
+    if (file.size() == 0)
+        out << "time,interval_s,stage,count,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+
+    QString timeStr = QDateTime::fromMSecsSinceEpoch(nowMs).toString(Qt::ISODateWithMs);
+    double intervalSec = (nowMs - m_latencyExportMs) / 1000.0;
+    for (int i = 0; i < LatencyStats::StageCount; ++i) {
+        LatencySnapshot d = snapshots[i].since(m_latencyExportBase[i]);
+        out << timeStr << ',' << QString::number(intervalSec, 'f', 3) << ',' << LatencyStats::stageName(i) << ','
+            << d.count << ','
+            << QString::number(d.meanNs() / 1e3, 'f', 2) << ','
+            << QString::number(d.percentileNs(0.5) / 1e3, 'f', 2) << ','
+            << QString::number(d.percentileNs(0.9) / 1e3, 'f', 2) << ','
+            << QString::number(d.percentileNs(0.99) / 1e3, 'f', 2) << ','
+            << QString::number(d.percentileNs(0.999) / 1e3, 'f', 2) << ','
+            << QString::number(d.maxBoundNs() / 1e3, 'f', 2) << '\n';
+        m_latencyExportBase[i] = snapshots[i];
     }
+    m_latencyExportMs = nowMs;
 }
 
+void MainWindow::onTagStatsTimer()
+{
+    // 统计表归引擎线程所有, 在引擎线程复制一份再交回 GUI 线程
+    QMetaObject::invokeMethod(m_engine, [=](){
+        QVector<SeqStats> stats = m_engine->sequenceStats();
+        qint64 fused = m_engine->fusedCount();
+        qint64 late = m_engine->lateCount();
+        QMetaObject::invokeMethod(this, [=](){ showTagStats(stats, fused, late); }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
 
-void MainWindow::logMessage(const QString &msg)
+void MainWindow::showTagStats(const QVector<SeqStats> &stats, qint64 fused, qint64 late)
 {
-    QString timeStr = QDateTime::currentDateTime().toString("[HH:mm:ss.zzz] ");
-    m_txtLog->append(timeStr + msg);
+    if (!m_checkTagStats->isChecked()) return;
+
+    m_lblMergeStats->setText(QString("Multi-port duplicates: %1 merged, %2 late (dropped)").arg(fused).arg(late));
+
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    double intervalSec = m_tagStatsMs > 0 ? (nowMs - m_tagStatsMs) / 1000.0 : 0.0;
+    m_tagStatsMs = nowMs;
+
+    int selectedTag = -1;
+    QList<QTableWidgetItem *> selection = m_tableTagStats->selectedItems();
+    if (!selection.isEmpty())
+        selectedTag = m_tableTagStats->item(selection.first()->row(), 0)->data(Qt::DisplayRole).toInt();
+
+    // 填表时关闭排序, 否则每写一格都会重排; 复用已有的单元格
+    m_tableTagStats->clearSelection();
+    m_tableTagStats->setSortingEnabled(false);
+    m_tableTagStats->setRowCount(stats.size());
+    QTableWidgetItem *selectedItem = nullptr;
+    for (int row = 0; row < stats.size(); ++row) {
+        const SeqStats &s = stats.at(row);
+        quint64 before = m_tagStatsReceived.value(s.tid, s.received);
+        double rate = intervalSec > 0 ? double(s.received - before) / intervalSec : 0.0;
+        m_tagStatsReceived[s.tid] = s.received;
+
+        QVariant values[] = {
+            s.tid,
+            qRound(rate * 10) / 10.0,
+            qRound(s.periodNs / 1e5) / 10.0,
+            s.received,
+            s.lost(),
+            qRound(s.lossRate() * 10000) / 100.0,
+            s.duplicates,
+            s.outOfOrder,
+            s.resyncs,
+            qRound(s.jitterNs / 1e4) / 100.0
+        };
+        for (int col = 0; col < int(sizeof(values) / sizeof(values[0])); ++col) {
+            QTableWidgetItem *item = m_tableTagStats->item(row, col);
+            if (!item) {
+                item = new QTableWidgetItem();
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                m_tableTagStats->setItem(row, col, item);
+            }
+            item->setData(Qt::DisplayRole, values[col]);
+        }
+        if (s.tid == selectedTag) selectedItem = m_tableTagStats->item(row, 0);
+    }
+    m_tableTagStats->setSortingEnabled(true);
 
-    QScrollBar *sb = m_txtLog->verticalScrollBar();
-    sb->setValue(sb->maximum());
+    // 排序后按标签恢复选中行
+    if (selectedItem)
+        m_tableTagStats->selectRow(selectedItem->row());
+}
 
-    if (m_txtLog->document()->blockCount() > 500) {
-        m_txtLog->clear();
-        m_txtLog->append("[System] Log cleared (buffer full)");
+void MainWindow::toggleCapture()
+{
+    if (!m_btnCapture->isChecked()) {
+        QMetaObject::invokeMethod(m_engine, "stopCapture", Qt::QueuedConnection);
+        return;
+    }
+
+    QString dir = QFileDialog::getExistingDirectory(this, "Capture Folder", m_captureDir);
+    if (dir.isEmpty()) {
+        m_btnCapture->setChecked(false);
+        return;
     }
+    m_captureDir = dir;
+
+    qint64 maxBytes = qint64(m_spinCaptureMB->value()) * 1024 * 1024;
+    int maxSeconds = m_spinCaptureMinutes->value() * 60;
+    QMetaObject::invokeMethod(m_engine, [=](){ m_engine->startCapture(dir, maxBytes, maxSeconds); }, Qt::QueuedConnection);
 }
 
-void MainWindow::loadSettings()
+void MainWindow::onCaptureStarted(const QString &path)
 {
-    QString lastPort = m_settings->value("lastPort").toString();
-    int idx = m_comboPorts->findText(lastPort);
-    if (idx >= 0) m_comboPorts->setCurrentIndex(idx);
+    m_btnCapture->setChecked(true);
+    m_btnCapture->setText("Stop Recording");
+    logMessage("System: Recording to " + QDir::toNativeSeparators(path));
+}
+
+void MainWindow::onCaptureStopped(qint64 bytesWritten, int droppedRecords)
+{
+    m_btnCapture->setChecked(false);
+    m_btnCapture->setText("Record Session...");
+    logMessage(QString("System: Recording stopped (%1 KB written, %2 lines dropped).")
+               .arg(bytesWritten / 1024).arg(droppedRecords),
+               droppedRecords ? LogRecord::Warning : LogRecord::Info);
+}
+
+void MainWindow::onCaptureError(const QString &error)
+{
+    m_btnCapture->setChecked(false);
+    m_btnCapture->setText("Record Session...");
+    logMessage("System: " + error, LogRecord::Error);
+    QMetaObject::invokeMethod(m_engine, "stopCapture", Qt::QueuedConnection);
+}
+
+void MainWindow::openReplay()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Open Capture", m_captureDir, "UWB Capture (*.ucap);;All Files (*)");
+    if (path.isEmpty()) return;
+
+    double speed = m_comboReplaySpeed->currentData().toDouble();
+    QMetaObject::invokeMethod(m_engine, [=](){ m_engine->startReplay(path, speed); }, Qt::QueuedConnection);
+}
+
+void MainWindow::onReplayStarted(qint64 firstTimeNs, qint64 lastTimeNs, qint64 recordCount)
+{
+    m_replayFirstNs = firstTimeNs;
+    m_replayLastNs = lastTimeNs;
+    m_btnReplayStop->setEnabled(true);
+    m_sliderReplay->setEnabled(true);
+    m_sliderReplay->setValue(0);
+    m_btnConnect->setEnabled(false);
+    logMessage(QString("System: Replaying %1 lines (%2 s).")
+               .arg(recordCount).arg((lastTimeNs - firstTimeNs) / 1e9, 0, 'f', 1));
+}
 
+void MainWindow::onReplayProgress(qint64 timeNs)
+{
+    qint64 elapsedS = (timeNs - m_replayFirstNs) / 1000000000;
+    qint64 totalS = (m_replayLastNs - m_replayFirstNs) / 1000000000;
+    m_lblReplayTime->setText(QString("%1:%2 / %3:%4")
+                             .arg(elapsedS / 60, 2, 10, QChar('0')).arg(elapsedS % 60, 2, 10, QChar('0'))
+                             .arg(totalS / 60, 2, 10, QChar('0')).arg(totalS % 60, 2, 10, QChar('0')));
+
+    if (!m_sliderReplay->isSliderDown() && m_replayLastNs > m_replayFirstNs)
+        m_sliderReplay->setValue(int((timeNs - m_replayFirstNs) * 1000 / (m_replayLastNs - m_replayFirstNs)));
+}
+
+void MainWindow::onReplayFinished()
+{
+    m_btnReplayStop->setEnabled(false);
+    m_sliderReplay->setEnabled(false);
+    m_btnConnect->setEnabled(true);
+    logMessage("System: Replay finished.");
+}
+
+void MainWindow::logMessage(const QString &msg, LogRecord::Severity severity)
+{
+    bool following = m_logView->verticalScrollBar()->value() == m_logView->verticalScrollBar()->maximum();
+
+    LogRecord record;
+    record.timeMs = QDateTime::currentMSecsSinceEpoch();
+    record.severity = severity;
+    record.tagId = -1;
+    record.hasFix = false;
+    record.text = msg;
+    m_logModel->append(record);
+
+    scrollLogIfFollowing(following);
+}
+
+void MainWindow::applyFeedSettings()
+{
+    // 未变化的输出不重启, 避免断开已连接的订阅者
+    // m_feedUdpTarget 只记录已生效的目标; 先校验, 无效时停掉原来的输出
+    QString udp = m_checkFeedUdp->isChecked() ? m_editFeedUdp->text().trimmed() : QString();
+    if (udp != m_feedUdpTarget) {
+        int colon = udp.lastIndexOf(':');
+        QString address = udp.left(colon);
+        bool portOk = false;
+        uint port = udp.mid(colon + 1).toUInt(&portOk);
+        bool valid = colon > 0 && portOk && port > 0 && port <= 65535 && !QHostAddress(address).isNull();
+
+        if (!udp.isEmpty() && !valid)
+            logMessage("System: UDP feed target must be address:port", LogRecord::Error);
+        if (udp.isEmpty() || !valid) {
+            if (!m_feedUdpTarget.isEmpty())
+                QMetaObject::invokeMethod(m_feed, "stopUdp", Qt::QueuedConnection);
+            m_feedUdpTarget.clear();
+        } else {
+            m_feedUdpTarget = udp;
+            QMetaObject::invokeMethod(m_feed, [=](){ m_feed->startUdp(address, quint16(port), kFeedMulticastTtl); }, Qt::QueuedConnection);
+        }
+    }
+
+    int tcpPort = m_checkFeedTcp->isChecked() ? m_spinFeedTcpPort->value() : 0;
+    if (tcpPort != m_feedTcpPort) {
+        m_feedTcpPort = tcpPort;
+        if (tcpPort == 0)
+            QMetaObject::invokeMethod(m_feed, "stopTcp", Qt::QueuedConnection);
+        else
+            QMetaObject::invokeMethod(m_feed, [=](){ m_feed->startTcp(quint16(tcpPort)); }, Qt::QueuedConnection);
+    }
+
+    QString shm = m_checkFeedShm->isChecked() ? m_editFeedShm->text().trimmed() : QString();
+    if (shm != m_feedShmName) {
+        m_feedShmName = shm;
+        if (shm.isEmpty())
+            QMetaObject::invokeMethod(m_engine, "stopSharedMemory", Qt::QueuedConnection);
+        else
+            QMetaObject::invokeMethod(m_engine, [=](){ m_engine->startSharedMemory(shm); }, Qt::QueuedConnection);
+    }
+}
+
+void MainWindow::scrollLogIfFollowing(bool following)
+{
+    // 用户向上翻看历史时不抢占滚动位置
+    if (following)
+        m_logView->scrollToBottom();
+}
+
+void MainWindow::loadSettings()
+{
     double threshold = m_settings->value("distThreshold", 10.0).toDouble();
     m_spinThreshold->setValue(threshold);
+    m_spinFrameRate->setValue(m_settings->value("displayFps", 30).toInt());
+    m_spinTrailMemoryMB->setValue(m_settings->value("trailMemoryMB", 32).toInt());
+    m_spinTrailSeconds->setValue(m_settings->value("trailSeconds", 0).toInt());
+    int filterIdx = m_comboFilter->findData(m_settings->value("filterMode", FilterKalman).toInt());
+    if (filterIdx >= 0) m_comboFilter->setCurrentIndex(filterIdx);
+    m_spinProcessNoise->setValue(m_settings->value("kalmanProcessNoise", 100.0).toDouble());
+    m_spinMeasurementNoise->setValue(m_settings->value("kalmanMeasurementNoise", 15.0).toDouble());
+    applyFilterSettings();
+    m_spinRobustThreshold->setValue(m_settings->value("robustThreshold", 50.0).toDouble());
+    m_spinRobustBudget->setValue(m_settings->value("robustBudgetUs", 50).toInt());
+    int solverIdx = m_comboSolver->findData(m_settings->value("solverMode", SolverClosedForm).toInt());
+    if (solverIdx >= 0) m_comboSolver->setCurrentIndex(solverIdx);
+    applySolverSettings();
+    m_captureDir = m_settings->value("captureDir", QDir::homePath()).toString();
+    m_spinCaptureMB->setValue(m_settings->value("captureMaxMB", 256).toInt());
+    m_spinCaptureMinutes->setValue(m_settings->value("captureMaxMinutes", 60).toInt());
+    m_editFeedUdp->setText(m_settings->value("feedUdpTarget", m_editFeedUdp->text()).toString());
+    m_spinFeedTcpPort->setValue(m_settings->value("feedTcpPort", 7411).toInt());
+    m_checkFeedUdp->setChecked(m_settings->value("feedUdpEnabled", false).toBool());
+    m_editFeedShm->setText(m_settings->value("feedShmName", m_editFeedShm->text()).toString());
+    m_checkFeedTcp->setChecked(m_settings->value("feedTcpEnabled", false).toBool());
+#ifndef Q_OS_WIN
+    m_checkFeedShm->setChecked(m_settings->value("feedShmEnabled", false).toBool());
+#endif
+    m_editLatencyExport->setText(m_settings->value("latencyExportPath", m_editLatencyExport->text()).toString());
+    m_spinLatencyExportSec->setValue(m_settings->value("latencyExportSeconds", 10).toInt());
+    m_checkLatencyExport->setChecked(m_settings->value("latencyExportEnabled", false).toBool());
+    m_checkLatencyHud->setChecked(m_settings->value("latencyHud", false).toBool());
+    m_checkTagStats->setChecked(m_settings->value("tagStats", false).toBool());
 
     // load anchor tables
     int count = m_settings->beginReadArray("Anchors");
@@ -432,8 +1994,32 @@ void MainWindow::loadSettings()
 
 void MainWindow::saveSettings()
 {
-    m_settings->setValue("lastPort", m_comboPorts->currentText());
+    m_settings->setValue("lastPorts", checkedPorts());
+    m_settings->setValue("extraPorts", m_extraPorts);
     m_settings->setValue("distThreshold", m_spinThreshold->value());
+    m_settings->setValue("displayFps", m_spinFrameRate->value());
+    m_settings->setValue("trailSeconds", m_spinTrailSeconds->value());
+    m_settings->setValue("trailMemoryMB", m_spinTrailMemoryMB->value());
+    m_settings->setValue("solverMode", m_comboSolver->currentData().toInt());
+    m_settings->setValue("robustThreshold", m_spinRobustThreshold->value());
+    m_settings->setValue("robustBudgetUs", m_spinRobustBudget->value());
+    m_settings->setValue("filterMode", m_comboFilter->currentData().toInt());
+    m_settings->setValue("kalmanProcessNoise", m_spinProcessNoise->value());
+    m_settings->setValue("kalmanMeasurementNoise", m_spinMeasurementNoise->value());
+    m_settings->setValue("captureDir", m_captureDir);
+    m_settings->setValue("captureMaxMB", m_spinCaptureMB->value());
+    m_settings->setValue("captureMaxMinutes", m_spinCaptureMinutes->value());
+    m_settings->setValue("feedUdpEnabled", m_checkFeedUdp->isChecked());
+    m_settings->setValue("feedUdpTarget", m_editFeedUdp->text());
+    m_settings->setValue("feedTcpEnabled", m_checkFeedTcp->isChecked());
+    m_settings->setValue("feedTcpPort", m_spinFeedTcpPort->value());
+    m_settings->setValue("feedShmEnabled", m_checkFeedShm->isChecked());
+    m_settings->setValue("feedShmName", m_editFeedShm->text());
+    m_settings->setValue("latencyHud", m_checkLatencyHud->isChecked());
+    m_settings->setValue("latencyExportEnabled", m_checkLatencyExport->isChecked());
+    m_settings->setValue("latencyExportPath", m_editLatencyExport->text());
+    m_settings->setValue("latencyExportSeconds", m_spinLatencyExportSec->value());
+    m_settings->setValue("tagStats", m_checkTagStats->isChecked());
 
     // save anchor tables
     m_settings->beginWriteArray("Anchors");
@@ -455,6 +2041,7 @@ void MainWindow::saveSettings()
 void MainWindow::applyAnchors()
 {
     QMap<int, MapWidget::Point> anchorsMap;
+    QMap<int, QPoint> engineAnchors;
 
     for (int i = 0; i < m_tableAnchors->rowCount(); ++i) {
         auto itemID = m_tableAnchors->item(i, 0);
@@ -466,189 +2053,12 @@ void MainWindow::applyAnchors()
             int x = itemX->text().toInt();
             int y = itemY->text().toInt();
             anchorsMap[id] = {x, y};
+            engineAnchors[id] = QPoint(x, y);
         }
     }
 
     m_mapWidget->updateAnchorsMap(anchorsMap);
+    m_configAnchors = engineAnchors;
+    publishConfig();
     saveSettings();
 }
-
-void MainWindow::onSerialReadyRead()
-{
-    m_serialBuffer.append(m_serial->readAll());
-
-    while (m_serialBuffer.contains('\n')) {
-        int lineEnd = m_serialBuffer.indexOf('\n');
-        QByteArray line = m_serialBuffer.left(lineEnd).trimmed();
-        m_serialBuffer.remove(0, lineEnd + 1);
-
-        if (!line.isEmpty()) {
-            processData(line);
-        }
-    }
-}
-
-// -------------------------------------------------------- 
-// 示例格式: AT+RANGE=tid:1,mask:80,seq:65,range:(0,0,0,0,0,0,0,107),ancid:(-1,-1,-1,-1,-1,-1,-1,7)
-// --------------------------------------------------------
-void MainWindow::processData(const QByteArray &data)
-{
-    QString strData = QString::fromLatin1(data).trimmed();
-//    qDebug() << strData;
-    if (!strData.startsWith("AT+RANGE=")) return;
-
-    // parse tid
-    int tagId = -1;
-    QRegExp rxId("tid:(\\d+)");
-    if (rxId.indexIn(strData) != -1) {
-        tagId = rxId.cap(1).toInt();
-    } else {
-        return;
-    }
-
-    // parse range and ancid
-    QVector<int> rawRanges;
-    QVector<int> aidArr;
-
-    QRegExp rxRange("range:\\(([^)]+)\\)");
-    if (rxRange.indexIn(strData) != -1) {
-        QString rangeContent = rxRange.cap(1);
-        QStringList parts = rangeContent.split(',');
-        for (const QString &val : parts)
-            if (val.toInt()) rawRanges.append(val.toInt());
-    }
-
-    QRegExp rxAncid("ancid:\\(([^)]+)\\)");
-    if (rxAncid.indexIn(strData) != -1) {
-        QString ancidContent = rxAncid.cap(1);
-        QStringList parts = ancidContent.split(',');
-        for (const QString &val : parts)
-            if (val.toInt() + 1) aidArr.append(val.toInt());
-    }
-
-    if ((aidArr.size() != rawRanges.size()) || (aidArr.size() < 3)) {
-        qDebug() << "value data < 3";
-        return;
-    }
-
-
-    #ifdef DEBUG_ANCHORS
-    qDebug() << "------------------------------------------------";
-    qDebug() << "Parsed Data -> Tag:" << tagId;
-    qDebug() << "Raw Ranges:" << rawRanges;
-    qDebug() << "Anc IDs:" << aidArr;
-
-    QString validStr;
-    for(auto r : currentRanges) validStr += QString("[%1: %2cm] ").arg(r.aid).arg(r.dist);
-    qDebug() << "Valid Pairs (Dist>0):" << validStr;
-
-    QString knownStr;
-    for(auto k : knownAnchors.keys()) knownStr += QString("%1 ").arg(k);
-    qDebug() << "Configured Anchors in UI:" << knownStr;
-    #endif
-
-    //
-    QMap<int, MapWidget::Point> mapAnchors = m_mapWidget->getAnchorsMap();
-    QVector<MapWidget::Point> validPoints;
-    QVector<int> validRanges;
-    QString usedAnchorsStr;
-
-    for (int i = 0; i < aidArr.size(); i++) {
-        int aid = aidArr[i];
-        if (mapAnchors.contains(aid)) {
-            validPoints.append(mapAnchors[aid]);
-            validRanges.append(rawRanges[i]);
-            usedAnchorsStr += QString("A%1:%2 ").arg(aid).arg(rawRanges[i]);
-        }
-    }
-
-    if (validPoints.size() < 3) {
-        logMessage(QString("Tag %1: Not enough known anchors (%2 found)").arg(tagId).arg(validPoints.size()));
-        return;
-    }
-
-    QPoint rawPos;
-    if (calculatePosition(validPoints, validRanges, rawPos)) {
-
-        QPoint finalPos = rawPos;
-        if (m_lastTagPoint.contains(tagId)) {
-            QPoint last = m_lastTagPoint[tagId];
-            double alpha = 0.2; // 滤波系数
-            finalPos.setX(last.x() * (1-alpha) + rawPos.x() * alpha);
-            finalPos.setY(last.y() * (1-alpha) + rawPos.y() * alpha);
-
-            if ((finalPos - last).manhattanLength() < m_spinThreshold->value()) {
-                finalPos = last;
-            }
-        }
-
-        m_lastTagPoint[tagId] = finalPos;
-        m_mapWidget->updateTag(tagId, finalPos.x(), finalPos.y());
-
-        logMessage(QString("Tag %1 -> (%2, %3) | Used: %4")
-                   .arg(tagId).arg(finalPos.x()).arg(finalPos.y()).arg(usedAnchorsStr));
-    } else {
-        logMessage(QString("Tag %1: Calc Failed").arg(tagId));
-    }
-}
-
-
-void MainWindow::onSerialError(QSerialPort::SerialPortError error)
-{
-    if (error == QSerialPort::ResourceError) {
-        QMessageBox::critical(this, "Connection Lost", "Serial device removed");
-        toggleConnection();
-    }
-}
-
-
-
-bool MainWindow::calculatePosition(const QVector<MapWidget::Point> &anchors, const QVector<int> &ranges, QPoint &result)
-{
-    int n = qMin(anchors.size(), ranges.size());
-    if (n < 3) return false;
-
-    QVector<double> X(n), Y(n), R(n);
-    int bestIdx = 0;
-    int minRange = 999999;
-
-    for(int i = 0; i < n; ++i) {
-        X[i] = anchors[i].x;
-        Y[i] = anchors[i].y;
-        R[i] = ranges[i];
-        if (ranges[i] < minRange && ranges[i] > 0) {
-            minRange = ranges[i];
-            bestIdx = i;
-        }
-    }
-
-    if (bestIdx != n - 1) {
-        std::swap(X[bestIdx], X[n-1]);
-        std::swap(Y[bestIdx], Y[n-1]);
-        std::swap(R[bestIdx], R[n-1]);
-    }
-
-    double xn = X[n-1], yn = Y[n-1], rn = R[n-1];
-    double a11 = 0, a12 = 0, a22 = 0, b1 = 0, b2 = 0;
-
-    for (int i = 0; i < n - 1; ++i) {
-        double Ai_0 = 2.0 * (X[i] - xn);
-        double Ai_1 = 2.0 * (Y[i] - yn);
-        double bi_val = rn*rn - R[i]*R[i] + X[i]*X[i] - xn*xn + Y[i]*Y[i] - yn*yn;
-
-        a11 += Ai_0 * Ai_0;
-        a12 += Ai_0 * Ai_1;
-        a22 += Ai_1 * Ai_1;
-        b1 += Ai_0 * bi_val;
-        b2 += Ai_1 * bi_val;
-    }
-
-    double det = a11 * a22 - a12 * a12;
-    if (qAbs(det) < 1e-4) return false;
-
-    double x = (a22 * b1 - a12 * b2) / det;
-    double y = (a11 * b2 - a12 * b1) / det;
-
-    result = QPoint(qRound(x), qRound(y));
-    return true;
-}
@@ -10,8 +10,15 @@
 #include <QJsonArray>
 #include <QTimer>
 #include <QMap>
+#include <QHash>
 #include <QPainter>
 #include <QSettings>
+#include <QElapsedTimer>
+#include "logmodel.h"
+#include "taggrid.h"
+#include "trailstore.h"
+#include "latencystats.h"
+#include "seqtracker.h"
 
 // ==========================================
 // MapWidget: 负责绘制基站和标签的画布
@@ -27,25 +34,109 @@ public:
     };
 
     struct Tag {
-        Point pos;
+        QPointF pos;        // 当前显示位置 (cm), 有速度估计时在两包之间外推
+        QPointF fixPos;     // 最近一次定位结果
+        QPointF velocity;   // cm/s
+        qint64 fixMs;       // 收到最近一次结果的时间 (m_clock)
         QColor color;
+        bool dirty;         // 上一帧之后位置有变化
+        QRectF drawnRect;   // 上一次布局占用的屏幕区域 (标记 + 文字)
+        bool labelShown;    // 上一次布局是否显示文字
+        QPixmap label;      // 缓存的文字, 取整后的坐标变化时才重新生成
+        QPoint labelValue;
+        bool trailDirty;    // 上一帧之后轨迹有新点
+        qint64 traceReadNs; // 待统计绘制延迟的结果: 串口到达时间 / 交给地图的时间, 0 表示没有
+        qint64 traceUpdateNs;
     };
 
     // 更新基站坐标
     void updateAnchors(const QVector<Point> &anchors);
-    // 更新标签位置
-    void updateTag(int id, int x, int y);
+    // 更新标签位置 (只记录, 由帧定时器统一刷新); 速度非零时在下一包到来前按速度外推
+    // readNs: 该结果的串口到达时间 (引擎时钟), 非零时统计到绘制完成的延迟
+    void updateTag(int id, double x, double y, double vx = 0, double vy = 0, qint64 readNs = 0);
     void updateAnchorsMap(const QMap<int, Point> &anchorsMap);
     QMap<int, Point> getAnchorsMap() const;
 
+    // 刷新帧率 (fps), 多次标签更新合并到一帧中绘制
+    void setFrameRate(int fps);
+    int frameRate() const;
+
+    // 恢复自动适配 (按基站范围, 没有基站时按标签范围); 滚轮缩放或拖动平移后停止自动适配
+    void fitToView();
+
+    // 绘制延迟记入 stats 的 Paint/Total 阶段; clock 须与引擎同一时基
+    void setLatencyStats(LatencyStats *stats, const QElapsedTimer &clock);
+    // 左上角的浮层文字, 空表示隐藏
+    void setHudText(const QStringList &lines);
+
+    // 轨迹显示最近 seconds 秒 (0 关闭并释放已记录的轨迹); 所有标签的轨迹总内存不超过 bytes
+    void setTrailLength(int seconds);
+    int trailLength() const;
+    void setTrailMemoryBudget(qint64 bytes);
+
+    // 屏幕坐标处 (拾取半径内) 最近的标签, 没有时返回 -1
+    int tagAt(const QPoint &sPos) const;
+    int selectedTag() const;
+    // 标签的空间索引 (世界坐标), 供区域查询
+    const TagGrid &tagGrid() const { return m_grid; }
+
+signals:
+    void tagSelected(int id);   // 点选标签, 点在空白处为 -1
+
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private slots:
+    void onFrameTick();
 
 private:
+    // 一帧的绘制布局: 由 layoutTags() 计算, paintEvent 只按布局贴图
+    struct Marker {
+        QPointF pos;        // 屏幕坐标, 聚合标记为成员的质心
+        QRectF rect;        // 占用的屏幕区域
+        int tagId;          // 聚合标记为 -1
+        int count;          // 聚合的标签数
+        bool showLabel;
+    };
+
+    enum {
+        ClusterCellPx = 24,         // 落在同一屏幕网格的标签合并为一个聚合标记
+        MaxPartialRepaintTags = 256,// 移动标签超过该数量时直接整屏重绘
+        MaxTrailPoints = 256,       // 每条轨迹抽稀后最多绘制的点数
+        TrailRefreshMs = 500        // 静止标签的轨迹尾部按该间隔过期
+    };
+
     QMap<int, Point> m_anchors; // 基站 ID -> 坐标
     QMap<int, Tag> m_tags;      // 标签 ID -> 数据
+    TagGrid m_grid;             // 标签显示位置的空间索引, 与 m_tags 同步更新
+    int m_hoverTag;
+    int m_selectedTag;
     QPixmap m_anchorImage;
 
+    // 帧调度
+    QTimer *m_frameTimer;
+    QElapsedTimer m_clock;
+    QVector<int> m_dirtyTags;   // 自上一帧以来移动过的标签
+    bool m_transformDirty;      // 视图或场景变化, 下一帧重新布局并整屏重绘
+
+    // 视图: 自动适配只在基站变化、首批标签出现或 resize 时计算, 不随标签移动
+    bool m_autoFit;
+    bool m_fitPending;
+    bool m_dragging;
+    QPoint m_pressPos;
+    QPoint m_lastDragPos;
+
+    // 静态层: 背景、原点、基站及其文字, 视图或基站变化时才重新绘制
+    QPixmap m_staticLayer;
+    bool m_staticDirty;
+
     // 绘图变换参数
     double m_scale;
     double m_offsetX;
@@ -54,8 +145,58 @@ private:
 
     // 坐标转换辅助函数
     QPointF worldToScreen(double wx, double wy);
+    QPointF screenToWorld(const QPointF &sPos) const;
+    QRectF selectionRect(const QPointF &sPos) const;
     void calculateTransform();
+    void setView(double scale, double offsetX, double offsetY);
+    void renderStaticLayer();
     void drawGrid(QPainter &painter);
+    QString tagLabel(int id, const Tag &tag) const;
+
+    // 布局: 屏幕网格聚合 + 文字避让; 文字显示状态改变的静止标签区域记入 m_staleRegion
+    void layoutTags();
+    QSizeF labelSize(int id, const Tag &tag) const;
+    const QPixmap &labelPixmap(int id, Tag &tag);
+    const QPixmap &markerSprite(const QColor &color);
+    const QPixmap &clusterSprite(int count);
+
+    QVector<Marker> m_markers;
+    bool m_hasClusters;
+    QRegion m_staleRegion;
+    QHash<quint64, int> m_cellMarker;       // 网格 -> m_markers 下标 (布局工作区)
+    QVector<quint8> m_labelCells;           // 已被标记或文字占用的网格 (布局工作区)
+    QHash<QRgb, QPixmap> m_markerSprites;
+
+    // 延迟统计与浮层
+    LatencyStats *m_latency;
+    QElapsedTimer m_latencyClock;
+    QVector<int> m_tracedTags;
+    QStringList m_hudLines;
+    QRect m_hudRect;
+    QFont m_hudFont;
+
+    // 轨迹: 记录定位结果 (不含外推位置), 布局时抽稀为屏幕折线。
+    // 视口外的轨迹不抽稀, 只记下世界坐标范围, 回到视口内或视图变化时再布局
+    struct TrailPath {
+        QPolygonF points;       // 屏幕坐标
+        QRectF bounds;          // 折线占用的屏幕区域 (含线宽)
+        QRectF worldBounds;     // 同一范围的世界坐标, 判断视图变化后是否可见
+        qint64 firstMs;         // 最旧一点的时间, 早于保留时长时要重新抽稀
+        QColor color;
+        bool stale;             // 在视口外未布局, points 不可用
+    };
+
+    // all: 视图变化, 所有轨迹重新布局 (视口外的除外); 否则只布局有新点
+    // 或尾部过期的可见轨迹。返回需要重绘的区域
+    QRegion layoutTrails(bool all);
+    TrailStore m_trails;
+    int m_trailSeconds;
+    QVector<int> m_trailDirtyTags;
+    QHash<int, TrailPath> m_trailPaths;
+    QVector<int> m_trailExpired;        // layoutTrails() 的工作区
+    qint64 m_trailLayoutMs;
+    QHash<int, QPixmap> m_clusterSprites;
+    QVector<QPainter::PixmapFragment> m_fragments;
 };
 
 // ==========================================
@@ -67,7 +208,16 @@ class QTableWidget;
 class QLabel;
 class QGroupBox;
 class QDoubleSpinBox;
-class QTextEdit;
+class QSpinBox;
+class QSlider;
+class QListView;
+class QListWidget;
+class QCheckBox;
+class QLineEdit;
+class LogModel;
+class QThread;
+class PositionEngine;
+class FeedPublisher;
 
 class MainWindow : public QMainWindow
 {
@@ -85,9 +235,22 @@ private slots:
 
     void onOpenExternalApp();
 
-    // 串口槽函数
-    void onSerialReadyRead();
-    void onSerialError(QSerialPort::SerialPortError error);
+    // 定位引擎槽函数
+    void onPortOpened(const QString &portName);
+    void onPortOpenFailed(const QString &portName, const QString &error);
+    void onPortClosed(const QString &portName);
+    void onPortLost(const QString &portName);
+    void onFixesReady();
+    void toggleCapture();
+    void onCaptureStarted(const QString &path);
+    void onCaptureStopped(qint64 bytesWritten, int droppedRecords);
+    void onCaptureError(const QString &error);
+    void openReplay();
+    void onReplayStarted(qint64 firstTimeNs, qint64 lastTimeNs, qint64 recordCount);
+    void onReplayProgress(qint64 timeNs);
+    void onReplayFinished();
+    void onLatencyTimer();
+    void onTagStatsTimer();
 
 private:
     // UI 初始化
@@ -95,31 +258,98 @@ private:
     void loadSettings();
     void saveSettings();
     void updateTagStatusDisplay(); // 刷新文本显示
-    void logMessage(const QString &msg); // 新增：日志输出函数
+    void updateConnectionStatus();
+    QStringList checkedPorts() const;
+    void portRequestFinished();     // 一个串口打开成功或失败
+    void applyFilterSettings();
+    void applySolverSettings();
+    void publishConfig();       // 由当前基站表与界面参数生成快照交给引擎
+    void applyFeedSettings();   // 按界面启停局域网发布
+    void logMessage(const QString &msg, LogRecord::Severity severity = LogRecord::Info); // 系统日志
+    void scrollLogIfFollowing(bool following);
+    void showTagStats(const QVector<SeqStats> &stats, qint64 fused, qint64 late);
 
-    // 核心算法
     void processJsonData(const QByteArray &data);
-    void processData(const QByteArray &data);
-    bool calculatePosition(const QVector<MapWidget::Point> &anchors, const QVector<int> &ranges, QPoint &result);
 
     // 成员变量
     MapWidget *m_mapWidget;
-    QSerialPort *m_serial;
+    PositionEngine *m_engine;   // 运行在 m_engineThread
+    QThread *m_engineThread;
+    FeedPublisher *m_feed;      // 运行在 m_feedThread
+    QThread *m_feedThread;
+    bool m_connected;
+    QStringList m_openPorts;
+    int m_pendingPorts;             // 已请求打开、尚未有结果的串口数
 
     // UI 控件指针
-    QComboBox *m_comboPorts;
+    QListWidget *m_listPorts;
+    QLineEdit *m_editExtraPort;
+    QStringList m_extraPorts;       // 手动输入的端口路径
     QPushButton *m_btnConnect;
+    QPushButton *m_btnCapture;
+    QSpinBox *m_spinCaptureMB;
+    QSpinBox *m_spinCaptureMinutes;
+    QString m_captureDir;
+
+    // 录制回放
+    QPushButton *m_btnReplayOpen;
+    QPushButton *m_btnReplayStop;
+    QComboBox *m_comboReplaySpeed;
+    QSlider *m_sliderReplay;
+    QLabel *m_lblReplayTime;
+    qint64 m_replayFirstNs;
+    qint64 m_replayLastNs;
+
+    // 局域网发布
+    QCheckBox *m_checkFeedUdp;
+    QLineEdit *m_editFeedUdp;       // 组播组或单播地址:端口
+    QCheckBox *m_checkFeedTcp;
+    QSpinBox *m_spinFeedTcpPort;
+    QCheckBox *m_checkFeedShm;
+    QLineEdit *m_editFeedShm;       // 共享内存对象名
+    QString m_feedUdpTarget;        // 当前生效的设置, 空/0 表示未启用
+    int m_feedTcpPort;
+    QString m_feedShmName;
+
+    // 分阶段延迟: 浮层每秒刷新, CSV 按设定间隔追加
+    QCheckBox *m_checkLatencyHud;
+    QCheckBox *m_checkLatencyExport;
+    QLineEdit *m_editLatencyExport;
+    QSpinBox *m_spinLatencyExportSec;
+    QTimer *m_latencyTimer;
+    LatencySnapshot m_latencyHudBase[LatencyStats::StageCount];
+    LatencySnapshot m_latencyExportBase[LatencyStats::StageCount];
+    qint64 m_latencyExportMs;       // 上一次导出的时间
+
+    // 各标签序号统计表: 显示时每秒向引擎取一次
+    QCheckBox *m_checkTagStats;
+    QTableWidget *m_tableTagStats;
+    QLabel *m_lblMergeStats;     // 多串口合并的重复包计数
+    QTimer *m_tagStatsTimer;
+    QHash<int, quint64> m_tagStatsReceived;     // 上一次刷新时各标签的收包数, 用于计算速率
+    qint64 m_tagStatsMs;
+
     QTableWidget *m_tableAnchors;
     QDoubleSpinBox *m_spinThreshold;
+    QSpinBox *m_spinFrameRate;
+    QSpinBox *m_spinTrailSeconds;
+    QSpinBox *m_spinTrailMemoryMB;
+    QComboBox *m_comboSolver;
+    QComboBox *m_comboFilter;
+    QDoubleSpinBox *m_spinProcessNoise;
+    QDoubleSpinBox *m_spinMeasurementNoise;
+    QDoubleSpinBox *m_spinRobustThreshold;
+    QSpinBox *m_spinRobustBudget;
+    QMap<int, QPoint> m_configAnchors;  // 最近一次 Apply 的基站表
 
     QLabel *m_lblConnection;     // 仅显示连接状态
-    QTextEdit *m_txtLog;
+    QListView *m_logView;
+    LogModel *m_logModel;
+    QSpinBox *m_spinLogTag;
+    QComboBox *m_comboLogSeverity;
+    QVector<LogRecord> m_pendingLog;    // onFixesReady 中复用的批量缓冲
 
-    // 数据缓存
-    QByteArray m_serialBuffer;
     QSettings *m_settings;
-
-    QMap<int, QPoint> m_lastTagPoint;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,72 @@
+#include "pipelineconfig.h"
+#include <algorithm>
+
+PipelineSettings::PipelineSettings()
+    : solverMode(SolverClosedForm), maxIterations(8), robustThreshold(50.0), robustBudgetUs(50),
+      filterMode(FilterKalman),
+      threshold(10.0), processNoise(100.0), measurementNoise(15.0)
+{
+}
+
+PipelineConfig::PipelineConfig(const QMap<int, QPoint> &anchors, const PipelineSettings &settings)
+    : m_anchorCount(anchors.size()), m_settings(settings)
+{
+    m_settings.maxIterations = qMax(1, m_settings.maxIterations);
+    m_settings.robustThreshold = qMax(1.0, m_settings.robustThreshold);
+    m_settings.robustBudgetUs = qMax(0, m_settings.robustBudgetUs);
+    m_settings.processNoise = qMax(0.0, m_settings.processNoise);
+    m_settings.measurementNoise = qMax(0.1, m_settings.measurementNoise);
+
+    int maxId = -1;
+    for (auto it = anchors.constBegin(); it != anchors.constEnd(); ++it) {
+        if (it.key() >= 0 && it.key() <= MaxTableId)
+            maxId = qMax(maxId, it.key());
+    }
+
+    m_table.resize(maxId + 1);
+    m_present.fill(false, maxId + 1);
+
+    // QMap 按键升序遍历, 溢出表天然有序
+    for (auto it = anchors.constBegin(); it != anchors.constEnd(); ++it) {
+        Anchor a = { double(it.value().x()), double(it.value().y()) };
+        if (it.key() >= 0 && it.key() <= MaxTableId) {
+            m_table[it.key()] = a;
+            m_present[it.key()] = true;
+        } else {
+            m_overflowIds.append(it.key());
+            m_overflow.append(a);
+        }
+    }
+}
+
+const PipelineConfig::Anchor *PipelineConfig::findOverflow(int id) const
+{
+    auto it = std::lower_bound(m_overflowIds.constBegin(), m_overflowIds.constEnd(), id);
+    if (it == m_overflowIds.constEnd() || *it != id) return nullptr;
+    return m_overflow.constData() + (it - m_overflowIds.constBegin());
+}
+
+PipelineConfigMailbox::PipelineConfigMailbox()
+    : m_pending(nullptr)
+{
+}
+
+PipelineConfigMailbox::~PipelineConfigMailbox()
+{
+    delete m_pending.exchange(nullptr);
+}
+
+void PipelineConfigMailbox::publish(const PipelineConfigPtr &config)
+{
+    // 被替换的旧快照尚未被取走, 直接丢弃
+    delete m_pending.exchange(new PipelineConfigPtr(config), std::memory_order_acq_rel);
+}
+
+bool PipelineConfigMailbox::takeSlow(PipelineConfigPtr &config)
+{
+    PipelineConfigPtr *pending = m_pending.exchange(nullptr, std::memory_order_acquire);
+    if (!pending) return false;
+    config = *pending;
+    delete pending;
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef PIPELINECONFIG_H
+#define PIPELINECONFIG_H
+
+#include <QMap>
+#include <QPoint>
+#include <QVector>
+#include <QSharedPointer>
+#include <atomic>
+#include "trilateration.h"
+
+enum FilterMode {
+    FilterKalman,           // 匀速模型卡尔曼滤波
+    FilterEma               // EMA + 抖动阈值 (整数坐标)
+};
+
+// ==========================================
+// PipelineSettings: 解算与滤波参数
+// ==========================================
+struct PipelineSettings {
+    PipelineSettings();
+
+    SolverMode solverMode;
+    int maxIterations;          // 迭代解算的最大迭代次数 (每次迭代 O(基站数))
+    double robustThreshold;     // 稳健解算: 残差超过该值 (cm) 的测距视为不一致
+    int robustBudgetUs;         // 稳健解算: 每次解算的时间预算 (us), 0 不限
+    FilterMode filterMode;
+    double threshold;           // EMA 抖动阈值 (cm)
+    double processNoise;        // 卡尔曼加速度噪声 (cm/s^2)
+    double measurementNoise;    // 卡尔曼测量噪声 (cm)
+};
+
+// ==========================================
+// PipelineConfig: 基站布局 + 解算参数的不可变快照
+// 构造后不再修改, 由 QSharedPointer 计数共享, 任意线程可无锁读取。
+// 基站按 ID 直接下标查表; 超出 MaxTableId 的 ID 退化为有序表二分查找
+// ==========================================
+class PipelineConfig
+{
+public:
+    enum { MaxTableId = 1023 };
+
+    struct Anchor {
+        double x;
+        double y;
+    };
+
+    PipelineConfig(const QMap<int, QPoint> &anchors, const PipelineSettings &settings);
+
+    // 未知基站返回 nullptr
+    inline const Anchor *anchor(int id) const;
+
+    const PipelineSettings &settings() const { return m_settings; }
+    int anchorCount() const { return m_anchorCount; }
+
+private:
+    const Anchor *findOverflow(int id) const;
+
+    QVector<Anchor> m_table;        // 下标为基站 ID, 长度为最大 ID + 1
+    QVector<bool> m_present;
+    QVector<int> m_overflowIds;     // 升序
+    QVector<Anchor> m_overflow;
+    int m_anchorCount;
+    PipelineSettings m_settings;
+};
+
+typedef QSharedPointer<const PipelineConfig> PipelineConfigPtr;
+
+inline const PipelineConfig::Anchor *PipelineConfig::anchor(int id) const
+{
+    if (uint(id) < uint(m_table.size()))
+        return m_present.at(id) ? m_table.constData() + id : nullptr;
+    return m_overflowIds.isEmpty() ? nullptr : findOverflow(id);
+}
+
+// ==========================================
+// PipelineConfigMailbox: 单槽信箱, GUI 线程发布, 引擎线程取走
+// 发布者连续发布时只保留最新一份; 取走方每包只做一次原子读
+// ==========================================
+class PipelineConfigMailbox
+{
+public:
+    PipelineConfigMailbox();
+    ~PipelineConfigMailbox();
+
+    // 任意线程
+    void publish(const PipelineConfigPtr &config);
+    // 消费线程: 有新快照时写入 config 并返回 true
+    inline bool take(PipelineConfigPtr &config);
+
+private:
+    Q_DISABLE_COPY(PipelineConfigMailbox)
+
+    bool takeSlow(PipelineConfigPtr &config);
+
+    std::atomic<PipelineConfigPtr *> m_pending;
+};
+
+inline bool PipelineConfigMailbox::take(PipelineConfigPtr &config)
+{
+    if (!m_pending.load(std::memory_order_relaxed)) return false;
+    return takeSlow(config);
+}
+
+#endif // PIPELINECONFIG_H
@@ -0,0 +1,453 @@
+#include "positionengine.h"
+#include "capturefile.h"
+#include "feedpublisher.h"
+#include "seriallistener.h"
+#include <QDateTime>
+#include <QThread>
+#include <QTimer>
+#include <limits>
+#include <cstring>
+
+namespace {
+// 多串口时重排窗口到期检查周期
+const int kMergeIntervalMs = 5;
+
+// 单串口不会有重复包, 不必等待重排窗口
+qint64 liveMergeWindowNs(int portCount)
+{
+    return portCount > 1 ? StreamMerger::DefaultWindowMs * 1000000LL : 0;
+}
+
+inline qint16 saturate16(double v)
+{
+    return qint16(qBound(-32768, qRound(v), 32767));
+}
+
+FeedRecord toFeedRecord(const TagFix &fix, qint64 epochUs)
+{
+    bool hasPosition = fix.status == TagFix::Ok;
+    FeedRecord record;
+    record.tid = quint32(fix.tid);
+    record.seq = quint32(fix.seq);
+    record.timeUs = epochUs + fix.timestampNs / 1000;
+    record.x = hasPosition ? float(fix.x) : 0.0f;
+    record.y = hasPosition ? float(fix.y) : 0.0f;
+    record.vx = hasPosition ? saturate16(fix.vx) : 0;
+    record.vy = hasPosition ? saturate16(fix.vy) : 0;
+    record.status = quint8(fix.status);
+    record.quality = hasPosition ? quint8(qMin(fix.usedAnchorCount(), 255)) : 0;
+    return record;
+}
+
+UwbShm::Position toShmPosition(const TagFix &fix, qint64 epochUs)
+{
+    UwbShm::Position position;
+    memset(&position, 0, sizeof(position));
+    position.tid = quint32(fix.tid);
+    position.seq = quint32(fix.seq);
+    position.timeUs = epochUs + fix.timestampNs / 1000;
+    position.x = fix.x;
+    position.y = fix.y;
+    position.vx = float(fix.vx);
+    position.vy = float(fix.vy);
+    position.status = quint8(fix.status);
+    position.quality = quint8(qMin(fix.usedAnchorCount(), 255));
+    return position;
+}
+}
+
+PositionEngine::PositionEngine(QObject *parent)
+    : QObject(parent), m_mergeTimer(nullptr), m_capture(nullptr), m_captureFlushTimer(nullptr),
+      m_replay(nullptr), m_replayTimer(nullptr), m_replayOffset(0), m_replaySpeed(1.0),
+      m_replayBaseNs(0), m_replayPosNs(0), m_replayLastProgressMs(0), m_feed(nullptr), m_tracing(false)
+{
+    m_clock.start();
+    m_liveEpochUs = m_feedEpochUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+}
+
+PositionEngine::~PositionEngine()
+{
+    closePorts();
+    stopCapture();
+    delete m_replay;
+}
+
+void PositionEngine::rearmNotification()
+{
+    m_notifyPending.storeRelease(0);
+}
+
+bool PositionEngine::takeFix(TagFix &fix)
+{
+    return m_fixes.pop(fix);
+}
+
+int PositionEngine::takeDroppedCount()
+{
+    return m_dropped.fetchAndStoreRelaxed(0);
+}
+
+int PositionEngine::takeDroppedLineCount()
+{
+    return m_droppedLines.fetchAndStoreRelaxed(0);
+}
+
+void PositionEngine::publishConfig(const PipelineConfigPtr &config)
+{
+    m_configMailbox.publish(config);
+}
+
+void PositionEngine::setFeedPublisher(FeedPublisher *feed)
+{
+    m_feed = feed;
+}
+
+void PositionEngine::openPorts(const QStringList &portNames, qint32 baudRate)
+{
+    closePorts();
+
+    m_merger.clear();
+    m_merger.setWindow(liveMergeWindowNs(qMin(portNames.size(), int(MaxPorts))));
+
+    for (int i = 0; i < portNames.size() && i < MaxPorts; ++i) {
+        Port port;
+        port.name = portNames.at(i);
+        port.opened = false;
+        port.thread = new QThread(this);
+        port.listener = new SerialListener(i, m_clock, &m_latency);
+        port.listener->moveToThread(port.thread);
+        connect(port.listener, &SerialListener::opened, this, &PositionEngine::onListenerOpened);
+        connect(port.listener, &SerialListener::openFailed, this, &PositionEngine::onListenerOpenFailed);
+        connect(port.listener, &SerialListener::lost, this, &PositionEngine::onListenerLost);
+        connect(port.listener, &SerialListener::linesReady, this, &PositionEngine::onLinesReady);
+        port.thread->start();
+        m_ports.append(port);
+
+        SerialListener *listener = port.listener;
+        QString name = port.name;
+        QMetaObject::invokeMethod(listener, [=](){ listener->open(name, baudRate); }, Qt::QueuedConnection);
+    }
+
+    if (m_ports.size() > 1) {
+        if (!m_mergeTimer) {
+            m_mergeTimer = new QTimer(this);
+            connect(m_mergeTimer, &QTimer::timeout, this, &PositionEngine::onMergeTimer);
+        }
+        m_mergeTimer->start(kMergeIntervalMs);
+    }
+}
+
+void PositionEngine::closePorts()
+{
+    if (m_mergeTimer) m_mergeTimer->stop();
+
+    for (int i = 0; i < m_ports.size(); ++i) {
+        bool wasOpen = m_ports[i].opened;
+        shutdownPort(i);
+        if (wasOpen) emit portClosed(m_ports[i].name);
+    }
+    m_ports.clear();
+
+    // 窗口中剩余的包立即处理
+    m_merger.releaseAll(m_released);
+    processReleased();
+}
+
+void PositionEngine::shutdownPort(int index)
+{
+    Port &port = m_ports[index];
+    if (!port.listener) return;
+
+    // 先取走已读到的行, 再停止线程
+    drainListeners();
+    QMetaObject::invokeMethod(port.listener, "close", Qt::BlockingQueuedConnection);
+    port.thread->quit();
+    port.thread->wait();
+    delete port.listener;
+    delete port.thread;
+    port.listener = nullptr;
+    port.thread = nullptr;
+    port.opened = false;
+}
+
+void PositionEngine::onListenerOpened(int index, const QString &portName)
+{
+    if (index >= m_ports.size() || !m_ports[index].listener) return;
+    m_ports[index].opened = true;
+    emit portOpened(portName);
+}
+
+void PositionEngine::onListenerOpenFailed(int index, const QString &error)
+{
+    if (index >= m_ports.size() || !m_ports[index].listener) return;
+    shutdownPort(index);
+    emit portOpenFailed(m_ports[index].name, error);
+}
+
+void PositionEngine::onListenerLost(int index)
+{
+    if (index >= m_ports.size() || !m_ports[index].listener) return;
+    shutdownPort(index);
+    emit portLost(m_ports[index].name);
+}
+
+void PositionEngine::onLinesReady(int index)
+{
+    Q_UNUSED(index);
+    drainListeners();
+    m_merger.release(m_clock.nsecsElapsed(), m_released);
+    processReleased();
+}
+
+void PositionEngine::onMergeTimer()
+{
+    if (m_merger.isEmpty()) return;
+    m_merger.release(m_clock.nsecsElapsed(), m_released);
+    processReleased();
+}
+
+void PositionEngine::drainListeners()
+{
+    SerialListener::Line line;
+    for (int i = 0; i < m_ports.size(); ++i) {
+        SerialListener *listener = m_ports[i].listener;
+        if (!listener) continue;
+
+        listener->rearmNotification();
+        while (listener->takeLine(line)) {
+            // 录制原始行, 来源为串口编号
+            if (m_capture) {
+                if (line.oversized.isEmpty())
+                    m_capture->append(line.timeNs, i, line.data, line.length);
+                else
+                    m_capture->append(line.timeNs, i, line.oversized.constData(), line.oversized.size());
+            }
+            // 同一串口的重发在合并器里就被丢弃, 只在此计入序号统计
+            if (line.parsed && m_merger.push(line.packet, line.timeNs, i) == StreamMerger::Repeated)
+                m_pipeline.countDuplicate(line.packet);
+        }
+
+        int dropped = listener->takeDroppedCount();
+        if (dropped > 0) m_droppedLines.fetchAndAddRelaxed(dropped);
+    }
+}
+
+void PositionEngine::startCapture(const QString &directory, qint64 maxBytes, int maxSeconds)
+{
+    stopCapture();
+
+    m_capture = new CaptureWriter(this);
+    connect(m_capture, &CaptureWriter::fileOpened, this, &PositionEngine::captureStarted);
+    connect(m_capture, &CaptureWriter::writeError, this, &PositionEngine::captureError);
+
+    if (!m_capture->open(directory, maxBytes, maxSeconds, QDateTime::currentMSecsSinceEpoch(), m_clock.nsecsElapsed())) {
+        delete m_capture;
+        m_capture = nullptr;
+        return;
+    }
+
+    // 低速数据时也定期把未满的缓冲区交给写盘线程
+    if (!m_captureFlushTimer) {
+        m_captureFlushTimer = new QTimer(this);
+        connect(m_captureFlushTimer, &QTimer::timeout, this, &PositionEngine::onCaptureFlushTimer);
+    }
+    m_captureFlushTimer->start(250);
+}
+
+void PositionEngine::stopCapture()
+{
+    if (!m_capture) return;
+
+    m_captureFlushTimer->stop();
+    m_capture->close();
+    emit captureStopped(m_capture->bytesWritten(), m_capture->droppedRecords());
+    delete m_capture;
+    m_capture = nullptr;
+}
+
+void PositionEngine::onCaptureFlushTimer()
+{
+    if (m_capture) m_capture->flush();
+}
+
+void PositionEngine::startReplay(const QString &path, double speed)
+{
+    stopReplay();
+
+    m_replay = new CaptureReader;
+    if (!m_replay->open(path)) {
+        emit replayError(path + ": " + m_replay->errorString());
+        delete m_replay;
+        m_replay = nullptr;
+        return;
+    }
+
+    if (!m_replayTimer) {
+        m_replayTimer = new QTimer(this);
+        m_replayTimer->setTimerType(Qt::PreciseTimer);
+        connect(m_replayTimer, &QTimer::timeout, this, &PositionEngine::onReplayTick);
+    }
+
+    m_pipeline.reset();
+    m_merger.clear();
+    m_merger.setWindow(StreamMerger::DefaultWindowMs * 1000000LL);
+    m_feedEpochUs = m_replay->wallMs() * 1000 - m_replay->monoNs() / 1000;
+    m_replayOffset = m_replay->beginOffset();
+    m_replayPosNs = m_replayBaseNs = m_replay->firstTimeNs();
+    m_replayLastProgressMs = 0;
+    m_replayClock.start();
+    setReplaySpeed(speed);
+
+    emit replayStarted(m_replay->firstTimeNs(), m_replay->lastTimeNs(), m_replay->recordCount());
+}
+
+void PositionEngine::stopReplay()
+{
+    if (!m_replay) return;
+
+    m_replayTimer->stop();
+    delete m_replay;
+    m_replay = nullptr;
+    m_feedEpochUs = m_liveEpochUs;
+
+    // 窗口内尚未放行的包带着录制文件的时间, 不能当作实时数据发出;
+    // 滤波状态也属于回放, 恢复实时串口的合并窗口
+    m_merger.clear();
+    m_pipeline.reset();
+    m_merger.setWindow(liveMergeWindowNs(m_ports.size()));
+    emit replayFinished();
+}
+
+void PositionEngine::seekReplay(qint64 timeNs)
+{
+    if (!m_replay) return;
+
+    m_pipeline.reset();
+    m_merger.clear();
+    m_replayOffset = m_replay->seek(timeNs);
+    m_replayPosNs = m_replayBaseNs = timeNs;
+    m_replayClock.restart();
+}
+
+void PositionEngine::setReplaySpeed(double speed)
+{
+    // 以当前回放位置为新的时间基准, 改变倍速时不跳变
+    m_replayBaseNs = m_replayPosNs;
+    m_replayClock.restart();
+    m_replaySpeed = speed;
+
+    if (m_replay)
+        m_replayTimer->start(speed > 0 ? 1 : 0);
+}
+
+void PositionEngine::onReplayTick()
+{
+    // 每次最多处理固定条数, 保证尽快模式下也能及时响应停止/跳转
+    const int MaxRecordsPerTick = 4096;
+
+    qint64 dueNs = m_replaySpeed > 0
+            ? m_replayBaseNs + qint64(m_replayClock.nsecsElapsed() * m_replaySpeed)
+            : std::numeric_limits<qint64>::max();
+
+    CaptureReader::Record record;
+    for (int n = 0; n < MaxRecordsPerTick; ++n) {
+        qint64 offset = m_replayOffset;
+        if (!m_replay->next(offset, record)) {
+            m_merger.releaseAll(m_released);
+            processReleased();
+            emit replayProgress(m_replayPosNs);
+            stopReplay();
+            return;
+        }
+        if (record.timeNs > dueNs) break;
+
+        m_replayOffset = offset;
+        m_replayPosNs = record.timeNs;
+
+        // 与实时数据相同: 按来源串口合并去重
+        int len = record.length;
+        while (len > 0 && (record.data[len - 1] == '\r' || record.data[len - 1] == ' ')) --len;
+        RangePacket packet;
+        if (len > 0 && parseRangeLine(record.data, len, packet)
+                && m_merger.push(packet, record.timeNs, record.source) == StreamMerger::Repeated)
+            m_pipeline.countDuplicate(packet);
+    }
+    m_merger.release(m_replayPosNs, m_released);
+    processReleased();
+
+    qint64 nowMs = m_replayClock.elapsed();
+    if (nowMs - m_replayLastProgressMs >= 250 || nowMs < m_replayLastProgressMs) {
+        m_replayLastProgressMs = nowMs;
+        emit replayProgress(m_replayPosNs);
+    }
+}
+
+void PositionEngine::startSharedMemory(const QString &name)
+{
+    if (m_shm.open(name))
+        emit sharedMemoryStarted(name);
+    else
+        emit sharedMemoryError(m_shm.errorString());
+}
+
+void PositionEngine::stopSharedMemory()
+{
+    m_shm.close();
+}
+
+void PositionEngine::processReleased()
+{
+    if (m_released.isEmpty()) return;
+
+    PipelineConfigPtr config;
+    if (m_configMailbox.take(config))
+        m_pipeline.setConfig(config);
+
+    if (m_fixBatch.size() < m_released.size())
+        m_fixBatch.resize(m_released.size());
+
+    // 统计关闭时解算器不打时间戳 (无效时钟)
+    bool trace = m_latency.isEnabled();
+    if (trace != m_tracing) {
+        m_tracing = trace;
+        m_pipeline.setClock(trace ? m_clock : QElapsedTimer());
+    }
+
+    // 回放包的到达时间来自录制文件, 与本机时钟无关
+    bool live = !m_replay;
+    qint64 releasedNs = trace ? m_clock.nsecsElapsed() : 0;
+    if (live && trace) {
+        for (const TimedPacket &item : m_released)
+            m_latency.record(LatencyStats::StageMerge, releasedNs - item.timestampNs);
+    }
+
+    int count = m_pipeline.processPackets(m_released.constData(), m_released.size(), m_fixBatch.data());
+    for (int i = 0; i < count; ++i) {
+        TagFix &fix = m_fixBatch[i];
+        if (trace && fix.status == TagFix::Ok) {
+            m_latency.record(LatencyStats::StageSolve, fix.solvedNs - releasedNs);
+            m_latency.record(LatencyStats::StageFilter, fix.filteredNs - fix.solvedNs);
+        }
+        // GUI 以 filteredNs 非零判断该结果可继续统计排队与绘制延迟 (统计关闭时本来为 0)
+        if (!live) fix.filteredNs = 0;
+        publish(fix);
+    }
+    m_released.clear();
+}
+
+void PositionEngine::publish(const TagFix &fix)
+{
+    if (m_feed && m_feed->isActive())
+        m_feed->offer(toFeedRecord(fix, m_feedEpochUs));
+    if (m_shm.isOpen() && fix.status == TagFix::Ok)
+        m_shm.publish(toShmPosition(fix, m_feedEpochUs));
+
+    if (!m_fixes.push(fix)) {
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    // 只在 GUI 取空队列后才再次通知, 避免事件队列被信号淹没
+    if (m_notifyPending.testAndSetOrdered(0, 1))
+        emit fixesReady();
+}
@@ -0,0 +1,160 @@
+#ifndef POSITIONENGINE_H
+#define POSITIONENGINE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QVector>
+#include <QStringList>
+#include "positionpipeline.h"
+#include "shmpublisher.h"
+#include "spscqueue.h"
+#include "latencystats.h"
+
+class CaptureWriter;
+class CaptureReader;
+class FeedPublisher;
+class SerialListener;
+class QThread;
+class QTimer;
+
+// ==========================================
+// PositionEngine: 多串口合并 -> 解算 -> 滤波
+// 运行在独立线程; 每个串口由各自线程的 SerialListener 读取并解析,
+// 引擎按时间合并、去重后解算; 结果通过无锁队列交给 GUI,
+// GUI 卡顿时只会积压队列, 不会阻塞串口读取
+// ==========================================
+class PositionEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum {
+        QueueCapacity = 8192,
+        MaxPorts = 8
+    };
+
+    explicit PositionEngine(QObject *parent = nullptr);
+    ~PositionEngine();
+
+    // GUI 线程调用: 先重新允许通知, 再取出已完成的结果
+    void rearmNotification();
+    bool takeFix(TagFix &fix);
+    // 队列满时被丢弃的结果数量 (读取后清零)
+    int takeDroppedCount();
+    // 串口队列满或行过长而丢弃的行数 (读取后清零)
+    int takeDroppedLineCount();
+    // 任意线程调用: 发布新的基站/参数快照, 引擎在处理下一包前无锁切换
+    void publishConfig(const PipelineConfigPtr &config);
+    // 结果同时交给局域网发布器 (可为空); 须在引擎线程启动前调用
+    void setFeedPublisher(FeedPublisher *feed);
+
+    // 分阶段延迟统计, 任意线程可读; 时间戳均取自 clock(), 默认关闭 (LatencyStats::setEnabled)
+    LatencyStats *latencyStats() { return &m_latency; }
+    const QElapsedTimer &clock() const { return m_clock; }
+
+    // 引擎线程调用 (经 invokeMethod): 各标签的序号/丢包统计, 开始回放或跳转时清空;
+    // 多串口合并的重复包计数 (累计值), resetSequenceStats() 时一起清零
+    QVector<SeqStats> sequenceStats() const { return m_pipeline.sequenceStats(); }
+    qint64 fusedCount() const { return m_merger.fusedCount(); }
+    qint64 lateCount() const { return m_merger.lateCount(); }
+    void resetSequenceStats() { m_pipeline.resetSequenceStats(); m_merger.resetCounters(); }
+
+public slots:
+    // 同时打开多个串口, 每个串口的结果各自通过 portOpened/portOpenFailed 报告
+    void openPorts(const QStringList &portNames, qint32 baudRate);
+    void closePorts();
+
+    // 会话录制: 原始行按到达时间写入二进制文件
+    void startCapture(const QString &directory, qint64 maxBytes, int maxSeconds);
+    void stopCapture();
+
+    // 录制回放: 与串口数据一样按来源合并去重后解算
+    // speed 为倍速, <= 0 表示尽可能快
+    void startReplay(const QString &path, double speed);
+    void stopReplay();
+    void seekReplay(qint64 timeNs);
+    void setReplaySpeed(double speed);
+
+    // 共享内存定位环: 供本机其他进程无锁读取 (见 uwbshm/uwbshm.h)
+    void startSharedMemory(const QString &name);
+    void stopSharedMemory();
+
+signals:
+    void portOpened(const QString &portName);
+    void portOpenFailed(const QString &portName, const QString &error);
+    void portClosed(const QString &portName);
+    void portLost(const QString &portName);
+    void fixesReady();
+    void captureStarted(const QString &path);
+    void captureStopped(qint64 bytesWritten, int droppedRecords);
+    void captureError(const QString &error);
+    void replayStarted(qint64 firstTimeNs, qint64 lastTimeNs, qint64 recordCount);
+    void replayProgress(qint64 timeNs);
+    void replayFinished();
+    void replayError(const QString &error);
+    void sharedMemoryStarted(const QString &name);
+    void sharedMemoryError(const QString &error);
+
+private slots:
+    void onListenerOpened(int index, const QString &portName);
+    void onListenerOpenFailed(int index, const QString &error);
+    void onListenerLost(int index);
+    void onLinesReady(int index);
+    void onMergeTimer();
+    void onCaptureFlushTimer();
+    void onReplayTick();
+
+private:
+    struct Port {
+        QString name;
+        QThread *thread;
+        SerialListener *listener;   // 关闭后为 nullptr
+        bool opened;
+    };
+
+    void shutdownPort(int index);
+    // 取出各串口队列中的行: 录制并送入合并器
+    void drainListeners();
+    // 解算 m_released 中的包并清空
+    void processReleased();
+    void publish(const TagFix &fix);
+
+    QVector<Port> m_ports;          // 下标即串口编号 (录制来源)
+    StreamMerger m_merger;
+    QTimer *m_mergeTimer;
+    QVector<TimedPacket> m_released;
+    QElapsedTimer m_clock;
+    CaptureWriter *m_capture;       // 非空表示正在录制
+    QTimer *m_captureFlushTimer;
+
+    // 回放状态
+    CaptureReader *m_replay;        // 非空表示正在回放
+    QTimer *m_replayTimer;
+    qint64 m_replayOffset;
+    double m_replaySpeed;
+    QElapsedTimer m_replayClock;
+    qint64 m_replayBaseNs;          // m_replayClock 起点对应的录制时间
+    qint64 m_replayPosNs;
+    qint64 m_replayLastProgressMs;
+
+    // 发布时间戳换算: Unix 纪元 (us) = m_feedEpochUs + 单调时钟 (ns) / 1000
+    FeedPublisher *m_feed;
+    qint64 m_liveEpochUs;
+    qint64 m_feedEpochUs;           // 回放时按录制文件的墙上时间换算
+    ShmPublisher m_shm;
+
+    LatencyStats m_latency;
+    bool m_tracing;                 // 解算器当前是否打时间戳, 跟随 m_latency 的开关
+
+    PipelineConfigMailbox m_configMailbox;
+    // 只在引擎线程访问
+    PositionPipeline m_pipeline;
+    QVector<TagFix> m_fixBatch;
+
+    SpscQueue<TagFix, QueueCapacity> m_fixes;
+    QAtomicInt m_notifyPending;
+    QAtomicInt m_dropped;
+    QAtomicInt m_droppedLines;
+};
+
+#endif // POSITIONENGINE_H
@@ -0,0 +1,45 @@
+# 定位核心算法与录制文件 (只依赖 QtCore), 供 uwbserial 与 uwbbench 共用
+
+INCLUDEPATH += $$PWD $$PWD/../uwbshm
+
+# 共享内存定位环 (shm_open)
+unix:!macx: LIBS += -lrt
+
+# 闭式解使用单精度运算 (见 trilateration.h)
+# DEFINES += UWB_SOLVER_FLOAT
+
+SOURCES += \
+    $$PWD/batchsolver.cpp \
+    $$PWD/capturefile.cpp \
+    $$PWD/feedformat.cpp \
+    $$PWD/latencystats.cpp \
+    $$PWD/pipelineconfig.cpp \
+    $$PWD/positionpipeline.cpp \
+    $$PWD/rangeparser.cpp \
+    $$PWD/robustsolver.cpp \
+    $$PWD/seqtracker.cpp \
+    $$PWD/shmpublisher.cpp \
+    $$PWD/streammerger.cpp \
+    $$PWD/tagfilter.cpp \
+    $$PWD/taggrid.cpp \
+    $$PWD/trailstore.cpp \
+    $$PWD/trilateration.cpp
+
+HEADERS += \
+    $$PWD/batchsolver.h \
+    $$PWD/capturefile.h \
+    $$PWD/feedformat.h \
+    $$PWD/latencystats.h \
+    $$PWD/pipelineconfig.h \
+    $$PWD/positionpipeline.h \
+    $$PWD/rangeparser.h \
+    $$PWD/robustsolver.h \
+    $$PWD/seqtracker.h \
+    $$PWD/shmpublisher.h \
+    $$PWD/spscqueue.h \
+    $$PWD/streammerger.h \
+    $$PWD/tagfilter.h \
+    $$PWD/taggrid.h \
+    $$PWD/trailstore.h \
+    $$PWD/trilateration.h \
+    $$PWD/../uwbshm/uwbshm.h
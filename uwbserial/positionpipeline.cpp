@@ -0,0 +1,285 @@
+#include "positionpipeline.h"
+
+namespace {
+// 迭代收敛判据 (cm)
+const double kSolverTolerance = 0.5;
+// 热启动结果的残差均方根超过该值时, 认为可能收敛到了错误的极小值, 改用闭式解作初值
+const double kWarmStartMaxRms = 100.0;
+}
+
+PositionPipeline::PositionPipeline()
+    : m_config(new PipelineConfig(QMap<int, QPoint>(), PipelineSettings())), m_robustTruncated(0)
+{
+}
+
+void PositionPipeline::setConfig(const PipelineConfigPtr &config)
+{
+    if (!config) return;
+    m_config = config;
+}
+
+void PositionPipeline::setClock(const QElapsedTimer &clock)
+{
+    m_clock = clock;
+}
+
+void PositionPipeline::reset()
+{
+    m_lastTagPoint.clear();
+    m_kalman.clear();
+    m_seq.clear();
+}
+
+QVector<SeqStats> PositionPipeline::sequenceStats() const
+{
+    QVector<SeqStats> stats;
+    stats.reserve(m_seq.size());
+    for (auto it = m_seq.constBegin(); it != m_seq.constEnd(); ++it) {
+        stats.append(it->stats());
+        stats.last().tid = it.key();
+    }
+    return stats;
+}
+
+void PositionPipeline::resetSequenceStats()
+{
+    m_seq.clear();
+}
+
+void PositionPipeline::trackSequence(const RangePacket &packet, qint64 timestampNs)
+{
+    // 没有 seq 字段的报文不统计
+    if (packet.seq < 0) return;
+    m_seq[packet.tid].update(packet.seq, timestampNs);
+}
+
+void PositionPipeline::countDuplicate(const RangePacket &packet)
+{
+    if (packet.seq < 0) return;
+    m_seq[packet.tid].addDuplicate();
+}
+
+bool PositionPipeline::process(const char *data, int len, qint64 timestampNs, TagFix &fix)
+{
+    RangePacket packet;
+    if (!parseRangeLine(data, len, packet)) return false;
+    trackSequence(packet, timestampNs);
+    if (packet.count < 3) return false;
+
+    double x, y;
+    if (solve(packet, timestampNs, fix, x, y))
+        filter(x, y, fix);
+    return true;
+}
+
+int PositionPipeline::processBatch(const PipelineInput *lines, int count, TagFix *fixes)
+{
+    m_packets.clear();
+    for (int i = 0; i < count; ++i) {
+        TimedPacket item;
+        if (!parseRangeLine(lines[i].data, lines[i].length, item.packet)) continue;
+        item.timestampNs = lines[i].timestampNs;
+        item.sources = 1;
+        m_packets.append(item);
+    }
+    return processPackets(m_packets.constData(), m_packets.size(), fixes);
+}
+
+int PositionPipeline::processPackets(const TimedPacket *packets, int count, TagFix *fixes)
+{
+    int produced = 0;
+
+    for (int i = 0; i < count; ++i)
+        trackSequence(packets[i].packet, packets[i].timestampNs);
+
+    // 迭代解算依赖各标签上一次的输出, 逐包处理
+    if (m_config->settings().solverMode != SolverClosedForm) {
+        for (int i = 0; i < count; ++i) {
+            if (packets[i].packet.count < 3) continue;
+            double x, y;
+            if (solve(packets[i].packet, packets[i].timestampNs, fixes[produced], x, y))
+                filter(x, y, fixes[produced]);
+            ++produced;
+        }
+        return produced;
+    }
+
+    int next = 0;
+    while (next < count) {
+        // 1. 收集到 SoA 批次, fixes[first, produced) 为本批结果
+        int first = produced;
+        m_batch.clear();
+        for (; next < count && !m_batch.isFull(); ++next) {
+            if (packets[next].packet.count < 3) continue;
+
+            RangeSet set;
+            if (collect(packets[next].packet, packets[next].timestampNs, fixes[produced], set))
+                m_batch.append(set);
+            ++produced;
+        }
+
+        // 2. 向量化解算
+        solveBatch(m_batch, m_batchX, m_batchY, m_batchOk);
+        qint64 solvedNs = stamp();
+        for (int i = first; i < produced; ++i)
+            fixes[i].solvedNs = solvedNs;
+
+        // 3. 按到达顺序滤波, 保证同一标签的多包依次更新滤波状态
+        int slot = 0;
+        for (int i = first; i < produced; ++i) {
+            TagFix &fix = fixes[i];
+            if (fix.status != TagFix::Ok) continue;
+            if (m_batchOk[slot]) {
+                filter(m_batchX[slot], m_batchY[slot], fix);
+            } else {
+                fix.status = TagFix::CalcFailed;
+            }
+            ++slot;
+        }
+    }
+    return produced;
+}
+
+// --------------------------------------------------------
+// 示例格式: AT+RANGE=tid:1,mask:80,seq:65,range:(0,0,0,0,0,0,0,107),ancid:(-1,-1,-1,-1,-1,-1,-1,7)
+// --------------------------------------------------------
+bool PositionPipeline::parse(const char *data, int len, RangePacket &packet) const
+{
+    return parseRangeLine(data, len, packet) && packet.count >= 3;
+}
+
+bool PositionPipeline::collect(const RangePacket &packet, qint64 timestampNs, TagFix &fix, RangeSet &set) const
+{
+    const PipelineConfig &config = *m_config;
+
+    fix.tid = packet.tid;
+    fix.seq = packet.seq;
+    fix.timestampNs = timestampNs;
+    fix.x = 0;
+    fix.y = 0;
+    fix.vx = 0;
+    fix.vy = 0;
+    fix.solvedNs = 0;
+    fix.filteredNs = 0;
+    fix.anchorCount = 0;
+    fix.rejectedMask = 0;
+
+    set.count = 0;
+
+    for (int i = 0; i < packet.count; i++) {
+        int aid = packet.ancid[i];
+        const PipelineConfig::Anchor *anchor = config.anchor(aid);
+        if (anchor) {
+            set.anchorId[set.count] = aid;
+            set.x[set.count] = anchor->x;
+            set.y[set.count] = anchor->y;
+            set.r[set.count] = packet.range[i];
+            ++set.count;
+
+            fix.anchorId[fix.anchorCount] = aid;
+            fix.range[fix.anchorCount] = packet.range[i];
+            ++fix.anchorCount;
+        }
+    }
+
+    if (set.count < 3) {
+        fix.status = TagFix::NotEnoughAnchors;
+        return false;
+    }
+    fix.status = TagFix::Ok;
+    return true;
+}
+
+bool PositionPipeline::solve(const RangePacket &packet, qint64 timestampNs, TagFix &fix, double &x, double &y) const
+{
+    const PipelineSettings &settings = m_config->settings();
+
+    RangeSet set;
+    if (!collect(packet, timestampNs, fix, set)) return false;
+
+    bool solved = false;
+    if (settings.solverMode == SolverGaussNewton) {
+        // 以该标签上一次的输出位置为初值
+        double warmX = 0, warmY = 0, rms = 0;
+        bool warm = false;
+        auto last = m_lastTagPoint.constFind(packet.tid);
+        if (last != m_lastTagPoint.constEnd()) {
+            warmX = last->x();
+            warmY = last->y();
+            warm = refinePosition(set, warmX, warmY, settings.maxIterations, kSolverTolerance, &rms);
+        }
+
+        if (warm && rms < kWarmStartMaxRms) {
+            x = warmX;
+            y = warmY;
+            solved = true;
+        } else if (calculatePosition(set, x, y)) {
+            // 闭式解作初值; 迭代失败时保留闭式解
+            double cx = x, cy = y;
+            if (!refinePosition(set, x, y, settings.maxIterations, kSolverTolerance)) {
+                x = cx;
+                y = cy;
+            }
+            solved = true;
+        } else if (warm) {
+            x = warmX;
+            y = warmY;
+            solved = true;
+        }
+    } else if (settings.solverMode == SolverRobust) {
+        RobustOptions options;
+        options.inlierThreshold = settings.robustThreshold;
+        options.budgetNs = qint64(settings.robustBudgetUs) * 1000;
+        options.maxIterations = settings.maxIterations;
+
+        RobustResult robust;
+        solved = solveRobust(set, options, robust);
+        if (solved) {
+            x = robust.x;
+            y = robust.y;
+            fix.rejectedMask = robust.rejectedMask;
+        }
+        if (robust.truncated) ++m_robustTruncated;
+    } else {
+        solved = calculatePosition(set, x, y);
+    }
+
+    fix.solvedNs = stamp();
+    if (!solved) {
+        fix.status = TagFix::CalcFailed;
+        return false;
+    }
+
+    fix.status = TagFix::Ok;
+    return true;
+}
+
+void PositionPipeline::filter(double x, double y, TagFix &fix)
+{
+    const PipelineSettings &settings = m_config->settings();
+    if (settings.filterMode == FilterKalman) {
+        TagKalmanFilter &kf = m_kalman[fix.tid];
+        kf.update(x, y, fix.timestampNs, settings.processNoise, settings.measurementNoise);
+        fix.x = kf.x();
+        fix.y = kf.y();
+        fix.vx = kf.vx();
+        fix.vy = kf.vy();
+        m_lastTagPoint[fix.tid] = QPointF(fix.x, fix.y);
+        fix.filteredNs = stamp();
+        return;
+    }
+
+    QPoint rawPos(qRound(x), qRound(y));
+    QPoint finalPos = rawPos;
+    auto last = m_lastTagPoint.find(fix.tid);
+    if (last != m_lastTagPoint.end()) {
+        finalPos = smoothPosition(last->toPoint(), rawPos, settings.threshold);
+        *last = finalPos;
+    } else {
+        m_lastTagPoint.insert(fix.tid, finalPos);
+    }
+
+    fix.x = finalPos.x();
+    fix.y = finalPos.y();
+    fix.filteredNs = stamp();
+}
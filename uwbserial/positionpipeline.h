@@ -0,0 +1,119 @@
+#ifndef POSITIONPIPELINE_H
+#define POSITIONPIPELINE_H
+
+#include <QMap>
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+#include <QElapsedTimer>
+#include "rangeparser.h"
+#include "trilateration.h"
+#include "tagfilter.h"
+#include "pipelineconfig.h"
+#include "batchsolver.h"
+#include "robustsolver.h"
+#include "streammerger.h"
+#include "seqtracker.h"
+
+// ==========================================
+// TagFix: 一次解算结果, 由引擎线程交给 GUI 线程
+// ==========================================
+struct TagFix {
+    enum Status {
+        Ok,
+        NotEnoughAnchors,
+        CalcFailed
+    };
+
+    int tid;
+    int seq;
+    Status status;
+    qint64 timestampNs;     // 收到数据时的单调时钟 (ns)
+    double x;               // 滤波后坐标 (cm)
+    double y;
+    double vx;              // 估计速度 (cm/s), 无速度估计的滤波器为 0
+    double vy;
+    qint64 solvedNs;        // 解算/滤波完成的时间 (单调时钟 ns), 未设置时钟时为 0
+    qint64 filteredNs;
+    int anchorCount;        // 参与解算的已知基站数量
+    quint8 rejectedMask;    // 稳健解算剔除的基站, 第 i 位对应 anchorId[i]
+    int anchorId[RangePacket::MaxSlots];
+    int range[RangePacket::MaxSlots];
+
+    // 实际用于定位的基站数 (去掉被剔除的)
+    int usedAnchorCount() const
+    {
+        int n = anchorCount;
+        for (quint8 m = rejectedMask; m; m &= m - 1) --n;
+        return n;
+    }
+};
+
+// 一行原始数据 (不含换行符), 指针在 processBatch 返回前有效
+struct PipelineInput {
+    const char *data;
+    int length;
+    qint64 timestampNs;
+};
+
+// ==========================================
+// PositionPipeline: 解析 -> 解算 -> 滤波, 不依赖串口与界面
+// 由 PositionEngine 驱动, 也供 uwbbench 按阶段计时
+// ==========================================
+class PositionPipeline
+{
+public:
+    PositionPipeline();
+
+    // 切换到新的基站/参数快照; 初始为空基站表 + 默认参数
+    void setConfig(const PipelineConfigPtr &config);
+    const PipelineConfigPtr &config() const { return m_config; }
+    // 稳健解算因时间预算用尽而提前结束的次数
+    qint64 robustTruncated() const { return m_robustTruncated; }
+    // 清空各标签的滤波状态与序号统计
+    void reset();
+    // 设置后为结果打上 solvedNs / filteredNs 时间戳, 用于分阶段延迟统计
+    void setClock(const QElapsedTimer &clock);
+
+    // 各标签的序号统计 (process/processBatch/processPackets 收到的每一包, 含基站不足的)
+    QVector<SeqStats> sequenceStats() const;
+    // 合并器丢弃的同一串口重复包 (StreamMerger::Repeated), 计入该标签的重复数
+    void countDuplicate(const RangePacket &packet);
+    void resetSequenceStats();
+
+    // 完整流程; 返回 false 表示不是有效报文, 不产生结果
+    bool process(const char *data, int len, qint64 timestampNs, TagFix &fix);
+    // 批量处理同一次读取到的多行, 闭式解模式下按 RangeBatch 向量化解算。
+    // fixes 至少 count 项, 返回写入的结果数 (无效报文不产生结果), 顺序与输入一致
+    int processBatch(const PipelineInput *lines, int count, TagFix *fixes);
+    // 同上, 输入为已解析 (并已合并去重) 的报文; 基站不足 3 个的报文不产生结果
+    int processPackets(const TimedPacket *packets, int count, TagFix *fixes);
+
+    // 分阶段接口
+    bool parse(const char *data, int len, RangePacket &packet) const;
+    // 填充 fix 的报文信息与参与基站; 返回 true 表示解出原始坐标 (x, y)
+    bool solve(const RangePacket &packet, qint64 timestampNs, TagFix &fix, double &x, double &y) const;
+    // 对原始坐标做平滑, 写入 fix
+    void filter(double x, double y, TagFix &fix);
+
+private:
+    // 填充 fix 的报文信息并查出已知基站; 不足 3 个时标记 NotEnoughAnchors 并返回 false
+    bool collect(const RangePacket &packet, qint64 timestampNs, TagFix &fix, RangeSet &set) const;
+
+    void trackSequence(const RangePacket &packet, qint64 timestampNs);
+    qint64 stamp() const { return m_clock.isValid() ? m_clock.nsecsElapsed() : 0; }
+
+    PipelineConfigPtr m_config;
+    QElapsedTimer m_clock;
+    mutable qint64 m_robustTruncated;
+    QVector<TimedPacket> m_packets;             // processBatch() 的工作区
+    RangeBatch m_batch;
+    double m_batchX[RangeBatch::Capacity];
+    double m_batchY[RangeBatch::Capacity];
+    quint8 m_batchOk[RangeBatch::Capacity];
+    QMap<int, QPointF> m_lastTagPoint;         // 各标签上一次输出位置
+    QHash<int, TagKalmanFilter> m_kalman;
+    QHash<int, SeqTracker> m_seq;
+};
+
+#endif // POSITIONPIPELINE_H
@@ -0,0 +1,159 @@
+#include "rangeparser.h"
+#include <cstring>
+
+namespace {
+
+const char kPrefix[] = "AT+RANGE=";
+const int kPrefixLen = sizeof(kPrefix) - 1;
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// 十进制整数最多的位数, 超过时视为无效值 (损坏的行里可能有很长的数字串)
+const int kMaxIntDigits = 9;
+
+// 解析十进制整数 (可带负号), 成功时移动游标; 位数超限时跳过整串数字并返回 false
+inline bool parseInt(const char *&p, const char *end, int &value)
+{
+    bool neg = false;
+    if (p < end && *p == '-') {
+        neg = true;
+        ++p;
+    }
+    if (p >= end || *p < '0' || *p > '9') return false;
+
+    int v = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (++digits > kMaxIntDigits) {
+            while (p < end && *p >= '0' && *p <= '9') ++p;
+            return false;
+        }
+        v = v * 10 + (*p - '0');
+        ++p;
+    }
+    value = neg ? -v : v;
+    return true;
+}
+
+inline bool parseHex(const char *&p, const char *end, quint32 &value)
+{
+    quint32 v = 0;
+    const char *start = p;
+    while (p < end) {
+        char c = *p;
+        if (c >= '0' && c <= '9') v = (v << 4) | quint32(c - '0');
+        else if (c >= 'a' && c <= 'f') v = (v << 4) | quint32(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v = (v << 4) | quint32(c - 'A' + 10);
+        else break;
+        ++p;
+    }
+    value = v;
+    return p != start;
+}
+
+// 跳过一个槽位的值 (不做数值转换)
+inline void skipValue(const char *&p, const char *end)
+{
+    while (p < end && *p != ',' && *p != ')') ++p;
+}
+
+// 解析 "(v0,v1,...)" 形式的数组, 最多 RangePacket::MaxSlots 个槽位。
+// mask 非零时未置位的槽位只跳过不转换, 对应值记为 -1。
+inline bool parseList(const char *&p, const char *end, quint32 mask, int *out)
+{
+    if (p >= end || *p != '(') return false;
+    ++p;
+
+    for (int i = 0; i < RangePacket::MaxSlots; ++i) {
+        out[i] = -1;
+        if (p >= end || *p == ')') continue;
+
+        if (mask && !(mask & (1u << i))) {
+            skipValue(p, end);
+        } else if (!parseInt(p, end, out[i])) {
+            skipValue(p, end);
+            out[i] = -1;
+        }
+        if (p < end && *p == ',') ++p;
+    }
+
+    // 多余槽位与右括号
+    while (p < end && *p != ')') ++p;
+    if (p < end) ++p;
+    return true;
+}
+
+inline bool keyIs(const char *key, int keyLen, const char *name, int nameLen)
+{
+    return keyLen == nameLen && memcmp(key, name, nameLen) == 0;
+}
+
+} // namespace
+
+bool parseRangeLine(const char *data, int len, RangePacket &packet)
+{
+    const char *p = data;
+    const char *end = data + len;
+
+    while (p < end && isSpace(*p)) ++p;
+    while (end > p && isSpace(end[-1])) --end;
+
+    if (end - p < kPrefixLen || memcmp(p, kPrefix, kPrefixLen) != 0) return false;
+    p += kPrefixLen;
+
+    packet.tid = -1;
+    packet.mask = 0;
+    packet.seq = -1;
+    packet.count = 0;
+
+    int ranges[RangePacket::MaxSlots];
+    int ancids[RangePacket::MaxSlots];
+    bool hasRange = false;
+    bool hasAncid = false;
+
+    while (p < end) {
+        const char *key = p;
+        while (p < end && *p != ':' && *p != ',') ++p;
+        int keyLen = int(p - key);
+        if (p >= end) break;
+        if (*p == ',') { ++p; continue; }
+        ++p; // ':'
+
+        if (keyIs(key, keyLen, "tid", 3)) {
+            if (!parseInt(p, end, packet.tid)) return false;
+        } else if (keyIs(key, keyLen, "mask", 4)) {
+            parseHex(p, end, packet.mask);
+        } else if (keyIs(key, keyLen, "seq", 3)) {
+            parseInt(p, end, packet.seq);
+        } else if (keyIs(key, keyLen, "range", 5)) {
+            hasRange = parseList(p, end, packet.mask, ranges);
+        } else if (keyIs(key, keyLen, "ancid", 5)) {
+            hasAncid = parseList(p, end, packet.mask, ancids);
+        } else {
+            // 未知字段: 跳到下一个顶层逗号
+            int depth = 0;
+            while (p < end && (depth > 0 || *p != ',')) {
+                if (*p == '(') ++depth;
+                else if (*p == ')') --depth;
+                ++p;
+            }
+        }
+
+        while (p < end && *p != ',') ++p;
+        if (p < end) ++p;
+    }
+
+    if (packet.tid < 0) return false;
+    if (!hasRange || !hasAncid) return true;
+
+    for (int i = 0; i < RangePacket::MaxSlots; ++i) {
+        if (ancids[i] < 0 || ranges[i] <= 0) continue;
+        packet.ancid[packet.count] = ancids[i];
+        packet.range[packet.count] = ranges[i];
+        ++packet.count;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef RANGEPARSER_H
+#define RANGEPARSER_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+// ==========================================
+// RangePacket: 一条 AT+RANGE 报文的定长解析结果
+// 示例格式: AT+RANGE=tid:1,mask:80,seq:65,range:(0,0,0,0,0,0,0,107),ancid:(-1,-1,-1,-1,-1,-1,-1,7)
+// ==========================================
+struct RangePacket {
+    enum { MaxSlots = 8 };
+
+    int tid;
+    quint32 mask;           // 槽位掩码 (十六进制, bit i 对应第 i 个槽位), 0 表示报文未携带
+    int seq;
+    int count;              // 有效的 (ancid, range) 对数量, 已按槽位顺序压缩
+    int ancid[MaxSlots];
+    int range[MaxSlots];    // cm
+};
+
+// 单趟扫描解析一行 AT+RANGE 报文, 不做任何堆分配。
+// 只保留 ancid >= 0 且 range > 0 的槽位; mask 非零时直接跳过未置位的槽位。
+// 返回 false 表示不是 AT+RANGE 报文或缺少 tid。
+bool parseRangeLine(const char *data, int len, RangePacket &packet);
+
+inline bool parseRangeLine(const QByteArray &line, RangePacket &packet)
+{
+    return parseRangeLine(line.constData(), line.size(), packet);
+}
+
+#endif // RANGEPARSER_H
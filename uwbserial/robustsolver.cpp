@@ -0,0 +1,165 @@
+#include "robustsolver.h"
+#include <QElapsedTimer>
+#include <QtMath>
+
+namespace {
+
+// 精化的收敛判据 (cm)
+const double kRefineTolerance = 0.5;
+
+int popCount(quint32 v)
+{
+    int n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+}
+
+// 取 set 中 keep 掩码对应的基站
+void selectAnchors(const RangeSet &set, quint32 keep, RangeSet &out)
+{
+    out.count = 0;
+    for (int i = 0; i < set.count; ++i) {
+        if (!(keep & (1u << i))) continue;
+        out.anchorId[out.count] = set.anchorId[i];
+        out.x[out.count] = set.x[i];
+        out.y[out.count] = set.y[i];
+        out.r[out.count] = set.r[i];
+        ++out.count;
+    }
+}
+
+bool solveSubset(const RangeSet &subset, int maxIterations, double &x, double &y)
+{
+    if (!calculatePosition(subset, x, y)) return false;
+
+    // 闭式解作初值, 精化失败时保留闭式解
+    double cx = x, cy = y;
+    if (!refinePosition(subset, x, y, maxIterations, kRefineTolerance)) {
+        x = cx;
+        y = cy;
+    }
+    return true;
+}
+
+// 对全部基站打分, 返回截断残差和, inlierMask 为残差不超过阈值的基站
+double scorePosition(const RangeSet &set, double x, double y, double threshold, quint32 &inlierMask)
+{
+    double limit = threshold * threshold;
+    double cost = 0;
+    inlierMask = 0;
+    for (int i = 0; i < set.count; ++i) {
+        double dx = x - set.x[i];
+        double dy = y - set.y[i];
+        double res = qSqrt(dx * dx + dy * dy) - set.r[i];
+        double res2 = res * res;
+        if (res2 <= limit) {
+            inlierMask |= 1u << i;
+            cost += res2;
+        } else {
+            cost += limit;
+        }
+    }
+    return cost;
+}
+
+} // namespace
+
+bool solveRobust(const RangeSet &set, const RobustOptions &options, RobustResult &result)
+{
+    result.rejectedMask = 0;
+    result.inliers = 0;
+    result.rms = 0;
+    result.candidates = 0;
+    result.truncated = false;
+
+    const int n = set.count;
+    if (n < 3 || n > RangeSet::MaxAnchors) return false;
+
+    const quint32 all = (1u << n) - 1;
+    const double threshold = qMax(1.0, options.inlierThreshold);
+
+    QElapsedTimer timer;
+    if (options.budgetNs > 0) timer.start();
+
+    // 全部基站: 大多数情况下已全部一致, 直接返回
+    double bestX = 0, bestY = 0, bestCost = 0;
+    quint32 bestInliers = 0;
+    quint32 bestKeep = all;     // 最优位置由哪些基站解出
+    bool found = false;
+    {
+        double x, y;
+        ++result.candidates;
+        if (solveSubset(set, options.maxIterations, x, y)) {
+            bestX = x;
+            bestY = y;
+            bestCost = scorePosition(set, x, y, threshold, bestInliers);
+            found = true;
+        }
+    }
+
+    // 每层枚举完才判断: 最优子集保留的基站全部一致才停止,
+    // 本层其他子集一致但得分更差时不能停 (更深一层可能找到更好的)
+    bool consistent = found && (bestInliers & bestKeep) == bestKeep;
+    for (int k = 1; k <= n - 3 && !consistent && !result.truncated; ++k) {
+        // 依次枚举恰好去掉 k 个基站的子集 (Gosper)
+        for (quint32 drop = (1u << k) - 1; drop < (1u << n); ) {
+            quint32 keep = all & ~drop;
+            RangeSet subset;
+            selectAnchors(set, keep, subset);
+
+            double x, y;
+            ++result.candidates;
+            if (solveSubset(subset, options.maxIterations, x, y)) {
+                quint32 inliers;
+                double cost = scorePosition(set, x, y, threshold, inliers);
+                if (!found || cost < bestCost) {
+                    bestX = x;
+                    bestY = y;
+                    bestCost = cost;
+                    bestInliers = inliers;
+                    bestKeep = keep;
+                    found = true;
+                }
+            }
+
+            if (options.budgetNs > 0 && timer.nsecsElapsed() >= options.budgetNs) {
+                result.truncated = true;
+                break;
+            }
+
+            quint32 low = drop & (~drop + 1);
+            quint32 ripple = drop + low;
+            drop = (((ripple ^ drop) >> 2) / low) | ripple;
+        }
+        consistent = found && (bestInliers & bestKeep) == bestKeep;
+    }
+
+    if (!found) return false;
+
+    // 内点不足 3 个时无法判断哪些测距有问题, 保留最优子集的位置且不报告剔除
+    if (popCount(bestInliers) < 3) {
+        result.x = bestX;
+        result.y = bestY;
+        result.inliers = n;
+        result.rms = qSqrt(bestCost / n);
+        return true;
+    }
+
+    RangeSet inlierSet;
+    selectAnchors(set, bestInliers, inlierSet);
+    double x = bestX, y = bestY, rms = 0;
+    if (refinePosition(inlierSet, x, y, options.maxIterations, kRefineTolerance, &rms)) {
+        bestX = x;
+        bestY = y;
+    } else {
+        quint32 unused;
+        rms = qSqrt(scorePosition(inlierSet, bestX, bestY, threshold, unused) / inlierSet.count);
+    }
+
+    result.x = bestX;
+    result.y = bestY;
+    result.rejectedMask = quint8(all & ~bestInliers);
+    result.inliers = inlierSet.count;
+    result.rms = rms;
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef ROBUSTSOLVER_H
+#define ROBUSTSOLVER_H
+
+#include <QtGlobal>
+#include "trilateration.h"
+
+// ==========================================
+// 稳健解算: 剔除与其余基站不一致的测距 (遮挡造成的非视距测距偏长)
+//
+// 按剔除基站数由少到多枚举子集 (先全部, 再去掉 1 个, 再去掉 2 个...),
+// 每个子集做闭式解 + LM 精化, 以全部基站的截断残差 (MSAC) 打分:
+//   cost = sum min(res_i^2, threshold^2)
+// 每一层枚举完后, 迄今最优的子集其保留的基站全部一致时停止; 子集至少保留 3 个基站。
+// 最后以最优位置处残差不超过阈值的基站为内点重新精化, 其余基站报告为剔除。
+// 超出时间预算时停止枚举, 使用已找到的最优子集
+// ==========================================
+struct RobustOptions {
+    RobustOptions() : inlierThreshold(50.0), budgetNs(50000), maxIterations(8) {}
+
+    double inlierThreshold;     // 残差不超过该值 (cm) 的基站视为一致
+    qint64 budgetNs;            // 每次解算的时间预算, 0 表示不限
+    int maxIterations;          // 每个子集的 LM 迭代次数
+};
+
+struct RobustResult {
+    double x;
+    double y;
+    quint8 rejectedMask;        // 第 i 位: set 中第 i 个基站被剔除
+    int inliers;
+    double rms;                 // 内点残差均方根 (cm)
+    int candidates;             // 实际解算的子集数
+    bool truncated;             // 预算用尽, 未完成枚举
+};
+
+// 所有子集都解不出时返回 false; 基站不足 4 个时无法判断一致性, 等同于闭式解 + 精化
+bool solveRobust(const RangeSet &set, const RobustOptions &options, RobustResult &result);
+
+#endif // ROBUSTSOLVER_H
@@ -0,0 +1,122 @@
+#include "seqtracker.h"
+
+namespace {
+// 抖动的平滑系数 (RFC 3550 A.8)
+const double kJitterGain = 1.0 / 16.0;
+}
+
+SeqTracker::SeqTracker()
+{
+    clear();
+}
+
+void SeqTracker::clear()
+{
+    m_stats.tid = 0;
+    m_stats.received = 0;
+    m_stats.expected = 0;
+    m_stats.duplicates = 0;
+    m_stats.outOfOrder = 0;
+    m_stats.resyncs = 0;
+    m_stats.periodNs = 0;
+    m_stats.jitterNs = 0;
+    m_stats.lastArrivalNs = 0;
+    m_started = false;
+    m_maxExt = m_baseExt = 0;
+    m_expectedBefore = 0;
+    m_spanStartExt = 0;
+    m_spanStartNs = m_maxArrivalNs = 0;
+    m_window[0] = m_window[1] = 0;
+}
+
+void SeqTracker::update(int seq, qint64 arrivalNs)
+{
+    seq &= SeqModulo - 1;
+    m_stats.lastArrivalNs = arrivalNs;
+
+    if (!m_started) {
+        m_started = true;
+        restart(seq, arrivalNs);
+        return;
+    }
+
+    int delta = (seq - int(m_maxExt)) & (SeqModulo - 1);
+
+    // 间隔超过半个序号周期时, 无法由 seq 判断回绕了几次
+    if (m_stats.periodNs > 0 && double(arrivalNs - m_maxArrivalNs) >= m_stats.periodNs * (SeqModulo / 2)) {
+        m_expectedBefore += quint64(m_maxExt - m_baseExt + 1);
+        ++m_stats.resyncs;
+        restart(seq, arrivalNs);
+        return;
+    }
+
+    if (delta == 0) {
+        ++m_stats.duplicates;
+    } else if (delta < SeqModulo / 2) {
+        // 向前: 以平均间隔作为发送间隔计算到达偏差
+        if (m_stats.periodNs > 0) {
+            double d = double(arrivalNs - m_maxArrivalNs) - delta * m_stats.periodNs;
+            m_stats.jitterNs += (qAbs(d) - m_stats.jitterNs) * kJitterGain;
+        }
+        shiftWindow(delta);
+        setWindow(0);
+        m_maxExt += delta;
+        m_maxArrivalNs = arrivalNs;
+        ++m_stats.received;
+        m_stats.periodNs = double(arrivalNs - m_spanStartNs) / double(m_maxExt - m_spanStartExt);
+    } else {
+        // 迟到: 超出位图的无法区分重复, 只计乱序
+        int back = SeqModulo - delta;
+        ++m_stats.outOfOrder;
+        if (back < WindowBits) {
+            if (testWindow(back)) {
+                --m_stats.outOfOrder;
+                ++m_stats.duplicates;
+            } else {
+                setWindow(back);
+                ++m_stats.received;
+                m_baseExt = qMin(m_baseExt, m_maxExt - back);
+            }
+        }
+    }
+
+    m_stats.expected = m_expectedBefore + quint64(m_maxExt - m_baseExt + 1);
+}
+
+SeqStats SeqTracker::stats() const
+{
+    return m_stats;
+}
+
+void SeqTracker::restart(int seq, qint64 arrivalNs)
+{
+    m_maxExt = m_baseExt = m_spanStartExt = seq;
+    m_spanStartNs = m_maxArrivalNs = arrivalNs;
+    m_window[0] = 1;
+    m_window[1] = 0;
+    ++m_stats.received;
+    m_stats.expected = m_expectedBefore + 1;
+}
+
+void SeqTracker::shiftWindow(int steps)
+{
+    if (steps >= WindowBits) {
+        m_window[0] = m_window[1] = 0;
+    } else if (steps >= 64) {
+        m_window[1] = m_window[0] << (steps - 64);
+        m_window[0] = 0;
+    } else if (steps > 0) {
+        m_window[1] = (m_window[1] << steps) | (m_window[0] >> (64 - steps));
+        m_window[0] <<= steps;
+    }
+}
+
+bool SeqTracker::testWindow(int back) const
+{
+    return (m_window[back >> 6] >> (back & 63)) & 1;
+}
+
+void SeqTracker::setWindow(int back)
+{
+    m_window[back >> 6] |= quint64(1) << (back & 63);
+}
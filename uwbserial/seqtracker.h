@@ -0,0 +1,67 @@
+#ifndef SEQTRACKER_H
+#define SEQTRACKER_H
+
+#include <QtGlobal>
+
+// 单个标签的序号统计
+struct SeqStats {
+    int tid;
+    quint64 received;       // 收到的不同序号数
+    quint64 expected;       // 应收数量 (序号跨度, 不含重新同步前后之间的空白)
+    quint64 duplicates;     // 已收到过的序号再次到达 (多串口融合之外)
+    quint64 outOfOrder;     // 晚于更大序号到达的包
+    quint64 resyncs;        // 长时间无数据后无法判断回绕次数, 重新同步的次数
+    double periodNs;        // 平均发包间隔, 未知时为 0
+    double jitterNs;        // 到达间隔抖动 (RFC 3550 A.8 的平滑平均偏差)
+    qint64 lastArrivalNs;
+
+    quint64 lost() const { return expected > received ? expected - received : 0; }
+    double lossRate() const { return expected ? double(lost()) / double(expected) : 0.0; }
+};
+
+// ==========================================
+// SeqTracker: 按 8 位 seq 增量统计丢包/重复/乱序/抖动, 每个标签常数内存
+//
+// 序号扩展为单调递增的计数 (同 RFC 3550 A.1): 与已见最大序号之差 (mod 256)
+// 小于 128 视为向前 (中间的视为丢失), 大于 128 视为迟到的旧包;
+// 最近 128 个序号的位图用于区分迟到包与重复包。
+// 超过 128 个发包间隔没有数据时回绕次数不可知, 重新开始一段, 空白不计入丢包。
+// 标签不带发送时间, 抖动以平均发包间隔代替发送间隔计算
+// ==========================================
+class SeqTracker
+{
+public:
+    enum {
+        SeqModulo = 256,
+        WindowBits = 128
+    };
+
+    SeqTracker();
+
+    // seq 为 0~255, arrivalNs 为单调时钟
+    void update(int seq, qint64 arrivalNs);
+    // 在 update() 之前已被丢弃的重复包 (合并器判定的同一串口重发)
+    void addDuplicate() { ++m_stats.duplicates; }
+    void clear();
+
+    // 返回的 tid 为 0, 由调用方填写
+    SeqStats stats() const;
+
+private:
+    void restart(int seq, qint64 arrivalNs);
+    void shiftWindow(int steps);
+    bool testWindow(int back) const;
+    void setWindow(int back);
+
+    SeqStats m_stats;
+    bool m_started;
+    qint64 m_maxExt;            // 扩展后的最大序号, 低 8 位即 seq
+    qint64 m_baseExt;           // 本段的第一个序号
+    quint64 m_expectedBefore;   // 之前各段的应收数量
+    qint64 m_spanStartExt;      // 本段第一个到达的包, 用于估计平均间隔
+    qint64 m_spanStartNs;
+    qint64 m_maxArrivalNs;      // 最大序号的到达时间
+    quint64 m_window[2];        // 第 i 位: m_maxExt - i 已收到
+};
+
+#endif // SEQTRACKER_H
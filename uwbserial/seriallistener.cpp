@@ -0,0 +1,121 @@
+#include "seriallistener.h"
+#include <cstring>
+
+SerialListener::SerialListener(int index, const QElapsedTimer &clock, LatencyStats *latency, QObject *parent)
+    : QObject(parent), m_index(index), m_clock(clock), m_latency(latency), m_serial(nullptr)
+{
+}
+
+SerialListener::~SerialListener()
+{
+    if (m_serial && m_serial->isOpen())
+        m_serial->close();
+}
+
+void SerialListener::rearmNotification()
+{
+    m_notifyPending.storeRelease(0);
+}
+
+bool SerialListener::takeLine(Line &line)
+{
+    return m_lines.pop(line);
+}
+
+int SerialListener::takeDroppedCount()
+{
+    return m_dropped.fetchAndStoreRelaxed(0);
+}
+
+void SerialListener::open(const QString &portName, qint32 baudRate)
+{
+    // 串口对象必须在本线程中创建
+    if (!m_serial) {
+        m_serial = new QSerialPort(this);
+        connect(m_serial, &QSerialPort::readyRead, this, &SerialListener::onReadyRead);
+        connect(m_serial, &QSerialPort::errorOccurred, this, &SerialListener::onError);
+    }
+
+    if (m_serial->isOpen())
+        m_serial->close();
+
+    m_serial->setPortName(portName);
+    m_serial->setBaudRate(baudRate);
+
+    if (m_serial->open(QIODevice::ReadWrite)) {
+        m_serial->write("begin");
+        m_buffer.clear();
+        emit opened(m_index, portName);
+    } else {
+        emit openFailed(m_index, m_serial->errorString());
+    }
+}
+
+void SerialListener::close()
+{
+    if (m_serial && m_serial->isOpen())
+        m_serial->close();
+}
+
+void SerialListener::onReadyRead()
+{
+    qint64 now = m_clock.nsecsElapsed();
+    bool trace = m_latency && m_latency->isEnabled();
+    m_buffer.append(m_serial->readAll());
+
+    // 一次扫描切出所有完整行, 最后统一移除已处理部分
+    int start = 0;
+    int lineEnd;
+    bool pushed = false;
+    while ((lineEnd = m_buffer.indexOf('\n', start)) != -1) {
+        const char *data = m_buffer.constData() + start;
+        int len = lineEnd - start;
+        start = lineEnd + 1;
+        if (len == 0) continue;
+
+        Line line;
+        line.timeNs = now;
+
+        // 损坏或超长的行正是现场录制需要保留的, 不解析但照样交给引擎
+        if (len > MaxLineLength) {
+            m_dropped.fetchAndAddRelaxed(1);
+            line.parsed = false;
+            // 录制格式单行最长 65535 字节, 超出部分不保留
+            line.length = qMin(len, 0xffff);
+            line.oversized = QByteArray(data, line.length);
+            if (m_lines.push(line))
+                pushed = true;
+            continue;
+        }
+
+        line.length = len;
+        memcpy(line.data, data, size_t(len));
+        while (len > 0 && (data[len - 1] == '\r' || data[len - 1] == ' ')) --len;
+
+        qint64 framedNs = trace ? m_clock.nsecsElapsed() : 0;
+        line.parsed = len > 0 && parseRangeLine(data, len, line.packet);
+        if (trace) {
+            qint64 parsedNs = m_clock.nsecsElapsed();
+            m_latency->record(LatencyStats::StageFraming, framedNs - now);
+            m_latency->record(LatencyStats::StageParse, parsedNs - framedNs);
+        }
+
+        if (m_lines.push(line))
+            pushed = true;
+        else
+            m_dropped.fetchAndAddRelaxed(1);
+    }
+    m_buffer.remove(0, start);
+
+    // 只在引擎取空队列后才再次通知
+    if (pushed && m_notifyPending.testAndSetOrdered(0, 1))
+        emit linesReady(m_index);
+}
+
+void SerialListener::onError(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::ResourceError) {
+        m_serial->close();
+        emit lost(m_index);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SERIALLISTENER_H
+#define SERIALLISTENER_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include "rangeparser.h"
+#include "spscqueue.h"
+#include "latencystats.h"
+
+// ==========================================
+// SerialListener: 一个监听节点的串口
+// 每个串口运行在独立线程: 读取、分行、解析都在本线程完成,
+// 结果经无锁队列交给 PositionEngine 合并, 多个串口的解析可分摊到多个核心
+// ==========================================
+class SerialListener : public QObject
+{
+    Q_OBJECT
+public:
+    enum {
+        MaxLineLength = 256,    // 超长行不解析 (计入 droppedCount), 原始内容仍交给引擎录制
+        QueueCapacity = 4096
+    };
+
+    struct Line {
+        qint64 timeNs;          // 与引擎同一时基的到达时间
+        bool parsed;            // packet 有效
+        RangePacket packet;
+        int length;             // 原始行 (未去除行尾空白), 供录制
+        char data[MaxLineLength];
+        QByteArray oversized;   // 超过 MaxLineLength 的原始行 (此时 data 不用), 只供录制
+    };
+
+    // clock: 引擎的单调时钟, 复制后各线程读取到的时间可直接比较
+    // latency: 统计开启时记录分行与解析耗时, 可为空
+    SerialListener(int index, const QElapsedTimer &clock, LatencyStats *latency = nullptr, QObject *parent = nullptr);
+    ~SerialListener();
+
+    int index() const { return m_index; }
+
+    // 引擎线程调用: 先重新允许通知, 再取出所有行
+    void rearmNotification();
+    bool takeLine(Line &line);
+    // 队列满或行过长而丢弃的行数 (读取后清零)
+    int takeDroppedCount();
+
+public slots:
+    void open(const QString &portName, qint32 baudRate);
+    void close();
+
+signals:
+    void opened(int index, const QString &portName);
+    void openFailed(int index, const QString &error);
+    void lost(int index);
+    void linesReady(int index);
+
+private slots:
+    void onReadyRead();
+    void onError(QSerialPort::SerialPortError error);
+
+private:
+    int m_index;
+    QElapsedTimer m_clock;
+    LatencyStats *m_latency;
+    QSerialPort *m_serial;
+    QByteArray m_buffer;
+
+    SpscQueue<Line, QueueCapacity> m_lines;
+    QAtomicInt m_notifyPending;
+    QAtomicInt m_dropped;
+};
+
+#endif // SERIALLISTENER_H
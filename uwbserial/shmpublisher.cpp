@@ -0,0 +1,134 @@
+#include "shmpublisher.h"
+#include <new>
+#include <cerrno>
+
+ShmPublisher::ShmPublisher()
+    : m_base(nullptr), m_header(nullptr), m_slots(nullptr), m_events(nullptr), m_eventHead(0), m_droppedTags(0)
+{
+}
+
+ShmPublisher::~ShmPublisher()
+{
+    close();
+}
+
+bool ShmPublisher::open(const QString &name)
+{
+    close();
+    m_name = name;
+
+#ifdef _WIN32
+    m_error = "shared memory feed is not supported on this platform";
+    return false;
+#else
+    QByteArray path = name.toLocal8Bit();
+
+    // 总是重新创建: 仍映射着旧对象的读端会看到 closed 并重新打开
+    shm_unlink(path.constData());
+    int fd = shm_open(path.constData(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        m_error = QString("shm_open %1: %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    if (ftruncate(fd, off_t(UwbShm::TotalSize)) != 0) {
+        m_error = QString("ftruncate %1: %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        ::close(fd);
+        shm_unlink(path.constData());
+        return false;
+    }
+    void *base = mmap(nullptr, size_t(UwbShm::TotalSize), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        m_error = QString("mmap %1: %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        shm_unlink(path.constData());
+        return false;
+    }
+
+    // 新对象已由 ftruncate 清零, 原地构造原子成员后再写布局
+    char *bytes = static_cast<char *>(base);
+    m_header = new (bytes) UwbShm::Header;
+    m_slots = reinterpret_cast<UwbShm::Slot *>(bytes + UwbShm::SlotOffset);
+    m_events = reinterpret_cast<UwbShm::Position *>(bytes + UwbShm::EventOffset);
+    for (int i = 0; i < UwbShm::SlotCount; ++i) {
+        new (&m_slots[i]) UwbShm::Slot;
+        m_slots[i].version.store(0, std::memory_order_relaxed);
+        m_slots[i].key.store(0, std::memory_order_relaxed);
+    }
+
+    memcpy(m_header->magic, UwbShm::Magic, sizeof(UwbShm::Magic));
+    m_header->version = UwbShm::Version;
+    m_header->headerSize = quint32(UwbShm::HeaderSize);
+    m_header->slotCount = UwbShm::SlotCount;
+    m_header->slotSize = sizeof(UwbShm::Slot);
+    m_header->eventCapacity = UwbShm::EventCapacity;
+    m_header->eventSize = sizeof(UwbShm::Position);
+    m_header->slotOffset = UwbShm::SlotOffset;
+    m_header->eventOffset = UwbShm::EventOffset;
+    m_header->totalSize = UwbShm::TotalSize;
+    m_header->closed.store(0, std::memory_order_relaxed);
+    m_header->eventHead.store(0, std::memory_order_relaxed);
+    m_header->tagCount.store(0, std::memory_order_relaxed);
+    m_header->ready.store(1, std::memory_order_release);
+
+    m_base = base;
+    m_eventHead = 0;
+    m_droppedTags = 0;
+    m_error.clear();
+    return true;
+#endif
+}
+
+void ShmPublisher::close()
+{
+    if (!m_base) return;
+
+#ifndef _WIN32
+    m_header->closed.store(1, std::memory_order_release);
+    munmap(m_base, size_t(UwbShm::TotalSize));
+    shm_unlink(m_name.toLocal8Bit().constData());
+#endif
+    m_base = nullptr;
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_events = nullptr;
+}
+
+UwbShm::Slot *ShmPublisher::findSlot(quint32 tid)
+{
+    quint32 key = tid + 1;
+    quint32 index = UwbShm::slotHash(tid);
+    for (int probe = 0; probe < UwbShm::SlotCount; ++probe, index = (index + 1) & (UwbShm::SlotCount - 1)) {
+        quint32 k = m_slots[index].key.load(std::memory_order_relaxed);
+        if (k == key || k == 0) return &m_slots[index];
+    }
+    return nullptr;
+}
+
+void ShmPublisher::publish(const UwbShm::Position &position)
+{
+    if (!m_header) return;
+
+    UwbShm::Slot *slot = findSlot(position.tid);
+    if (slot) {
+        // seqlock: 版本号为奇数期间读端会重试
+        quint32 version = slot->version.load(std::memory_order_relaxed);
+        slot->version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot->position, &position, sizeof(position));
+        slot->version.store(version + 2, std::memory_order_release);
+
+        // 新标签: 数据写好后才让读端看到这个槽
+        if (slot->key.load(std::memory_order_relaxed) == 0) {
+            slot->key.store(position.tid + 1, std::memory_order_release);
+            m_header->tagCount.fetch_add(1, std::memory_order_release);
+        }
+    } else {
+        ++m_droppedTags;
+    }
+
+    // 这一格上次的事件 (eventHead - EventCapacity) 可能正被读端复制:
+    // 上一次对 eventHead 的写入必须先于覆盖可见, 读端复制后重读 eventHead 才能发现被覆盖
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&m_events[m_eventHead & (UwbShm::EventCapacity - 1)], &position, sizeof(position));
+    m_header->eventHead.store(++m_eventHead, std::memory_order_release);
+}
@@ -0,0 +1,42 @@
+#ifndef SHMPUBLISHER_H
+#define SHMPUBLISHER_H
+
+#include <QString>
+#include "uwbshm.h"
+
+// ==========================================
+// ShmPublisher: 共享内存定位环的写端 (布局见 uwbshm/uwbshm.h)
+// 由引擎线程直接调用: 每条结果只是几次内存写入, 不做系统调用;
+// 其他进程用 UwbShm::Reader 无锁轮询。非 POSIX 平台上 open() 失败
+// ==========================================
+class ShmPublisher
+{
+public:
+    ShmPublisher();
+    ~ShmPublisher();
+
+    bool open(const QString &name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    QString name() const { return m_name; }
+    QString errorString() const { return m_error; }
+
+    // 更新标签槽并追加一条事件
+    void publish(const UwbShm::Position &position);
+    // 槽已占满而无法记录的新标签数
+    qint64 droppedTags() const { return m_droppedTags; }
+
+private:
+    UwbShm::Slot *findSlot(quint32 tid);
+
+    QString m_name;
+    QString m_error;
+    void *m_base;
+    UwbShm::Header *m_header;
+    UwbShm::Slot *m_slots;
+    UwbShm::Position *m_events;
+    quint64 m_eventHead;        // 只有本写端修改, 不必每次从共享内存读取
+    qint64 m_droppedTags;
+};
+
+#endif // SHMPUBLISHER_H
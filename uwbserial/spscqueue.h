@@ -0,0 +1,58 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// ==========================================
+// SpscQueue: 单生产者/单消费者无锁环形队列
+// 生产者与消费者各自只写自己的游标, 满时 push 返回 false, 不阻塞
+// ==========================================
+template <typename T, int Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    // 生产者线程调用
+    bool push(const T &value)
+    {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == quint32(Capacity))
+            return false;
+
+        m_items[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者线程调用
+    bool pop(T &value)
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        value = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    int size() const
+    {
+        return int(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+    }
+
+    static int capacity() { return Capacity; }
+
+private:
+    // 两个游标分处不同缓存行, 避免伪共享
+    std::atomic<quint32> m_head;
+    char m_pad0[64 - sizeof(std::atomic<quint32>)];
+    std::atomic<quint32> m_tail;
+    char m_pad1[64 - sizeof(std::atomic<quint32>)];
+    T m_items[Capacity];
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,225 @@
+#include "streammerger.h"
+#include <limits>
+
+namespace {
+// 超过该时长的 (tid, seq) 视为新包; seq 只有 8 位, 10Hz 时约 25 秒回绕一次
+const qint64 kDuplicateHorizonNs = 1000000000LL;
+// 已知发包间隔时时限取半个序号周期, 远小于回绕时间 (256 个周期)
+const qint64 kHorizonPeriods = 128;
+
+inline quint64 packetKey(const RangePacket &packet)
+{
+    return (quint64(quint32(packet.tid)) << 32) | quint32(packet.seq);
+}
+}
+
+StreamMerger::StreamMerger(qint64 windowNs)
+    : m_windowNs(qMax<qint64>(0, windowNs)), m_keys(1 << KeyTableBits), m_tags(1 << TagTableBits),
+      m_nextOrder(0), m_fused(0), m_late(0)
+{
+    clear();
+}
+
+void StreamMerger::setWindow(qint64 windowNs)
+{
+    m_windowNs = qMax<qint64>(0, windowNs);
+}
+
+void StreamMerger::clear()
+{
+    m_pool.clear();
+    m_free.clear();
+    m_heap.clear();
+    for (int i = 0; i < m_keys.size(); ++i) {
+        m_keys[i].key = 0;
+        m_keys[i].timeNs = std::numeric_limits<qint64>::min() / 2;
+        m_keys[i].pending = -1;
+        m_keys[i].sources = 0;
+    }
+    for (int i = 0; i < m_tags.size(); ++i) {
+        m_tags[i].tid = -1;
+        m_tags[i].periodNs = 0;
+    }
+}
+
+qint64 StreamMerger::duplicateHorizon(const RangePacket &packet, qint64 timeNs)
+{
+    TagSlot &tag = m_tags[int((quint32(packet.tid) * 0x9e3779b9u) >> (32 - TagTableBits))];
+    if (tag.tid != packet.tid) {
+        tag.tid = packet.tid;
+        tag.lastSeq = packet.seq;
+        tag.lastTimeNs = timeNs;
+        tag.periodNs = 0;
+        return kDuplicateHorizonNs;
+    }
+
+    qint64 horizon = tag.periodNs > 0 ? qMin(kDuplicateHorizonNs, tag.periodNs * kHorizonPeriods) : kDuplicateHorizonNs;
+
+    // 只用向前推进的序号估计间隔, 重复包与迟到包不参与
+    int steps = (packet.seq - tag.lastSeq) & 0xff;
+    qint64 elapsed = timeNs - tag.lastTimeNs;
+    if (steps > 0 && steps < 128 && elapsed > 0) {
+        qint64 sample = elapsed / steps;
+        tag.periodNs = tag.periodNs > 0 ? tag.periodNs + (sample - tag.periodNs) / 8 : sample;
+        tag.lastSeq = packet.seq;
+        tag.lastTimeNs = timeNs;
+    } else if (steps >= 128 && elapsed > tag.periodNs * kHorizonPeriods) {
+        // 长时间无数据, 无法判断回绕次数, 重新开始
+        tag.lastSeq = packet.seq;
+        tag.lastTimeNs = timeNs;
+    }
+    return horizon;
+}
+
+StreamMerger::PushResult StreamMerger::push(const RangePacket &packet, qint64 timeNs, int source)
+{
+    // 不带 seq 的报文无法判断重复
+    bool hasSeq = packet.seq >= 0;
+    qint64 horizon = hasSeq ? duplicateHorizon(packet, timeNs) : 0;
+
+    quint64 key = packetKey(packet);
+    KeySlot &slot = m_keys[int((key * Q_UINT64_C(0x9e3779b97f4a7c15)) >> (64 - KeyTableBits))];
+    bool seen = hasSeq && slot.key == key && timeNs - slot.timeNs < horizon;
+    quint32 bit = 1u << (source & 31);
+
+    if (seen && (slot.sources & bit))
+        return Repeated;
+    if (seen && slot.pending >= 0) {
+        Entry &pending = m_pool[slot.pending];
+        fuse(pending, packet);
+        pending.item.sources |= bit;
+        slot.sources |= bit;
+        ++m_fused;
+        return Fused;
+    }
+    if (seen) {
+        slot.sources |= bit;
+        ++m_late;
+        return Late;
+    }
+
+    int idx;
+    if (!m_free.isEmpty()) {
+        idx = m_free.last();
+        m_free.removeLast();
+    } else {
+        idx = m_pool.size();
+        m_pool.resize(idx + 1);
+    }
+
+    Entry &entry = m_pool[idx];
+    entry.item.packet = packet;
+    entry.item.timestampNs = timeNs;
+    entry.item.sources = bit;
+    entry.order = m_nextOrder++;
+    entry.fused = false;
+
+    slot.key = key;
+    slot.timeNs = timeNs;
+    slot.pending = idx;
+    slot.sources = bit;
+
+    m_heap.append(idx);
+    siftUp(m_heap.size() - 1);
+    return Queued;
+}
+
+int StreamMerger::release(qint64 nowNs, QVector<TimedPacket> &out)
+{
+    int released = 0;
+    for (; !m_heap.isEmpty() && m_pool[m_heap.first()].item.timestampNs <= nowNs - m_windowNs; ++released)
+        popFront(out);
+    return released;
+}
+
+int StreamMerger::releaseAll(QVector<TimedPacket> &out)
+{
+    int released = 0;
+    for (; !m_heap.isEmpty(); ++released)
+        popFront(out);
+    return released;
+}
+
+void StreamMerger::popFront(QVector<TimedPacket> &out)
+{
+    int idx = m_heap.first();
+    m_heap.first() = m_heap.last();
+    m_heap.removeLast();
+    if (!m_heap.isEmpty()) siftDown(0);
+
+    Entry &entry = m_pool[idx];
+    const TimedPacket &item = entry.item;
+    if (entry.fused) {
+        RangePacket &packet = entry.item.packet;
+        for (int j = 0; j < packet.count; ++j)
+            packet.range[j] = (entry.rangeSum[j] + entry.rangeCount[j] / 2) / entry.rangeCount[j];
+    }
+    out.append(item);
+
+    // 之后到达的重复包按迟到处理
+    quint64 key = packetKey(item.packet);
+    KeySlot &slot = m_keys[int((key * Q_UINT64_C(0x9e3779b97f4a7c15)) >> (64 - KeyTableBits))];
+    if (slot.pending == idx) slot.pending = -1;
+
+    m_free.append(idx);
+}
+
+bool StreamMerger::earlier(int a, int b) const
+{
+    const Entry &ea = m_pool[a];
+    const Entry &eb = m_pool[b];
+    if (ea.item.timestampNs != eb.item.timestampNs) return ea.item.timestampNs < eb.item.timestampNs;
+    return ea.order < eb.order;
+}
+
+void StreamMerger::siftUp(int pos)
+{
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!earlier(m_heap[pos], m_heap[parent])) break;
+        qSwap(m_heap[pos], m_heap[parent]);
+        pos = parent;
+    }
+}
+
+void StreamMerger::siftDown(int pos)
+{
+    int n = m_heap.size();
+    for (;;) {
+        int left = 2 * pos + 1;
+        if (left >= n) break;
+        int child = left + 1 < n && earlier(m_heap[left + 1], m_heap[left]) ? left + 1 : left;
+        if (!earlier(m_heap[child], m_heap[pos])) break;
+        qSwap(m_heap[pos], m_heap[child]);
+        pos = child;
+    }
+}
+
+void StreamMerger::fuse(Entry &into, const RangePacket &from)
+{
+    RangePacket &packet = into.item.packet;
+    if (!into.fused) {
+        into.fused = true;
+        for (int j = 0; j < packet.count; ++j) {
+            into.rangeSum[j] = packet.range[j];
+            into.rangeCount[j] = 1;
+        }
+    }
+
+    for (int i = 0; i < from.count; ++i) {
+        int j = 0;
+        while (j < packet.count && packet.ancid[j] != from.ancid[i]) ++j;
+
+        if (j < packet.count) {
+            into.rangeSum[j] += from.range[i];
+            ++into.rangeCount[j];
+        } else if (packet.count < RangePacket::MaxSlots) {
+            packet.ancid[packet.count] = from.ancid[i];
+            packet.range[packet.count] = from.range[i];
+            into.rangeSum[packet.count] = from.range[i];
+            into.rangeCount[packet.count] = 1;
+            ++packet.count;
+        }
+    }
+    packet.mask |= from.mask;
+}
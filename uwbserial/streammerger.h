@@ -0,0 +1,107 @@
+#ifndef STREAMMERGER_H
+#define STREAMMERGER_H
+
+#include <QVector>
+#include "rangeparser.h"
+
+// 已解析的一包及其到达时间
+struct TimedPacket {
+    RangePacket packet;
+    qint64 timestampNs;     // 最先收到的时间 (单调时钟 ns)
+    quint32 sources;        // 收到该包的串口位掩码
+};
+
+// ==========================================
+// StreamMerger: 多个串口的报文按时间合并, 并对重复的 (tid, seq) 去重/融合
+//
+// 多个监听节点会听到同一标签的同一包。每包先在重排窗口内停留 window 时长,
+// 窗口内再到达的相同 (tid, seq) 融合进先到的包: 基站取并集, 同一基站测距取各份的平均;
+// 窗口结束后才到达的重复包直接丢弃。窗口为 0 时 (单串口) 到达即发出。
+// 同一串口再次收到的 (tid, seq) 不是多串口副本, 而是标签重发或链路重复,
+// 不参与融合, 由 push() 的返回值告诉调用方计入序号统计。
+// seq 只有 8 位, 判定重复的时限按各标签实测的发包间隔取 128 个周期 (最长 1 秒),
+// 高频标签回绕后的新包不会被误当作重复包; 不带 seq 的报文不去重。
+//
+// 去重表为定长直接映射表, 不做堆分配; 冲突时覆盖, 只会漏判少量重复包
+// ==========================================
+class StreamMerger
+{
+public:
+    enum {
+        DefaultWindowMs = 20,
+        KeyTableBits = 13,
+        TagTableBits = 10
+    };
+
+    // push() 的处理结果
+    enum PushResult {
+        Queued,             // 新包, 进入重排窗口
+        Fused,              // 其他串口的同一包, 在窗口内融合
+        Late,               // 其他串口的同一包, 窗口之后到达而丢弃
+        Repeated            // 同一串口再次收到同一包, 丢弃
+    };
+
+    explicit StreamMerger(qint64 windowNs = DefaultWindowMs * 1000000LL);
+
+    void setWindow(qint64 windowNs);
+    qint64 window() const { return m_windowNs; }
+    void clear();
+    bool isEmpty() const { return m_heap.isEmpty(); }
+
+    // source 为串口编号 (0~31)
+    PushResult push(const RangePacket &packet, qint64 timeNs, int source);
+    // 取出到达时间 <= nowNs - window 的包, 按时间升序追加到 out, 返回追加数量
+    int release(qint64 nowNs, QVector<TimedPacket> &out);
+    // 不论窗口, 取出全部待发包
+    int releaseAll(QVector<TimedPacket> &out);
+
+    qint64 fusedCount() const { return m_fused; }       // 窗口内融合的重复包
+    qint64 lateCount() const { return m_late; }         // 窗口之后到达而丢弃的重复包
+    void resetCounters() { m_fused = m_late = 0; }
+
+private:
+    struct Entry {
+        TimedPacket item;
+        quint64 order;      // 同一时间按到达顺序
+        bool fused;
+        // 融合时各槽位的测距累加与份数, 发出时才求平均, 与到达顺序无关
+        int rangeSum[RangePacket::MaxSlots];
+        int rangeCount[RangePacket::MaxSlots];
+    };
+
+    // 最近见过的 (tid, seq)
+    struct KeySlot {
+        quint64 key;
+        qint64 timeNs;
+        int pending;        // 仍在窗口内时为 m_pool 下标, 否则 -1
+        quint32 sources;    // 收到过该包的串口, 发出后仍保留, 用于区分迟到副本与重发
+    };
+
+    // 各标签最近的序号与平均发包间隔, 用于确定重复判定的时限
+    struct TagSlot {
+        int tid;            // -1 表示空项
+        int lastSeq;
+        qint64 lastTimeNs;
+        qint64 periodNs;    // 0 表示未知
+    };
+
+    // 更新 tid 的发包间隔估计, 返回该标签的重复判定时限
+    qint64 duplicateHorizon(const RangePacket &packet, qint64 timeNs);
+    bool earlier(int a, int b) const;
+    void siftUp(int pos);
+    void siftDown(int pos);
+    void popFront(QVector<TimedPacket> &out);
+    static void fuse(Entry &into, const RangePacket &from);
+
+    qint64 m_windowNs;
+    QVector<Entry> m_pool;
+    QVector<int> m_free;
+    QVector<int> m_heap;            // m_pool 下标, 按 (timestampNs, order) 的最小堆
+    QVector<KeySlot> m_keys;
+    QVector<TagSlot> m_tags;
+    quint64 m_nextOrder;
+    qint64 m_fused;
+    qint64 m_late;
+};
+
+#endif // STREAMMERGER_H
@@ -0,0 +1,95 @@
+#include "tagfilter.h"
+
+QPoint smoothPosition(const QPoint &last, const QPoint &raw, double threshold, double alpha)
+{
+    QPoint finalPos;
+    finalPos.setX(last.x() * (1-alpha) + raw.x() * alpha);
+    finalPos.setY(last.y() * (1-alpha) + raw.y() * alpha);
+
+    if ((finalPos - last).manhattanLength() < threshold) {
+        finalPos = last;
+    }
+    return finalPos;
+}
+
+// ==========================================
+// TagKalmanFilter 实现
+// ==========================================
+
+namespace {
+// 两包间隔超过该值时认为轨迹中断, 重新初始化 (s)
+const double kMaxGapSeconds = 5.0;
+// 初始速度不确定度 (cm/s)
+const double kInitialVelocityStd = 200.0;
+}
+
+TagKalmanFilter::TagKalmanFilter()
+    : m_timeNs(0), m_initialized(false)
+{
+    m_x = m_y = Axis{0, 0, 0, 0, 0};
+}
+
+void TagKalmanFilter::initAxis(Axis &a, double z, double r2)
+{
+    a.p = z;
+    a.v = 0;
+    a.p00 = r2;
+    a.p01 = 0;
+    a.p11 = kInitialVelocityStd * kInitialVelocityStd;
+}
+
+void TagKalmanFilter::predictAxis(Axis &a, double dt, double q)
+{
+    // F = [1 dt; 0 1], Q = q * [dt^3/3 dt^2/2; dt^2/2 dt]
+    double dt2 = dt * dt;
+    a.p += a.v * dt;
+    a.p00 += dt * (2.0 * a.p01 + dt * a.p11) + q * dt2 * dt / 3.0;
+    a.p01 += dt * a.p11 + q * dt2 / 2.0;
+    a.p11 += q * dt;
+}
+
+void TagKalmanFilter::updateAxis(Axis &a, double z, double r2)
+{
+    // H = [1 0]
+    double s = a.p00 + r2;
+    double k0 = a.p00 / s;
+    double k1 = a.p01 / s;
+    double innovation = z - a.p;
+
+    a.p += k0 * innovation;
+    a.v += k1 * innovation;
+    a.p11 -= k1 * a.p01;
+    a.p00 *= (1.0 - k0);
+    a.p01 *= (1.0 - k0);
+}
+
+void TagKalmanFilter::update(double mx, double my, qint64 timeNs, double processNoise, double measurementNoise)
+{
+    double r2 = measurementNoise * measurementNoise;
+    double dt = (timeNs - m_timeNs) / 1e9;
+
+    if (!m_initialized || dt > kMaxGapSeconds || dt < 0) {
+        initAxis(m_x, mx, r2);
+        initAxis(m_y, my, r2);
+        m_timeNs = timeNs;
+        m_initialized = true;
+        return;
+    }
+
+    double q = processNoise * processNoise;
+    if (dt > 0) {
+        predictAxis(m_x, dt, q);
+        predictAxis(m_y, dt, q);
+    }
+    updateAxis(m_x, mx, r2);
+    updateAxis(m_y, my, r2);
+    m_timeNs = timeNs;
+}
+
+void TagKalmanFilter::extrapolate(qint64 timeNs, double &x, double &y) const
+{
+    double dt = (timeNs - m_timeNs) / 1e9;
+    if (dt < 0) dt = 0;
+    x = m_x.p + m_x.v * dt;
+    y = m_y.p + m_y.v * dt;
+}
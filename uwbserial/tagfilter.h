@@ -0,0 +1,51 @@
+#ifndef TAGFILTER_H
+#define TAGFILTER_H
+
+#include <QPoint>
+
+// EMA 平滑 + 抖动阈值: 平滑后与上一次输出的曼哈顿距离小于 threshold 时保持不动
+QPoint smoothPosition(const QPoint &last, const QPoint &raw, double threshold, double alpha = 0.2);
+
+// ==========================================
+// TagKalmanFilter: 单个标签的匀速模型卡尔曼滤波, 状态 (x, y, vx, vy)
+// x/y 两轴噪声独立, 分别按二维状态 (位置, 速度) 计算, 结果与 4 维形式相同
+// 时间由报文时间戳驱动, 单位: cm, cm/s, ns
+// ==========================================
+class TagKalmanFilter
+{
+public:
+    TagKalmanFilter();
+
+    bool isInitialized() const { return m_initialized; }
+    void reset() { m_initialized = false; }
+
+    // 预测到 timeNs 后用测量 (mx, my) 更新。
+    // processNoise: 加速度噪声标准差 (cm/s^2); measurementNoise: 测量噪声标准差 (cm)
+    void update(double mx, double my, qint64 timeNs, double processNoise, double measurementNoise);
+
+    // 不改变状态, 按当前速度外推到 timeNs 的位置
+    void extrapolate(qint64 timeNs, double &x, double &y) const;
+
+    double x() const { return m_x.p; }
+    double y() const { return m_y.p; }
+    double vx() const { return m_x.v; }
+    double vy() const { return m_y.v; }
+    qint64 timeNs() const { return m_timeNs; }
+
+private:
+    struct Axis {
+        double p, v;            // 位置, 速度
+        double p00, p01, p11;   // 协方差
+    };
+
+    static void initAxis(Axis &a, double z, double r2);
+    static void predictAxis(Axis &a, double dt, double q);
+    static void updateAxis(Axis &a, double z, double r2);
+
+    Axis m_x;
+    Axis m_y;
+    qint64 m_timeNs;
+    bool m_initialized;
+};
+
+#endif // TAGFILTER_H
@@ -0,0 +1,153 @@
+#include "taggrid.h"
+#include <limits>
+
+TagGrid::TagGrid(double cellSize)
+    : m_cellSize(qMax(1.0, cellSize)), m_invCellSize(1.0 / qMax(1.0, cellSize)), m_boundsDirty(false)
+{
+}
+
+void TagGrid::clear()
+{
+    m_cells.clear();
+    m_entries.clear();
+    m_bounds = QRectF();
+    m_boundsDirty = false;
+}
+
+void TagGrid::update(int id, const QPointF &pos)
+{
+    quint64 cell = cellKey(cellCoord(pos.x()), cellCoord(pos.y()));
+    m_boundsDirty = true;
+
+    auto entry = m_entries.find(id);
+    if (entry != m_entries.end()) {
+        if (entry->cell == cell) {
+            m_cells[cell][entry->index].pos = pos;
+            return;
+        }
+        removeFromCell(entry->cell, entry->index);
+    } else {
+        entry = m_entries.insert(id, Entry());
+    }
+
+    QVector<Item> &items = m_cells[cell];
+    entry->cell = cell;
+    entry->index = items.size();
+    Item item;
+    item.id = id;
+    item.pos = pos;
+    items.append(item);
+}
+
+void TagGrid::remove(int id)
+{
+    auto entry = m_entries.find(id);
+    if (entry == m_entries.end()) return;
+
+    removeFromCell(entry->cell, entry->index);
+    m_entries.erase(entry);
+    m_boundsDirty = true;
+}
+
+void TagGrid::removeFromCell(quint64 cell, int index)
+{
+    auto it = m_cells.find(cell);
+    QVector<Item> &items = it.value();
+
+    // 用最后一项填补空位, 并修正其下标
+    int last = items.size() - 1;
+    if (index != last) {
+        items[index] = items[last];
+        m_entries[items[index].id].index = index;
+    }
+    items.removeLast();
+    if (items.isEmpty())
+        m_cells.erase(it);
+}
+
+void TagGrid::query(const QRectF &rect, QVector<int> &ids) const
+{
+    forEachIn(rect, [&](int id, const QPointF &) { ids.append(id); });
+}
+
+int TagGrid::nearest(const QPointF &pos, double maxDistance) const
+{
+    if (m_cells.isEmpty() || maxDistance < 0) return -1;
+
+    int cx = cellCoord(pos.x()), cy = cellCoord(pos.y());
+    int maxRing = qMin(qCeil(maxDistance * m_invCellSize) + 1, 1 << 16);
+    int best = -1;
+    double bestDist2 = maxDistance * maxDistance;
+
+    auto visit = [&](int x, int y) {
+        auto it = m_cells.constFind(cellKey(x, y));
+        if (it == m_cells.constEnd()) return;
+        for (const Item &item : it.value()) {
+            double dx = item.pos.x() - pos.x(), dy = item.pos.y() - pos.y();
+            double d2 = dx * dx + dy * dy;
+            if (d2 <= bestDist2) {
+                bestDist2 = d2;
+                best = item.id;
+            }
+        }
+    };
+
+    // 由内向外逐圈搜索; 第 r 圈之外的标签距离至少 r 个网格宽
+    for (int r = 0; r <= maxRing; ++r) {
+        if (r > 0 && best >= 0) {
+            double reach = (r - 1) * m_cellSize;
+            if (bestDist2 <= reach * reach) break;
+        }
+        if (r == 0) {
+            visit(cx, cy);
+            continue;
+        }
+        for (int x = cx - r; x <= cx + r; ++x) {
+            visit(x, cy - r);
+            visit(x, cy + r);
+        }
+        for (int y = cy - r + 1; y <= cy + r - 1; ++y) {
+            visit(cx - r, y);
+            visit(cx + r, y);
+        }
+    }
+    return best;
+}
+
+QRectF TagGrid::bounds() const
+{
+    if (!m_boundsDirty) return m_bounds;
+    m_boundsDirty = false;
+
+    if (m_cells.isEmpty()) {
+        m_bounds = QRectF();
+        return m_bounds;
+    }
+
+    // 先找出最外围的网格, 再只在这些网格中求精确边界
+    int minCx = std::numeric_limits<int>::max(), maxCx = std::numeric_limits<int>::min();
+    int minCy = minCx, maxCy = maxCx;
+    for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+        int cx = cellX(it.key()), cy = cellY(it.key());
+        minCx = qMin(minCx, cx);
+        maxCx = qMax(maxCx, cx);
+        minCy = qMin(minCy, cy);
+        maxCy = qMax(maxCy, cy);
+    }
+
+    double minX = std::numeric_limits<double>::max(), maxX = -minX;
+    double minY = minX, maxY = -minX;
+    for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+        int cx = cellX(it.key()), cy = cellY(it.key());
+        if (cx != minCx && cx != maxCx && cy != minCy && cy != maxCy) continue;
+        for (const Item &item : it.value()) {
+            minX = qMin(minX, item.pos.x());
+            maxX = qMax(maxX, item.pos.x());
+            minY = qMin(minY, item.pos.y());
+            maxY = qMax(maxY, item.pos.y());
+        }
+    }
+
+    m_bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    return m_bounds;
+}
@@ -0,0 +1,101 @@
+#ifndef TAGGRID_H
+#define TAGGRID_H
+
+#include <QHash>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <QtMath>
+
+// ==========================================
+// TagGrid: 标签位置的均匀网格索引 (世界坐标, cm)
+// 位置变化时增量更新 (同一网格内原地修改, 跨网格时 O(1) 移除 + 追加);
+// 区域查询、最近标签拾取的开销只与所涉及网格中的标签数有关, 与标签总数无关
+// ==========================================
+class TagGrid
+{
+public:
+    enum { DefaultCellSize = 200 };     // cm
+
+    explicit TagGrid(double cellSize = DefaultCellSize);
+
+    void clear();
+    int size() const { return m_entries.size(); }
+    bool contains(int id) const { return m_entries.contains(id); }
+
+    // 插入或移动
+    void update(int id, const QPointF &pos);
+    void remove(int id);
+
+    // 对落在 rect 内的每个标签调用 f(int id, const QPointF &pos)
+    template <typename F>
+    void forEachIn(const QRectF &rect, F f) const;
+    // 落在 rect 内的标签, 追加到 ids
+    void query(const QRectF &rect, QVector<int> &ids) const;
+    // 距 pos 最近且不超过 maxDistance 的标签, 没有时返回 -1
+    int nearest(const QPointF &pos, double maxDistance) const;
+    // 所有标签的外接矩形, 没有标签时返回空矩形
+    QRectF bounds() const;
+
+private:
+    struct Item {
+        int id;
+        QPointF pos;
+    };
+
+    struct Entry {
+        quint64 cell;
+        int index;          // 在所在网格 items 中的下标
+    };
+
+    int cellCoord(double v) const { return qFloor(v * m_invCellSize); }
+    static quint64 cellKey(int cx, int cy) { return (quint64(quint32(cx)) << 32) | quint32(cy); }
+    static int cellX(quint64 key) { return int(quint32(key >> 32)); }
+    static int cellY(quint64 key) { return int(quint32(key)); }
+    void removeFromCell(quint64 cell, int index);
+
+    double m_cellSize;
+    double m_invCellSize;
+    QHash<quint64, QVector<Item>> m_cells;
+    QHash<int, Entry> m_entries;
+
+    mutable QRectF m_bounds;
+    mutable bool m_boundsDirty;
+};
+
+template <typename F>
+void TagGrid::forEachIn(const QRectF &rect, F f) const
+{
+    if (m_cells.isEmpty() || rect.isEmpty()) return;
+
+    int cx0 = cellCoord(rect.left()), cx1 = cellCoord(rect.right());
+    int cy0 = cellCoord(rect.top()), cy1 = cellCoord(rect.bottom());
+
+    auto visit = [&](const QVector<Item> &items) {
+        for (const Item &item : items) {
+            if (rect.contains(item.pos))
+                f(item.id, item.pos);
+        }
+    };
+
+    // 区域覆盖的网格比已占用的网格还多时 (视图缩得很小), 直接遍历已占用网格
+    qint64 spanned = qint64(cx1 - cx0 + 1) * qint64(cy1 - cy0 + 1);
+    if (spanned > m_cells.size()) {
+        for (auto it = m_cells.constBegin(); it != m_cells.constEnd(); ++it) {
+            int cx = cellX(it.key()), cy = cellY(it.key());
+            if (cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1)
+                visit(it.value());
+        }
+        return;
+    }
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            auto it = m_cells.constFind(cellKey(cx, cy));
+            if (it != m_cells.constEnd())
+                visit(it.value());
+        }
+    }
+}
+
+#endif // TAGGRID_H
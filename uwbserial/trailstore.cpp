@@ -0,0 +1,109 @@
+#include "trailstore.h"
+
+int TrailStore::Trail::lowerBound(qint64 ms) const
+{
+    int lo = 0, hi = m_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (at(mid).ms < ms)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void TrailStore::Trail::append(const Point &point, int maxCapacity)
+{
+    if (m_count == m_points.size() && m_points.size() < maxCapacity)
+        reallocate(qMin(qMax(int(MinCapacity), m_points.size() * 2), maxCapacity));
+
+    m_points[m_head] = point;
+    m_head = (m_head + 1) & (m_points.size() - 1);
+    if (m_count < m_points.size()) ++m_count;
+}
+
+void TrailStore::Trail::reallocate(int capacity)
+{
+    // 按时间顺序搬到新缓冲的开头, 容量变小时只保留最新的点
+    int keep = qMin(m_count, capacity);
+    QVector<Point> points(capacity);
+    for (int i = 0; i < keep; ++i)
+        points[i] = at(m_count - keep + i);
+
+    m_points.swap(points);
+    m_count = keep;
+    m_head = keep & (capacity - 1);
+}
+
+TrailStore::TrailStore(qint64 memoryBudget)
+    : m_budget(memoryBudget), m_used(0), m_capacity(MaxCapacity)
+{
+    updateCapacity();
+}
+
+void TrailStore::setMemoryBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(0, bytes);
+    updateCapacity();
+}
+
+void TrailStore::clear()
+{
+    m_trails.clear();
+    m_used = 0;
+    updateCapacity();
+}
+
+void TrailStore::remove(int id)
+{
+    auto it = m_trails.find(id);
+    if (it == m_trails.end()) return;
+
+    m_used -= qint64(it->capacity()) * qint64(sizeof(Point));
+    m_trails.erase(it);
+    updateCapacity();
+}
+
+void TrailStore::append(int id, qint64 ms, const QPointF &pos)
+{
+    auto it = m_trails.find(id);
+    if (it == m_trails.end()) {
+        it = m_trails.insert(id, Trail());
+        updateCapacity();
+    }
+
+    Point point;
+    point.ms = ms;
+    point.x = float(pos.x());
+    point.y = float(pos.y());
+
+    int before = it->capacity();
+    it->append(point, m_capacity);
+    m_used += qint64(it->capacity() - before) * qint64(sizeof(Point));
+}
+
+const TrailStore::Trail *TrailStore::trail(int id) const
+{
+    auto it = m_trails.constFind(id);
+    return it != m_trails.constEnd() ? &it.value() : nullptr;
+}
+
+void TrailStore::updateCapacity()
+{
+    // 平均分给每个标签, 向下取 2 的幂
+    qint64 perTag = m_budget / (qint64(sizeof(Point)) * qMax(1, m_trails.size()));
+    int capacity = MinCapacity;
+    while (capacity < MaxCapacity && qint64(capacity) * 2 <= perTag)
+        capacity *= 2;
+
+    bool shrink = capacity < m_capacity;
+    m_capacity = capacity;
+    if (!shrink) return;
+
+    for (auto it = m_trails.begin(); it != m_trails.end(); ++it) {
+        if (it->capacity() <= m_capacity) continue;
+        m_used -= qint64(it->capacity() - m_capacity) * qint64(sizeof(Point));
+        it->reallocate(m_capacity);
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef TRAILSTORE_H
+#define TRAILSTORE_H
+
+#include <QHash>
+#include <QPointF>
+#include <QPolygonF>
+#include <QVector>
+
+// ==========================================
+// TrailStore: 每个标签最近一段轨迹的环形缓冲 (世界坐标, cm), 总内存有上限
+// 每个标签的容量为 2 的幂, 随写入按需翻倍, 不超过 capacityPerTag();
+// capacityPerTag() 由内存上限与标签数决定, 变小时所有环只保留最新的点。
+// 标签很多时每个标签至少保留 MinCapacity 个点, 此时总量可能略超上限
+// ==========================================
+class TrailStore
+{
+public:
+    struct Point {
+        qint64 ms;          // 时间戳 (调用方时钟, 单调递增)
+        float x;
+        float y;
+    };
+
+    enum {
+        MinCapacity = 16,
+        MaxCapacity = 1 << 16
+    };
+
+    // 单个标签的轨迹, 下标 0 为最旧的点
+    class Trail
+    {
+    public:
+        Trail() : m_head(0), m_count(0) {}
+
+        int size() const { return m_count; }
+        int capacity() const { return m_points.size(); }
+        const Point &at(int i) const { return m_points[(m_head - m_count + i) & (m_points.size() - 1)]; }
+        // 第一个时间不早于 ms 的点的下标, 都早于 ms 时返回 size()
+        int lowerBound(qint64 ms) const;
+
+    private:
+        friend class TrailStore;
+        void append(const Point &point, int maxCapacity);
+        void reallocate(int capacity);
+
+        QVector<Point> m_points;
+        int m_head;         // 下一次写入的位置
+        int m_count;
+    };
+
+    explicit TrailStore(qint64 memoryBudget = 32 * 1024 * 1024);
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const { return m_budget; }
+    qint64 memoryUsed() const { return m_used; }
+    int capacityPerTag() const { return m_capacity; }
+
+    void clear();
+    void remove(int id);
+    void append(int id, qint64 ms, const QPointF &pos);
+    const Trail *trail(int id) const;
+    QList<int> tagIds() const { return m_trails.keys(); }
+
+    // 把 sinceMs 之后的轨迹抽稀成最多 maxPoints 个屏幕点 (旧 -> 新):
+    // 先按步长抽样, 使扫描的点数不超过 4 * maxPoints, 再丢弃与上一个输出点
+    // 相距不足 minStepPx 的点; 最新的点总会保留。toScreen(QPointF) 把世界坐标转为屏幕坐标
+    template <typename ToScreen>
+    static void decimate(const Trail &trail, qint64 sinceMs, ToScreen toScreen,
+                         double minStepPx, int maxPoints, QPolygonF &out);
+
+private:
+    void updateCapacity();
+
+    QHash<int, Trail> m_trails;
+    qint64 m_budget;
+    qint64 m_used;          // 所有环已分配的字节数
+    int m_capacity;
+};
+
+template <typename ToScreen>
+void TrailStore::decimate(const Trail &trail, qint64 sinceMs, ToScreen toScreen,
+                          double minStepPx, int maxPoints, QPolygonF &out)
+{
+    out.clear();
+    if (maxPoints < 2) return;
+
+    int first = trail.lowerBound(sinceMs);
+    int last = trail.size() - 1;
+    int n = last - first + 1;
+    if (n < 2) return;
+
+    int scanBudget = 4 * maxPoints;
+    int stride = (n + scanBudget - 1) / scanBudget;
+
+    QPointF prev = toScreen(QPointF(trail.at(first).x, trail.at(first).y));
+    out.append(prev);
+    for (int i = first + stride; i < last; i += stride) {
+        const Point &p = trail.at(i);
+        QPointF s = toScreen(QPointF(p.x, p.y));
+        if (qAbs(s.x() - prev.x()) + qAbs(s.y() - prev.y()) < minStepPx) continue;
+        out.append(s);
+        prev = s;
+    }
+    out.append(toScreen(QPointF(trail.at(last).x, trail.at(last).y)));
+
+    // 轨迹来回折返时距离过滤留下的点仍可能超出, 再均匀抽取一次
+    if (out.size() > maxPoints) {
+        int size = out.size();
+        for (int i = 0; i < maxPoints - 1; ++i)
+            out[i] = out[int(qint64(i) * (size - 1) / (maxPoints - 1))];
+        out[maxPoints - 1] = out[size - 1];
+        out.resize(maxPoints);
+    }
+}
+
+#endif // TRAILSTORE_H
@@ -0,0 +1,143 @@
+#include "trilateration.h"
+#include <QtMath>
+#include <QtNumeric>
+
+namespace {
+
+// --------------------------------------------------------
+// 定长闭式解: N 在编译期确定, 循环全部展开, 只用栈上数组。
+// 正规方程见 ClosedFormNormal; 参考基站自身那一行恰好为 0,
+// 因此不需要像旧实现那样把它交换到末尾再跳过
+// --------------------------------------------------------
+template<int N, typename Real>
+bool solveClosedForm(const RangeSet &set, double &x, double &y)
+{
+    // 参考基站: 最短的正测距, 写成条件传送避免分支
+    int pivot = 0;
+    double minRange = 999999;
+    for (int i = 0; i < N; ++i) {
+        bool better = set.r[i] < minRange && set.r[i] > 0;
+        minRange = better ? set.r[i] : minRange;
+        pivot = better ? i : pivot;
+    }
+
+    const Real xn = Real(set.x[pivot]), yn = Real(set.y[pivot]), rn = Real(set.r[pivot]);
+    ClosedFormNormal<Real> normal;
+    for (int i = 0; i < N; ++i)
+        normal.add(Real(set.x[i]) - xn, Real(set.y[i]) - yn, rn * rn, Real(set.r[i]));
+
+    Real det = normal.det();
+    if (qAbs(det) < Real(kClosedFormMinDet)) return false;
+
+    x = double(xn + normal.offsetX(det));
+    y = double(yn + normal.offsetY(det));
+    return true;
+}
+
+typedef bool (*ClosedFormFn)(const RangeSet &, double &, double &);
+
+// 按参与基站数量分派, 少于 3 个无解
+const ClosedFormFn kClosedForm[RangeSet::MaxAnchors + 1] = {
+    nullptr, nullptr, nullptr,
+    &solveClosedForm<3, SolverReal>,
+    &solveClosedForm<4, SolverReal>,
+    &solveClosedForm<5, SolverReal>,
+    &solveClosedForm<6, SolverReal>,
+    &solveClosedForm<7, SolverReal>,
+    &solveClosedForm<8, SolverReal>
+};
+
+} // namespace
+
+bool calculatePosition(const RangeSet &set, double &x, double &y)
+{
+    if (uint(set.count) > uint(RangeSet::MaxAnchors)) return false;
+    ClosedFormFn fn = kClosedForm[set.count];
+    return fn && fn(set, x, y);
+}
+
+namespace {
+
+// 计算残差平方和, 以及 J^T J 与 J^T r
+double accumulateNormal(const RangeSet &set, double x, double y,
+                        double &h11, double &h12, double &h22, double &g1, double &g2)
+{
+    double cost = 0;
+    h11 = h12 = h22 = g1 = g2 = 0;
+
+    for (int i = 0; i < set.count; ++i) {
+        double dx = x - set.x[i];
+        double dy = y - set.y[i];
+        double dist = qSqrt(dx * dx + dy * dy);
+        if (dist < 1e-6) dist = 1e-6;
+
+        double res = dist - set.r[i];
+        double jx = dx / dist;
+        double jy = dy / dist;
+
+        h11 += jx * jx;
+        h12 += jx * jy;
+        h22 += jy * jy;
+        g1 += jx * res;
+        g2 += jy * res;
+        cost += res * res;
+    }
+    return cost;
+}
+
+double residualCost(const RangeSet &set, double x, double y)
+{
+    double cost = 0;
+    for (int i = 0; i < set.count; ++i) {
+        double dx = x - set.x[i];
+        double dy = y - set.y[i];
+        double res = qSqrt(dx * dx + dy * dy) - set.r[i];
+        cost += res * res;
+    }
+    return cost;
+}
+
+} // namespace
+
+bool refinePosition(const RangeSet &set, double &x, double &y, int maxIterations, double tolerance, double *rms)
+{
+    if (set.count < 3 || !qIsFinite(x) || !qIsFinite(y)) return false;
+
+    double px = x, py = y;
+    double h11, h12, h22, g1, g2;
+    double cost = accumulateNormal(set, px, py, h11, h12, h22, g1, g2);
+    double lambda = 1e-3;
+
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        // (H + lambda * diag(H)) * delta = -g
+        double a11 = h11 * (1.0 + lambda);
+        double a22 = h22 * (1.0 + lambda);
+        double det = a11 * a22 - h12 * h12;
+        if (qAbs(det) < 1e-12) return false;
+
+        double dx = (-g1 * a22 + g2 * h12) / det;
+        double dy = (-g2 * a11 + g1 * h12) / det;
+
+        double newCost = residualCost(set, px + dx, py + dy);
+        if (newCost < cost) {
+            px += dx;
+            py += dy;
+            lambda = qMax(lambda * 0.3, 1e-9);
+            if (dx * dx + dy * dy < tolerance * tolerance) {
+                cost = newCost;
+                break;
+            }
+            cost = accumulateNormal(set, px, py, h11, h12, h22, g1, g2);
+        } else {
+            // 步长过大, 增加阻尼后重试 (同样计入迭代次数)
+            lambda *= 10.0;
+        }
+    }
+
+    if (!qIsFinite(px) || !qIsFinite(py)) return false;
+
+    x = px;
+    y = py;
+    if (rms) *rms = qSqrt(cost / set.count);
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef TRILATERATION_H
+#define TRILATERATION_H
+
+#include "rangeparser.h"
+
+// ==========================================
+// RangeSet: 一次解算所用的基站坐标与测距 (cm), 定长, 不做堆分配
+// ==========================================
+struct RangeSet {
+    enum { MaxAnchors = RangePacket::MaxSlots };
+
+    int count;
+    int anchorId[MaxAnchors];
+    double x[MaxAnchors];
+    double y[MaxAnchors];
+    double r[MaxAnchors];
+};
+
+// 闭式解内部运算精度, 编译期选择: DEFINES += UWB_SOLVER_FLOAT 使用 float
+#ifdef UWB_SOLVER_FLOAT
+typedef float SolverReal;
+#else
+typedef double SolverReal;
+#endif
+
+enum SolverMode {
+    SolverClosedForm,       // 线性化闭式解
+    SolverGaussNewton,      // 以上一次位置为初值的 Levenberg-Marquardt 迭代
+    SolverRobust            // 枚举基站子集, 剔除不一致的测距 (见 robustsolver.h)
+};
+
+// --------------------------------------------------------
+// 闭式解的线性化正规方程, calculatePosition 与 solveBatch 共用同一形式:
+// 以参考基站 (最短测距) 为原点, 第 i 行 [2dx_i, 2dy_i] p = rn^2 - r_i^2 + dx_i^2 + dy_i^2,
+// 参考基站自身那一行恰好为 0。解出的 p 是相对参考基站的偏移。
+// 向量化实现 (batchsolver.cpp) 按同样的运算顺序逐项展开
+// --------------------------------------------------------
+template<typename Real>
+struct ClosedFormNormal {
+    Real a11, a12, a22, b1, b2;
+
+    ClosedFormNormal() : a11(0), a12(0), a22(0), b1(0), b2(0) {}
+
+    // dx/dy: 基站相对参考基站的坐标, rn2: 参考基站测距的平方, ri: 该基站测距
+    void add(Real dx, Real dy, Real rn2, Real ri)
+    {
+        Real ai0 = 2 * dx;
+        Real ai1 = 2 * dy;
+        Real bi = rn2 - ri * ri + dx * dx + dy * dy;
+
+        a11 += ai0 * ai0;
+        a12 += ai0 * ai1;
+        a22 += ai1 * ai1;
+        b1 += ai0 * bi;
+        b2 += ai1 * bi;
+    }
+
+    Real det() const { return a11 * a22 - a12 * a12; }
+    // 行列式足够大时才有解, 调用方先用 det() 判断
+    Real offsetX(Real d) const { return (a22 * b1 - a12 * b2) / d; }
+    Real offsetY(Real d) const { return (a11 * b2 - a12 * b1) / d; }
+};
+
+// 几何退化 (基站共线等) 判据: |det| 小于该值时无解
+const double kClosedFormMinDet = 1e-4;
+
+// 以最短测距的基站为参考做线性化, 解 2x2 最小二乘正规方程。
+// 按基站数量 (3~8) 分派到编译期展开的实现, 不做堆分配
+bool calculatePosition(const RangeSet &set, double &x, double &y);
+
+// 以 (x, y) 为初值, 用 Levenberg-Marquardt 最小化真实测距残差 sum(|p - a_i| - r_i)^2。
+// 最多 maxIterations 次迭代, 步长小于 tolerance (cm) 时提前结束。
+// 成功时更新 (x, y) 并通过 rms 返回残差均方根 (cm)
+bool refinePosition(const RangeSet &set, double &x, double &y, int maxIterations, double tolerance, double *rms = nullptr);
+
+#endif // TRILATERATION_H
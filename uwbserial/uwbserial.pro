@@ -1,4 +1,4 @@
-QT       += core gui serialport
+QT       += core gui serialport network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -16,11 +16,21 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    feedpublisher.cpp \
+    logmodel.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    positionengine.cpp \
+    seriallistener.cpp
 
 HEADERS += \
-    mainwindow.h
+    feedpublisher.h \
+    logmodel.h \
+    mainwindow.h \
+    positionengine.h \
+    seriallistener.h
+
+include(positioning.pri)
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
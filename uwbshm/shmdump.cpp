@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include "uwbshm.h"
+
+// ==========================================
+// shmdump: 共享内存定位环的示例读端
+//   shmdump [name]            每秒打印所有标签的最新位置
+//   shmdump [name] --events   持续打印新事件
+// ==========================================
+
+namespace {
+
+void sleepMs(int ms)
+{
+    timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = long(ms % 1000) * 1000000L;
+    nanosleep(&ts, nullptr);
+}
+
+void printPosition(const UwbShm::Position &p)
+{
+    printf("%lld tid %u seq %u x %.1f y %.1f v %.1f,%.1f q %u\n",
+           (long long)p.timeUs, p.tid, p.seq, p.x, p.y, p.vx, p.vy, p.quality);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const char *name = UwbShm::DefaultName;
+    bool events = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--events") == 0) events = true;
+        else name = argv[i];
+    }
+
+    UwbShm::Reader reader;
+    uint64_t cursor = 0;
+    uint64_t lost = 0;
+    UwbShm::Position batch[256];
+
+    for (;;) {
+        if (reader.writerClosed()) {
+            reader.close();
+            if (!reader.open(name)) {
+                sleepMs(500);
+                continue;
+            }
+            cursor = reader.eventHead();
+            fprintf(stderr, "opened %s\n", name);
+        }
+
+        if (events) {
+            int n;
+            while ((n = reader.readEvents(cursor, batch, 256, &lost)) > 0) {
+                for (int i = 0; i < n; ++i)
+                    printPosition(batch[i]);
+            }
+            if (lost > 0) {
+                fprintf(stderr, "lost %llu events\n", (unsigned long long)lost);
+                lost = 0;
+            }
+            fflush(stdout);
+            sleepMs(10);
+        } else {
+            int count = reader.forEachTag(printPosition);
+            printf("-- %d tags\n", count);
+            fflush(stdout);
+            sleepMs(1000);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+#ifndef UWBSHM_H
+#define UWBSHM_H
+
+// ==========================================
+// uwbshm: uwbserial 共享内存定位环 (布局定义 + 只读端, 仅头文件, 不依赖 Qt)
+//
+// 同一台机器上的进程映射 uwbserial 创建的 POSIX 共享内存 (默认 "/uwbserial"),
+// 之后读取最新位置不需要任何系统调用或锁:
+//   - 每个标签一个槽, 用 seqlock 保护: 写端更新前后各把 version 加 1,
+//     读端在 version 为偶数且前后一致时才采用读到的数据
+//   - 一个只追加的事件环, 按顺序记录每次定位; 读端自己保存游标,
+//     落后超过环容量时跳到最旧的有效事件并报告丢失数量
+//
+// 布局 (本机字节序, 均为 64 字节对齐):
+//   Header                             256 字节
+//   Slot[slotCount]                    每个 64 字节, 按 tid 哈希 + 线性探测
+//   Position[eventCapacity]            每个 48 字节
+//
+// 只有定位成功 (status 为 0) 的结果写入。写端关闭时置 closed, 读端应重新打开。
+// Windows 下不提供共享内存, Reader::open() 始终返回 false
+// ==========================================
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace UwbShm {
+
+const char Magic[8] = { 'U', 'W', 'B', 'S', 'H', 'M', '0', '1' };
+const uint32_t Version = 1;
+const char DefaultName[] = "/uwbserial";
+
+enum {
+    SlotBits = 12,
+    SlotCount = 1 << SlotBits,
+    EventCapacity = 65536,      // 2 的幂
+    MaxReadRetries = 64         // 写端持续更新同一槽时读端的重试次数
+};
+
+// 一次定位结果 (与 feedformat.h 的记录字段一致, 坐标为 double)
+struct Position {
+    uint32_t tid;
+    uint32_t seq;
+    int64_t timeUs;             // Unix 纪元 (us)
+    double x;                   // 滤波后坐标 (cm)
+    double y;
+    float vx;                   // cm/s
+    float vy;
+    uint8_t status;
+    uint8_t quality;            // 参与解算的基站数
+    uint8_t reserved[6];
+};
+
+struct alignas(64) Slot {
+    std::atomic<uint32_t> version;  // 奇数表示写端正在更新
+    std::atomic<uint32_t> key;      // tid + 1, 0 表示空槽
+    Position position;
+};
+
+struct alignas(64) Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint32_t eventCapacity;
+    uint32_t eventSize;
+    uint64_t slotOffset;
+    uint64_t eventOffset;
+    uint64_t totalSize;
+    std::atomic<uint32_t> ready;    // 布局写完后置 1
+    std::atomic<uint32_t> closed;   // 写端关闭后置 1
+
+    alignas(64) std::atomic<uint64_t> eventHead;    // 已写入的事件总数
+    std::atomic<uint32_t> tagCount;                 // 已占用的槽数
+};
+
+static_assert(sizeof(Position) == 48, "Position layout changed");
+static_assert(sizeof(Slot) == 64, "Slot layout changed");
+static_assert(sizeof(Header) <= 256, "Header layout changed");
+
+const uint64_t HeaderSize = 256;
+const uint64_t SlotOffset = HeaderSize;
+const uint64_t EventOffset = SlotOffset + uint64_t(SlotCount) * sizeof(Slot);
+const uint64_t TotalSize = EventOffset + uint64_t(EventCapacity) * sizeof(Position);
+
+inline uint32_t slotHash(uint32_t tid)
+{
+    return (tid * 2654435761u) >> (32 - SlotBits);
+}
+
+// ==========================================
+// Reader: 只读映射, 供其他进程轮询
+// ==========================================
+class Reader
+{
+public:
+    Reader() : m_base(nullptr), m_header(nullptr), m_slots(nullptr), m_events(nullptr) {}
+    ~Reader() { close(); }
+
+    bool open(const char *name = DefaultName)
+    {
+        close();
+#ifdef _WIN32
+        (void)name;
+        return false;
+#else
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || uint64_t(st.st_size) < TotalSize) {
+            ::close(fd);
+            return false;
+        }
+        void *base = mmap(nullptr, size_t(TotalSize), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) return false;
+
+        const Header *header = static_cast<const Header *>(base);
+        if (header->ready.load(std::memory_order_acquire) != 1
+                || memcmp(header->magic, Magic, sizeof(Magic)) != 0
+                || header->version != Version
+                || header->slotCount != uint32_t(SlotCount)
+                || header->eventCapacity != uint32_t(EventCapacity)) {
+            munmap(base, size_t(TotalSize));
+            return false;
+        }
+
+        m_base = base;
+        m_header = header;
+        m_slots = reinterpret_cast<const Slot *>(static_cast<const char *>(base) + header->slotOffset);
+        m_events = reinterpret_cast<const Position *>(static_cast<const char *>(base) + header->eventOffset);
+        return true;
+#endif
+    }
+
+    void close()
+    {
+#ifndef _WIN32
+        if (m_base) munmap(m_base, size_t(TotalSize));
+#endif
+        m_base = nullptr;
+        m_header = nullptr;
+        m_slots = nullptr;
+        m_events = nullptr;
+    }
+
+    bool isOpen() const { return m_base != nullptr; }
+    // 写端已关闭 (或重启), 需要重新 open()
+    bool writerClosed() const { return !m_header || m_header->closed.load(std::memory_order_acquire) != 0; }
+    int tagCount() const { return m_header ? int(m_header->tagCount.load(std::memory_order_acquire)) : 0; }
+
+    // 标签的最新位置; 标签不存在或一直在被更新时返回 false
+    bool latest(uint32_t tid, Position &position) const
+    {
+        if (!m_slots) return false;
+
+        uint32_t key = tid + 1;
+        uint32_t index = slotHash(tid);
+        for (int probe = 0; probe < SlotCount; ++probe, index = (index + 1) & (SlotCount - 1)) {
+            uint32_t k = m_slots[index].key.load(std::memory_order_acquire);
+            if (k == key) return readSlot(m_slots[index], position);
+            if (k == 0) return false;
+        }
+        return false;
+    }
+
+    // 依次把每个已知标签的最新位置交给 f(const Position &), 返回标签数
+    template <typename F>
+    int forEachTag(F f) const
+    {
+        if (!m_slots) return 0;
+
+        int count = 0;
+        Position position;
+        for (int i = 0; i < SlotCount; ++i) {
+            if (m_slots[i].key.load(std::memory_order_acquire) == 0) continue;
+            if (readSlot(m_slots[i], position)) {
+                f(position);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // 当前事件总数; 新读者以此作为初始游标, 只接收之后的事件
+    uint64_t eventHead() const
+    {
+        return m_header ? m_header->eventHead.load(std::memory_order_acquire) : 0;
+    }
+
+    // 读取游标之后的事件 (最多 max 条) 并推进游标, 返回条数。
+    // 落后超过环容量或读取期间被覆盖的事件计入 lost
+    int readEvents(uint64_t &cursor, Position *out, int max, uint64_t *lost = nullptr) const
+    {
+        if (!m_header || max <= 0) return 0;
+
+        uint64_t head = m_header->eventHead.load(std::memory_order_acquire);
+        if (head - cursor > uint64_t(EventCapacity)) {
+            if (lost) *lost += head - cursor - EventCapacity;
+            cursor = head - EventCapacity;
+        }
+
+        uint64_t end = cursor + uint64_t(max) < head ? cursor + uint64_t(max) : head;
+        int n = int(end - cursor);
+        for (int i = 0; i < n; ++i)
+            memcpy(&out[i], &m_events[(cursor + uint64_t(i)) & (EventCapacity - 1)], sizeof(Position));
+
+        // 复制期间写端可能已绕回覆盖了最前面的几条, 丢弃这些
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = m_header->eventHead.load(std::memory_order_relaxed);
+        uint64_t firstValid = after >= uint64_t(EventCapacity) ? after - EventCapacity + 1 : 0;
+        int skip = cursor < firstValid ? int(firstValid - cursor < uint64_t(n) ? firstValid - cursor : uint64_t(n)) : 0;
+        if (skip > 0) {
+            if (lost) *lost += uint64_t(skip);
+            memmove(out, out + skip, sizeof(Position) * size_t(n - skip));
+            n -= skip;
+        }
+        cursor = end;
+        return n;
+    }
+
+private:
+    static bool readSlot(const Slot &slot, Position &position)
+    {
+        for (int retry = 0; retry < MaxReadRetries; ++retry) {
+            uint32_t before = slot.version.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            memcpy(&position, &slot.position, sizeof(Position));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.version.load(std::memory_order_relaxed) == before)
+                return true;
+        }
+        return false;
+    }
+
+    void *m_base;
+    const Header *m_header;
+    const Slot *m_slots;
+    const Position *m_events;
+};
+
+} // namespace UwbShm
+
+#endif // UWBSHM_H
@@ -0,0 +1,14 @@
+# 共享内存定位环的示例读端; 读端库本身只有 uwbshm.h, 直接包含即可
+TEMPLATE = app
+TARGET = shmdump
+
+CONFIG += c++11 console
+CONFIG -= app_bundle qt
+
+SOURCES += \
+    shmdump.cpp
+
+HEADERS += \
+    uwbshm.h
+
+unix:!macx: LIBS += -lrt
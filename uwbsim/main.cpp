@@ -0,0 +1,624 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QPointF>
+#include <QSettings>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <random>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// ==========================================
+// uwbsim: 合成 AT+RANGE 数据的负载发生器, 不需要硬件即可压测 uwbserial
+//
+// 创建一个伪终端, uwbserial 像串口一样打开其从端 (路径启动时打印, 或用 --link 建固定链接)。
+// N 个标签沿随机/圆周/脚本轨迹在基站布局内运动, 按各自频率上报到最近 8 个基站的测距:
+// 高斯噪声、基站未应答 (-1 槽位)、非视距正偏差、整包丢失 (seq 照常递增)。
+//
+// --truth 把发出的每一行连同真实位置写入 CSV, 同时也是 uwbeval 的数据集格式:
+//   # uwbsim dataset v1
+//   # anchors id:x:y,id:x:y,...
+//   time_ns,tid,seq,x,y,nlos,line
+// time_ns 从 0 开始; x/y 为真实位置 (cm); nlos 为带非视距偏差的槽位掩码 (十六进制, 同 mask);
+// line 为原始一行, 本身含逗号, 总在最后一列
+// ==========================================
+
+namespace {
+
+const int kSlots = 8;
+// 写不进伪终端 (没有读端或读得太慢) 时最多积压的字节数, 超出的行直接丢弃
+const int kMaxPendingBytes = 64 * 1024;
+// 两次发送之间的最短/最长休眠 (us)
+const int kMinSleepUs = 200;
+const int kMaxSleepUs = 10000;
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onSignal(int)
+{
+    g_stop = 1;
+}
+
+struct Anchor {
+    int id;
+    double x;
+    double y;
+};
+
+struct Waypoint {
+    double t;       // s
+    double x;
+    double y;
+};
+
+struct Options {
+    int tags;
+    double rate;            // 每个标签的上报频率 (Hz)
+    QString trajectory;     // random / circle
+    double speed;           // cm/s
+    double noise;           // 测距噪声标准差 (cm)
+    double dropout;         // 单个基站未应答的概率
+    double loss;            // 整包丢失的概率
+    double nlos;            // 单个测距带非视距偏差的概率
+    double nlosBias;        // 非视距偏差的均值 (cm, 指数分布)
+    double maxRange;        // 超出该距离的基站不应答, 0 表示不限
+    bool mask;              // 是否携带 mask 字段
+};
+
+struct Tag {
+    double x, y;
+    double vx, vy;
+    double radius, phase, omega;    // 圆周轨迹
+    QVector<Waypoint> script;       // 非空时按脚本运动, 循环播放
+    int seq;
+};
+
+struct Field {
+    double minX, minY, maxX, maxY;
+};
+
+// 默认基站布局: 20m x 15m 场地四周 8 个基站 (cm), 与 uwbbench 相同
+QVector<Anchor> defaultAnchors()
+{
+    return {
+        { 0, 0, 0 }, { 1, 1000, 0 }, { 2, 2000, 0 }, { 3, 2000, 750 },
+        { 4, 2000, 1500 }, { 5, 1000, 1500 }, { 6, 0, 1500 }, { 7, 0, 750 }
+    };
+}
+
+// "id:x:y,id:x:y,..." 形式的基站布局
+bool parseAnchors(const QString &spec, QVector<Anchor> &anchors)
+{
+    anchors.clear();
+    for (const QString &item : spec.split(',', QString::SkipEmptyParts)) {
+        QStringList f = item.split(':');
+        if (f.size() != 3) return false;
+        anchors.append({ f[0].toInt(), f[1].toDouble(), f[2].toDouble() });
+    }
+    return anchors.size() >= 3;
+}
+
+// uwbserial 保存的基站表
+bool loadSettingsAnchors(QVector<Anchor> &anchors)
+{
+    QSettings settings("Makerfabs", "UWB_Qt_Cpp");
+    anchors.clear();
+    int count = settings.beginReadArray("Anchors");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        anchors.append({ settings.value("id").toInt(), settings.value("x").toDouble(), settings.value("y").toDouble() });
+    }
+    settings.endArray();
+    return anchors.size() >= 3;
+}
+
+// 每行 "tid,t,x,y" (t 为秒, x/y 为 cm), # 开头为注释; 各标签按时间插值, 播完从头循环
+bool loadScript(const QString &path, QHash<int, QVector<Waypoint>> &scripts)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        printf("cannot open script %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+
+    int lineNo = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        QList<QByteArray> f = line.split(',');
+        if (f.size() != 4) {
+            printf("%s:%d: expected tid,t,x,y\n", qPrintable(path), lineNo);
+            return false;
+        }
+        scripts[f[0].toInt()].append({ f[1].toDouble(), f[2].toDouble(), f[3].toDouble() });
+    }
+    for (auto it = scripts.begin(); it != scripts.end(); ++it) {
+        std::stable_sort(it->begin(), it->end(), [](const Waypoint &a, const Waypoint &b){ return a.t < b.t; });
+    }
+    return true;
+}
+
+QPointF scriptPosition(const QVector<Waypoint> &script, double t)
+{
+    double period = script.last().t;
+    if (script.size() == 1 || period <= 0) return QPointF(script.first().x, script.first().y);
+
+    t = std::fmod(t, period);
+    int i = 1;
+    while (i < script.size() - 1 && script[i].t < t) ++i;
+    const Waypoint &a = script[i - 1];
+    const Waypoint &b = script[i];
+    double f = b.t > a.t ? qBound(0.0, (t - a.t) / (b.t - a.t), 1.0) : 1.0;
+    return QPointF(a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f);
+}
+
+class Generator
+{
+public:
+    Generator(const Options &options, const QVector<Anchor> &anchors,
+              const QHash<int, QVector<Waypoint>> &scripts, quint32 seed)
+        : m_options(options), m_anchors(anchors), m_rng(seed)
+    {
+        m_field = { anchors[0].x, anchors[0].y, anchors[0].x, anchors[0].y };
+        for (const Anchor &a : anchors) {
+            m_field.minX = qMin(m_field.minX, a.x); m_field.maxX = qMax(m_field.maxX, a.x);
+            m_field.minY = qMin(m_field.minY, a.y); m_field.maxY = qMax(m_field.maxY, a.y);
+        }
+
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double cx = (m_field.minX + m_field.maxX) / 2;
+        double cy = (m_field.minY + m_field.maxY) / 2;
+        double half = qMin(m_field.maxX - m_field.minX, m_field.maxY - m_field.minY) / 2;
+
+        m_tags.resize(options.tags);
+        for (int tid = 0; tid < options.tags; ++tid) {
+            Tag &tag = m_tags[tid];
+            tag.seq = int(m_rng() & 0xff);
+            tag.script = scripts.value(tid);
+
+            // 随机游走: 随机起点与方向, 速度为 speed 的 30%~100%
+            tag.x = m_field.minX + unit(m_rng) * (m_field.maxX - m_field.minX);
+            tag.y = m_field.minY + unit(m_rng) * (m_field.maxY - m_field.minY);
+            double heading = unit(m_rng) * 2 * M_PI;
+            double speed = options.speed * (0.3 + 0.7 * unit(m_rng));
+            tag.vx = speed * qCos(heading);
+            tag.vy = speed * qSin(heading);
+
+            // 圆周: 各标签半径错开, 线速度为 speed
+            tag.radius = qMax(1.0, half * (0.2 + 0.7 * (tid + 0.5) / options.tags));
+            tag.phase = 2 * M_PI * tid / options.tags;
+            tag.omega = options.speed / tag.radius;
+            if (tag.script.isEmpty() && options.trajectory == "circle") {
+                tag.x = cx + tag.radius * qCos(tag.phase);
+                tag.y = cy + tag.radius * qSin(tag.phase);
+            }
+        }
+    }
+
+    int tagCount() const { return m_tags.size(); }
+
+    // 生成标签 tid 在 t 秒的一包, 追加到 out (含 \r\n); 模拟整包丢失时返回 false, seq 照常递增
+    bool makeLine(int tid, double t, QByteArray &out, QPointF &truth, quint32 &nlosMask)
+    {
+        Tag &tag = m_tags[tid];
+        move(tag, t);
+        truth = QPointF(tag.x, tag.y);
+        tag.seq = (tag.seq + 1) & 0xff;
+
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        if (unit(m_rng) < m_options.loss) return false;
+
+        // 最近的至多 8 个基站按 ID 顺序占用槽位
+        m_order.resize(m_anchors.size());
+        for (int i = 0; i < m_anchors.size(); ++i) m_order[i] = i;
+        int used = qMin(kSlots, m_anchors.size());
+        std::partial_sort(m_order.begin(), m_order.begin() + used, m_order.end(), [&](int a, int b){
+            return distance(tag, m_anchors[a]) < distance(tag, m_anchors[b]);
+        });
+        std::sort(m_order.begin(), m_order.begin() + used, [&](int a, int b){
+            return m_anchors[a].id < m_anchors[b].id;
+        });
+
+        int ranges[kSlots];
+        int ancids[kSlots];
+        quint32 mask = 0;
+        nlosMask = 0;
+        std::normal_distribution<double> noise(0.0, m_options.noise);
+        std::exponential_distribution<double> bias(1.0 / qMax(1.0, m_options.nlosBias));
+        for (int slot = 0; slot < kSlots; ++slot) {
+            ranges[slot] = 0;
+            ancids[slot] = -1;
+            if (slot >= used) continue;
+
+            const Anchor &anchor = m_anchors[m_order[slot]];
+            double d = distance(tag, anchor);
+            if (m_options.maxRange > 0 && d > m_options.maxRange) continue;
+            if (unit(m_rng) < m_options.dropout) continue;
+
+            double r = d + (m_options.noise > 0 ? noise(m_rng) : 0.0);
+            if (unit(m_rng) < m_options.nlos) {
+                r += bias(m_rng);
+                nlosMask |= 1u << slot;
+            }
+            ranges[slot] = qMax(1, qRound(r));
+            ancids[slot] = anchor.id;
+            mask |= 1u << slot;
+        }
+
+        out += "AT+RANGE=tid:";
+        out += QByteArray::number(tid);
+        if (m_options.mask) {
+            out += ",mask:";
+            out += QByteArray::number(mask, 16);
+        }
+        out += ",seq:";
+        out += QByteArray::number(tag.seq);
+        out += ",range:(";
+        for (int slot = 0; slot < kSlots; ++slot) {
+            if (slot) out += ',';
+            out += QByteArray::number(ranges[slot]);
+        }
+        out += "),ancid:(";
+        for (int slot = 0; slot < kSlots; ++slot) {
+            if (slot) out += ',';
+            out += QByteArray::number(ancids[slot]);
+        }
+        out += ")\r\n";
+        return true;
+    }
+
+    int seq(int tid) const { return m_tags[tid].seq; }
+
+private:
+    static double distance(const Tag &tag, const Anchor &anchor)
+    {
+        double dx = tag.x - anchor.x;
+        double dy = tag.y - anchor.y;
+        return qSqrt(dx * dx + dy * dy);
+    }
+
+    void move(Tag &tag, double t)
+    {
+        if (!tag.script.isEmpty()) {
+            QPointF p = scriptPosition(tag.script, t);
+            tag.x = p.x();
+            tag.y = p.y();
+            return;
+        }
+
+        if (m_options.trajectory == "circle") {
+            double cx = (m_field.minX + m_field.maxX) / 2;
+            double cy = (m_field.minY + m_field.maxY) / 2;
+            double a = tag.phase + tag.omega * t;
+            tag.x = cx + tag.radius * qCos(a);
+            tag.y = cy + tag.radius * qSin(a);
+            return;
+        }
+
+        // 随机游走: 每包之间匀速, 方向缓慢随机转动, 碰到场地边界反弹
+        double dt = 1.0 / m_options.rate;
+        std::normal_distribution<double> turn(0.0, 0.5 * qSqrt(dt));
+        double a = turn(m_rng);
+        double vx = tag.vx * qCos(a) - tag.vy * qSin(a);
+        double vy = tag.vx * qSin(a) + tag.vy * qCos(a);
+        tag.vx = vx;
+        tag.vy = vy;
+        tag.x += tag.vx * dt;
+        tag.y += tag.vy * dt;
+        if (tag.x < m_field.minX || tag.x > m_field.maxX) { tag.vx = -tag.vx; tag.x = qBound(m_field.minX, tag.x, m_field.maxX); }
+        if (tag.y < m_field.minY || tag.y > m_field.maxY) { tag.vy = -tag.vy; tag.y = qBound(m_field.minY, tag.y, m_field.maxY); }
+    }
+
+    Options m_options;
+    QVector<Anchor> m_anchors;
+    Field m_field;
+    QVector<Tag> m_tags;
+    QVector<int> m_order;
+    std::mt19937 m_rng;
+};
+
+// 真实位置与原始行, 每行一条 (见文件头注释)
+class TruthWriter
+{
+public:
+    bool open(const QString &path, const QVector<Anchor> &anchors)
+    {
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            printf("cannot open %s: %s\n", qPrintable(path), qPrintable(m_file.errorString()));
+            return false;
+        }
+        QByteArray spec;
+        for (const Anchor &a : anchors) {
+            if (!spec.isEmpty()) spec += ',';
+            spec += QByteArray::number(a.id) + ':' + QByteArray::number(a.x) + ':' + QByteArray::number(a.y);
+        }
+        m_file.write("# uwbsim dataset v1\n# anchors " + spec + "\ntime_ns,tid,seq,x,y,nlos,line\n");
+        return true;
+    }
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // line 含结尾的 \r\n
+    void append(qint64 timeNs, int tid, int seq, const QPointF &pos, quint32 nlosMask, const char *line, int len)
+    {
+        char head[128];
+        int n = snprintf(head, sizeof(head), "%lld,%d,%d,%.1f,%.1f,%x,",
+                         (long long)timeNs, tid, seq, pos.x(), pos.y(), nlosMask);
+        m_file.write(head, n);
+        m_file.write(line, len - 2);
+        m_file.write("\n", 1);
+    }
+
+    void close() { m_file.close(); }
+
+private:
+    QFile m_file;
+};
+
+struct Counters {
+    qint64 lines;       // 写入伪终端 (或数据集) 的行
+    qint64 bytes;
+    qint64 lost;        // 模拟的整包丢失
+    qint64 overflow;    // 读端跟不上, 积压超出上限而丢弃的行
+};
+
+#ifdef Q_OS_UNIX
+// 打开伪终端主端 (非阻塞), 并以原始模式打开一次从端。
+// 从端一直保持打开: 读端 (uwbserial) 断开重连时主端不会收到挂断, 终端设置也不会被重置
+bool openPty(int &master, int &slave, QByteArray &slavePath)
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0) {
+        printf("posix_openpt: %s\n", strerror(errno));
+        return false;
+    }
+    if (grantpt(master) != 0 || unlockpt(master) != 0) {
+        printf("grantpt/unlockpt: %s\n", strerror(errno));
+        close(master);
+        return false;
+    }
+    slavePath = ptsname(master);
+
+    slave = open(slavePath.constData(), O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        printf("open %s: %s\n", slavePath.constData(), strerror(errno));
+        close(master);
+        return false;
+    }
+    struct termios tio;
+    if (tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("uwbsim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Synthetic AT+RANGE load generator on a pseudo-terminal.");
+    parser.addHelpOption();
+    QCommandLineOption optTags("tags", "Number of tags.", "n", "8");
+    QCommandLineOption optRate("rate", "Report rate per tag (Hz).", "hz", "10");
+    QCommandLineOption optAnchors("anchors", "Anchor layout as id:x:y,... in cm.", "spec");
+    QCommandLineOption optSettings("settings", "Use the anchor table saved by uwbserial.");
+    QCommandLineOption optTrajectory("trajectory", "Tag motion: random or circle.", "kind", "random");
+    QCommandLineOption optScript("script", "Waypoint file with tid,t,x,y lines; scripted tags loop their path.", "file");
+    QCommandLineOption optSpeed("speed", "Tag speed (cm/s).", "cm", "150");
+    QCommandLineOption optNoise("noise", "Range noise standard deviation (cm).", "cm", "10");
+    QCommandLineOption optDropout("dropout", "Probability that an anchor does not answer (-1 slot).", "p", "0.05");
+    QCommandLineOption optLoss("loss", "Probability that a whole packet is lost (seq still advances).", "p", "0.01");
+    QCommandLineOption optNlos("nlos", "Probability that a range carries an NLOS bias.", "p", "0.05");
+    QCommandLineOption optNlosBias("nlos-bias", "Mean NLOS bias (cm, exponential).", "cm", "80");
+    QCommandLineOption optMaxRange("max-range", "Anchors beyond this distance do not answer (cm, 0 = unlimited).", "cm", "0");
+    QCommandLineOption optNoMask("no-mask", "Omit the mask field so the parser has to skip -1 slots itself.");
+    QCommandLineOption optSeed("seed", "Random seed.", "n", "1");
+    QCommandLineOption optDuration("duration", "Stop after this many seconds (0 = until interrupted).", "s", "0");
+    QCommandLineOption optTruth("truth", "Write ground truth and the emitted lines to this CSV (uwbeval dataset).", "file");
+    QCommandLineOption optLink("link", "Create a symlink to the pty slave, e.g. /tmp/ttyUWB0.", "path");
+    QCommandLineOption optOffline("offline", "Do not open a pty; write --duration seconds to --truth as fast as possible.");
+    parser.addOption(optTags);
+    parser.addOption(optRate);
+    parser.addOption(optAnchors);
+    parser.addOption(optSettings);
+    parser.addOption(optTrajectory);
+    parser.addOption(optScript);
+    parser.addOption(optSpeed);
+    parser.addOption(optNoise);
+    parser.addOption(optDropout);
+    parser.addOption(optLoss);
+    parser.addOption(optNlos);
+    parser.addOption(optNlosBias);
+    parser.addOption(optMaxRange);
+    parser.addOption(optNoMask);
+    parser.addOption(optSeed);
+    parser.addOption(optDuration);
+    parser.addOption(optTruth);
+    parser.addOption(optLink);
+    parser.addOption(optOffline);
+    parser.process(app);
+
+    Options options;
+    options.tags = qMax(1, parser.value(optTags).toInt());
+    options.rate = qMax(0.01, parser.value(optRate).toDouble());
+    options.trajectory = parser.value(optTrajectory);
+    options.speed = qMax(0.0, parser.value(optSpeed).toDouble());
+    options.noise = qMax(0.0, parser.value(optNoise).toDouble());
+    options.dropout = qBound(0.0, parser.value(optDropout).toDouble(), 1.0);
+    options.loss = qBound(0.0, parser.value(optLoss).toDouble(), 1.0);
+    options.nlos = qBound(0.0, parser.value(optNlos).toDouble(), 1.0);
+    options.nlosBias = qMax(0.0, parser.value(optNlosBias).toDouble());
+    options.maxRange = qMax(0.0, parser.value(optMaxRange).toDouble());
+    options.mask = !parser.isSet(optNoMask);
+    if (options.trajectory != "random" && options.trajectory != "circle") {
+        printf("unknown --trajectory %s, expected random or circle\n", qPrintable(options.trajectory));
+        return 1;
+    }
+
+    QVector<Anchor> anchors = defaultAnchors();
+    if (parser.isSet(optAnchors) && !parseAnchors(parser.value(optAnchors), anchors)) {
+        printf("invalid --anchors, expected at least 3 id:x:y entries\n");
+        return 1;
+    }
+    if (parser.isSet(optSettings) && !loadSettingsAnchors(anchors)) {
+        printf("uwbserial settings contain fewer than 3 anchors\n");
+        return 1;
+    }
+
+    QHash<int, QVector<Waypoint>> scripts;
+    if (parser.isSet(optScript) && !loadScript(parser.value(optScript), scripts)) return 1;
+
+    double duration = qMax(0.0, parser.value(optDuration).toDouble());
+    bool offline = parser.isSet(optOffline);
+    if (offline && (duration <= 0 || !parser.isSet(optTruth))) {
+        printf("--offline needs --duration and --truth\n");
+        return 1;
+    }
+
+    TruthWriter truth;
+    if (parser.isSet(optTruth) && !truth.open(parser.value(optTruth), anchors)) return 1;
+
+    Generator generator(options, anchors, scripts, quint32(parser.value(optSeed).toUInt()));
+
+    // 所有标签的第 g 包: 标签 g % N, 时间 g / (N * rate), 各标签在一个周期内均匀错开
+    const double totalRate = options.tags * options.rate;
+    auto lineTimeNs = [&](qint64 g) { return qint64(double(g) * 1e9 / totalRate); };
+    const qint64 endNs = qint64(duration * 1e9);
+
+    Counters counters = { 0, 0, 0, 0 };
+    QByteArray line;
+    line.reserve(256);
+
+    if (offline) {
+        for (qint64 g = 0; lineTimeNs(g) < endNs; ++g) {
+            int tid = int(g % options.tags);
+            qint64 timeNs = lineTimeNs(g);
+            QPointF pos;
+            quint32 nlosMask;
+            line.clear();
+            if (!generator.makeLine(tid, timeNs / 1e9, line, pos, nlosMask)) {
+                ++counters.lost;
+                continue;
+            }
+            truth.append(timeNs, tid, generator.seq(tid), pos, nlosMask, line.constData(), line.size());
+            ++counters.lines;
+            counters.bytes += line.size();
+        }
+        truth.close();
+        printf("%lld lines (%lld bytes), %lld lost packets, %d tags x %.1f Hz over %.1f s\n",
+               counters.lines, counters.bytes, counters.lost, options.tags, options.rate, duration);
+        return 0;
+    }
+
+#ifdef Q_OS_UNIX
+    int master = -1, slave = -1;
+    QByteArray slavePath;
+    if (!openPty(master, slave, slavePath)) return 1;
+
+    QByteArray linkPath = QFile::encodeName(parser.value(optLink));
+    if (!linkPath.isEmpty()) {
+        unlink(linkPath.constData());
+        if (symlink(slavePath.constData(), linkPath.constData()) != 0) {
+            printf("symlink %s: %s\n", linkPath.constData(), strerror(errno));
+            linkPath.clear();
+        }
+    }
+    printf("pty %s%s%s: %d tags x %.1f Hz = %.0f lines/s\n", slavePath.constData(),
+           linkPath.isEmpty() ? "" : " -> ", linkPath.constData(), options.tags, options.rate, totalRate);
+    fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    QByteArray pending;
+    pending.reserve(kMaxPendingBytes + 256);
+    QElapsedTimer clock;
+    clock.start();
+    qint64 g = 0;
+    qint64 nextReportNs = 1000000000LL;
+    Counters last = counters;
+
+    while (!g_stop) {
+        qint64 nowNs = clock.nsecsElapsed();
+        if (endNs > 0 && nowNs >= endNs) break;
+
+        // 补发到当前时刻为止应发出的所有行, 一次写入
+        for (; lineTimeNs(g) <= nowNs; ++g) {
+            int tid = int(g % options.tags);
+            QPointF pos;
+            quint32 nlosMask;
+            line.clear();
+            if (!generator.makeLine(tid, lineTimeNs(g) / 1e9, line, pos, nlosMask)) {
+                ++counters.lost;
+                continue;
+            }
+            if (pending.size() + line.size() > kMaxPendingBytes) {
+                ++counters.overflow;
+                continue;
+            }
+            pending += line;
+            if (truth.isOpen())
+                truth.append(lineTimeNs(g), tid, generator.seq(tid), pos, nlosMask, line.constData(), line.size());
+            ++counters.lines;
+            counters.bytes += line.size();
+        }
+
+        if (!pending.isEmpty()) {
+            ssize_t n = write(master, pending.constData(), size_t(pending.size()));
+            if (n > 0) {
+                pending.remove(0, int(n));
+            } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                printf("write: %s\n", strerror(errno));
+                break;
+            }
+        }
+
+        if (nowNs >= nextReportNs) {
+            printf("%lld lines/s  %.1f KB/s  lost %lld  overflow %lld  backlog %d bytes\n",
+                   counters.lines - last.lines, (counters.bytes - last.bytes) / 1024.0,
+                   counters.lost - last.lost, counters.overflow - last.overflow, pending.size());
+            fflush(stdout);
+            last = counters;
+            nextReportNs += 1000000000LL;
+        }
+
+        // 睡到下一行的时间; 高频率时至少睡 kMinSleepUs, 多行合并为一次写入
+        qint64 waitUs = (lineTimeNs(g) - clock.nsecsElapsed()) / 1000;
+        QThread::usleep(ulong(qBound<qint64>(kMinSleepUs, waitUs, kMaxSleepUs)));
+    }
+
+    truth.close();
+    if (!linkPath.isEmpty()) unlink(linkPath.constData());
+    close(slave);
+    close(master);
+    printf("%lld lines, %lld lost packets, %lld overflow\n", counters.lines, counters.lost, counters.overflow);
+    return 0;
+#else
+    printf("no pseudo-terminal on this platform; use --offline\n");
+    return 1;
+#endif
+}
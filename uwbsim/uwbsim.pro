@@ -0,0 +1,11 @@
+# 合成 AT+RANGE 数据的负载发生器; 伪终端只在 unix 上可用, 其他平台只能离线生成数据集
+QT -= gui
+QT += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp